@@ -10,17 +10,57 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <vector>
 #include <algorithm>
 #include <string>
+#include <utility>
 #include <unordered_map>
 #include <unordered_set>
 #include <stack>
+#include <deque>
 #include <stdexcept>
 #include <memory>
 #include <iomanip>
 #include <chrono>
 #include <thread>
+#include <atomic>
+#include <array>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <functional>
+#include <bitset>
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <condition_variable>
+#include <filesystem>
+#include <new>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// Compressed catalog input needs the matching library at link time: build
+// with -DENHANCEMENT_TWO_GZIP and -lz, or -DENHANCEMENT_TWO_ZSTD and -lzstd
+#ifdef ENHANCEMENT_TWO_GZIP
+#include <zlib.h>
+#endif
+#ifdef ENHANCEMENT_TWO_ZSTD
+#include <zstd.h>
+#endif
+
+// SSE2 is used for the 16-way child search of the radix tree index
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COURSE_ART_SSE2
+#include <emmintrin.h>
+#endif
 
 using namespace std;
 using namespace std::chrono;
@@ -31,9 +71,14 @@ using namespace std::this_thread;
 // These functions provide consistent formatting throughout the application
 //============================================================================
 
+// Returns a line of specified characters with proper indentation
+string lineText(char symbol = '=', int length = 78) {
+    return "  " + string(length, symbol) + "\n";
+}
+
 // Prints a line of specified characters with proper indentation
 void printLine(char symbol = '=', int length = 78) {
-    cout << "  " << string(length, symbol) << endl;
+    cout << lineText(symbol, length) << flush;
 }
 
 // Prints a menu separator line with consistent formatting
@@ -58,10 +103,14 @@ void printHeader() {
     printMainMenuLine();
 }
 
+// Returns a section header with consistent formatting
+string subHeaderText(const string& text) {
+    return "\n  " + text + "\n" + lineText('-', 58);
+}
+
 // Prints section headers with consistent formatting
 void printSubHeader(const string& text) {
-    cout << "\n  " << text << endl;
-    cout << "  " << string(58, '-') << endl;
+    cout << subHeaderText(text) << flush;
 }
 
 // Print functions for different types of messages with consistent formatting
@@ -69,9 +118,12 @@ void printSuccess(const string& message) {
     cout << "\n  [SUCCESS] " << message << "\n" << endl;
 }
 
+// Errors are written at once, as a failed search prints nothing else
 void printError(const string& message) {
-    cout << "\n  [ERROR] " << message << "\n" << endl;
-    printLine();
+    static const string line = lineText();
+    thread_local string text;
+    text.assign("\n  [ERROR] ").append(message).append("\n\n").append(line);
+    cout << text << flush;
 }
 
 void printWarning(const string& message) {
@@ -81,487 +133,6223 @@ void printWarning(const string& message) {
 // Displays the main menu with all available options
 void displayMainMenu() {
     printHeader();
-    cout << "    1. Import Course Data          - Load course information from a file" << endl;
+    cout << "    1. Import Course Data          - Load a catalog file, directory or pattern" << endl;
     cout << "    2. Display All Courses         - View complete course catalog" << endl;
     cout << "    3. Search Course Details       - Find specific course information" << endl;
     cout << "    4. View Prerequisite Path      - See required course sequence" << endl;
     cout << "    5. Check Prerequisites         - Validate prerequisite requirements" << endl;
+    cout << "    6. Usage Report                - Show memory use and query latency" << endl;
+    cout << "    7. Select Catalog              - Switch between hosted catalogs" << endl;
+    cout << "    8. Transfer Plan               - Plan a course using transfer credit" << endl;
     cout << "    9. Exit Program                - Close the application" << endl;
     printMainMenuLine();
     printMenuPrompt();
 }
 
+//============================================================================
+// Small vector
+// Sequence container that keeps up to N elements inside the object and moves
+// them to a single heap block only when it grows past N. Most courses have
+// at most two prerequisites, so their lists never allocate
+//============================================================================
+
+template <typename T, size_t N>
+class SmallVector {
+private:
+    uint32_t count = 0;
+    uint32_t capacity_ = N;               // Greater than N once spilled
+    union {
+        T* heap;
+        alignas(T) unsigned char inlineStorage[N * sizeof(T)];
+    };
+
+    bool spilled() const { return capacity_ > N; }
+
+    // Moves the elements into a heap block of the given capacity
+    void grow(size_t newCapacity) {
+        T* block = static_cast<T*>(::operator new(newCapacity * sizeof(T)));
+        T* old = data();
+        for (uint32_t i = 0; i < count; ++i) {
+            new (block + i) T(move(old[i]));
+            old[i].~T();
+        }
+        if (spilled()) ::operator delete(heap);
+        heap = block;
+        capacity_ = static_cast<uint32_t>(newCapacity);
+    }
+
+    void release() {
+        clear();
+        if (spilled()) ::operator delete(heap);
+        capacity_ = N;
+    }
+
+    // A spilled list hands over its block; an inline one moves element-wise
+    void takeFrom(SmallVector& other) {
+        if (other.spilled()) {
+            heap = other.heap;
+            count = other.count;
+            capacity_ = other.capacity_;
+            other.count = 0;
+            other.capacity_ = N;
+        }
+        else {
+            for (T& item : other) push_back(move(item));
+            other.clear();
+        }
+    }
+
+public:
+    typedef T value_type;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+
+    SmallVector() {}
+
+    SmallVector(const SmallVector& other) {
+        reserve(other.size());
+        for (const T& item : other) push_back(item);
+    }
+
+    SmallVector(SmallVector&& other) noexcept {
+        takeFrom(other);
+    }
+
+    SmallVector& operator=(const SmallVector& other) {
+        if (this != &other) {
+            clear();
+            reserve(other.size());
+            for (const T& item : other) push_back(item);
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other) noexcept {
+        if (this != &other) {
+            release();
+            takeFrom(other);
+        }
+        return *this;
+    }
+
+    ~SmallVector() { release(); }
+
+    T* data() { return spilled() ? heap : reinterpret_cast<T*>(inlineStorage); }
+    const T* data() const { return spilled() ? heap : reinterpret_cast<const T*>(inlineStorage); }
+
+    iterator begin() { return data(); }
+    iterator end() { return data() + count; }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + count; }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t capacity() const { return capacity_; }
+
+    // Bytes held outside the object, zero while the elements are inline
+    size_t heapBytes() const { return spilled() ? capacity_ * sizeof(T) : 0; }
+
+    T& operator[](size_t index) { return data()[index]; }
+    const T& operator[](size_t index) const { return data()[index]; }
+    T& front() { return data()[0]; }
+    const T& front() const { return data()[0]; }
+    T& back() { return data()[count - 1]; }
+    const T& back() const { return data()[count - 1]; }
+
+    void reserve(size_t newCapacity) {
+        if (newCapacity > capacity_) grow(newCapacity);
+    }
+
+    // The new element is built before growing, since the arguments may
+    // refer to an element that growing would move
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (count == capacity_) {
+            T item(forward<Args>(args)...);
+            grow(2 * capacity_);
+            return *new (data() + count++) T(move(item));
+        }
+        return *new (data() + count++) T(forward<Args>(args)...);
+    }
+
+    void push_back(const T& item) { emplace_back(item); }
+    void push_back(T&& item) { emplace_back(move(item)); }
+
+    iterator erase(const_iterator first, const_iterator last) {
+        T* target = data() + (first - data());
+        T* source = data() + (last - data());
+        if (target == source) return target;    // Avoids moving elements onto themselves
+        T* finish = end();
+        T* position = move(source, finish, target);
+        for (T* item = position; item != finish; ++item) item->~T();
+        count -= static_cast<uint32_t>(finish - position);
+        return target;
+    }
+
+    iterator erase(const_iterator position) { return erase(position, position + 1); }
+
+    void clear() {
+        for (T& item : *this) item.~T();
+        count = 0;
+    }
+
+    bool operator==(const SmallVector& other) const {
+        return count == other.count && equal(begin(), end(), other.begin());
+    }
+    bool operator!=(const SmallVector& other) const { return !(*this == other); }
+};
+
+// Course ID lists: prerequisites of a course and courses that depend on it
+typedef SmallVector<string, 2> CourseIdList;
+
+//============================================================================
+// Course titles
+// Titles are not copied out of the input they were loaded from: each one is
+// a view into the catalog file, mapped read-only, or into the block of input
+// read into memory, and keeps that text alive. Text is copied only when a
+// title is displayed or written. A mapped catalog file must be replaced by
+// renaming a new file over it, not rewritten in place, while it is loaded
+//============================================================================
+
+// Text that titles point into: a read-only file mapping or an owned buffer
+class SourceText {
+private:
+    string buffer;                    // Owned text; empty for a mapping
+    const char* mapping = nullptr;
+    size_t mappedBytes = 0;
+
+public:
+    SourceText() = default;
+    explicit SourceText(string text) : buffer(move(text)) {}
+    ~SourceText();
+
+    SourceText(const SourceText&) = delete;
+    SourceText& operator=(const SourceText&) = delete;
+
+    static shared_ptr<const SourceText> Map(const string& path);
+
+    string_view Text() const { return mapping ? string_view(mapping, mappedBytes) : string_view(buffer); }
+    bool IsMapped() const { return mapping != nullptr; }
+    size_t HeapBytes() const;
+};
+
+SourceText::~SourceText() {
+#ifndef _WIN32
+    if (mapping) {
+        munmap(const_cast<char*>(mapping), mappedBytes);
+    }
+#endif
+}
+
+// Maps a regular, non-empty file read-only; returns null where the file
+// cannot be mapped, and callers read it through a stream instead. The pages
+// are read from the file on demand: if the file is truncated while mapped,
+// reading a title past the new end raises SIGBUS and ends the process, and a
+// rewrite in place changes the titles. MAP_PRIVATE does not protect against
+// either, so a mapped file may only be replaced by renaming a new file over it
+shared_ptr<const SourceText> SourceText::Map(const string& path) {
+#ifdef _WIN32
+    (void)path;
+    return nullptr;
+#else
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) return nullptr;
+
+    struct stat status;
+    void* mapped = MAP_FAILED;
+    size_t bytes = 0;
+    if (fstat(descriptor, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0) {
+        bytes = static_cast<size_t>(status.st_size);
+        mapped = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    }
+
+    // The mapping stays valid once the descriptor is closed
+    close(descriptor);
+    if (mapped == MAP_FAILED) return nullptr;
+
+    auto source = make_shared<SourceText>();
+    source->mapping = static_cast<const char*>(mapped);
+    source->mappedBytes = bytes;
+    return source;
+#endif
+}
+
+// A course title. Titles built from strings own a source of their own
+class CourseTitle {
+private:
+    shared_ptr<const SourceText> source;
+    string_view text;
+
+public:
+    CourseTitle() = default;
+    explicit CourseTitle(string title) :
+        source(title.empty() ? nullptr : make_shared<const SourceText>(move(title))),
+        text(source ? source->Text() : string_view()) {}
+    CourseTitle(shared_ptr<const SourceText> owner, string_view title) :
+        source(move(owner)),
+        text(title) {}
+
+    string_view view() const { return text; }
+    string str() const { return string(text); }
+    size_t size() const { return text.size(); }
+    bool empty() const { return text.empty(); }
+    const SourceText* owner() const { return source.get(); }
+};
+
+inline bool operator==(const CourseTitle& a, const CourseTitle& b) { return a.view() == b.view(); }
+inline bool operator!=(const CourseTitle& a, const CourseTitle& b) { return a.view() != b.view(); }
+inline bool operator==(const CourseTitle& a, string_view b) { return a.view() == b; }
+inline bool operator!=(const CourseTitle& a, string_view b) { return a.view() != b; }
+
+inline ostream& operator<<(ostream& out, const CourseTitle& title) {
+    return out << title.view();
+}
+
 //============================================================================
 // Course structure definition
-// Represents a course with its properties and prerequisite relationships
+// Represents a course with its properties and prerequisite relationships.
+// A course is never modified once it has been inserted into a catalog, so
+// identical records can be shared by every catalog that contains them
 //============================================================================
 
 struct Course {
     string courseId;              // Unique identifier for the course
-    string courseTitle;           // Full name of the course
-    vector<string> prereqs;       // List of prerequisite course IDs
-    vector<string> dependentCourses;  // Courses that require this as prerequisite
-    bool isVisited;              // Used in DFS traversal
-    bool isProcessing;           // Used for cycle detection
+    CourseTitle courseTitle;      // Full name of the course
+    CourseIdList prereqs;         // List of prerequisite course IDs
 
     // Default constructor
-    Course() : isVisited(false), isProcessing(false) {}
+    Course() = default;
 
-    // Constructor with initialization
+    // Constructor with initialization; arguments are taken by value and
+    // moved so callers passing temporaries never copy string storage
     Course(string id, string title) :
-        courseId(id),
-        courseTitle(title),
-        isVisited(false),
-        isProcessing(false) {}
+        courseId(move(id)),
+        courseTitle(move(title)) {}
+
+    // Constructor for a title that points into loaded source text
+    Course(string id, CourseTitle title) :
+        courseId(move(id)),
+        courseTitle(move(title)) {}
 };
 
+// Two course records are identical when every field matches
+inline bool operator==(const Course& a, const Course& b) {
+    return a.courseId == b.courseId && a.courseTitle == b.courseTitle && a.prereqs == b.prereqs;
+}
+
 //============================================================================
-// Node structure for BST
-// Represents a node in the binary search tree using smart pointers
+// Packed course ID keys
+// Course IDs of up to 10 letters and digits are packed 6 bits per character
+// into a 64-bit key whose integer order matches the string order of the IDs,
+// so the indexes compare and hash single integers. Longer IDs keep using
+// their strings as keys
 //============================================================================
 
-struct Node {
-    unique_ptr<Course> course;    // Smart pointer to course data
-    unique_ptr<Node> left;        // Left child node
-    unique_ptr<Node> right;       // Right child node
+const size_t packedKeyLength = 10;
+const uint64_t unpackedKey = 0;    // Marks an ID that does not fit
 
-    // Default constructor
-    Node() = default;
+// Digits, upper-case and lower-case letters keep their ASCII order; code 0 is
+// padding, so an ID sorts before every longer ID it is a prefix of
+inline uint64_t packCourseId(const string& courseId) {
+    if (courseId.empty() || courseId.size() > packedKeyLength) return unpackedKey;
 
-    // Constructor with course initialization
-    explicit Node(Course* aCourse) : course(aCourse) {}
-};
+    uint64_t key = 0;
+    for (size_t i = 0; i < packedKeyLength; ++i) {
+        uint64_t code = 0;
+        if (i < courseId.size()) {
+            char c = courseId[i];
+            if (c >= '0' && c <= '9') code = 1 + (c - '0');
+            else if (c >= 'A' && c <= 'Z') code = 11 + (c - 'A');
+            else if (c >= 'a' && c <= 'z') code = 37 + (c - 'a');
+            else return unpackedKey;
+        }
+        key = (key << 6) | code;
+    }
+    return key;
+}
+
+// Appends the ID a packed key was made from
+inline void appendPackedCourseId(uint64_t key, string& text) {
+    for (size_t i = 0; i < packedKeyLength; ++i) {
+        uint64_t code = (key >> (6 * (packedKeyLength - 1 - i))) & 63;
+        if (code == 0) break;
+        if (code <= 10) text.push_back(static_cast<char>('0' + (code - 1)));
+        else if (code <= 36) text.push_back(static_cast<char>('A' + (code - 11)));
+        else text.push_back(static_cast<char>('a' + (code - 37)));
+    }
+}
+
+// Orders two course IDs, comparing integers when both are packed
+inline bool courseIdLess(uint64_t leftKey, const string& leftId, uint64_t rightKey, const string& rightId) {
+    return (leftKey != unpackedKey && rightKey != unpackedKey) ? leftKey < rightKey : leftId < rightId;
+}
 
 //============================================================================
-// Binary Search Tree class definition
-// Manages course data and provides operations for course management
+// Cache hints
+// Software prefetch used by the search and traversal kernels; a no-op where
+// unsupported, or when built with ENHANCEMENT_TWO_NO_PREFETCH to measure the
+// kernels without it. Prefetching never faults, so the address may lie past
+// the data
 //============================================================================
 
-class BinarySearchTree {
+// Prerequisites resolved ahead of a traversal step
+const size_t prefetchBatch = 8;
+
+inline void prefetchRead(const void* address) {
+#if defined(ENHANCEMENT_TWO_NO_PREFETCH)
+    (void)address;
+#elif defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address, 0, 3);
+#elif defined(COURSE_ART_SSE2)
+    _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+    (void)address;
+#endif
+}
+
+//============================================================================
+// Tracing
+// Optional timeline of load and query phases, written as Chrome trace JSON
+// for chrome://tracing or ui.perfetto.dev. Each thread records its spans into
+// its own ring buffer without locks; while tracing is off a span costs one
+// relaxed load. When a buffer wraps, its oldest spans are overwritten
+//============================================================================
+
+// One completed span as read back from the buffers
+struct TraceRecord {
+    const char* name;       // Span and category names are string literals
+    const char* category;
+    uint32_t threadId;
+    uint64_t startNanos;    // Since tracing was first enabled
+    uint64_t durationNanos;
+};
+
+// Single-writer ring of spans. Each slot is a seqlock: its sequence is odd
+// while the writer fills it and even once done, and names the position it
+// holds. A reader keeps a copied slot only if the sequence was the finished
+// one for that position both before and after the copy, so spans the writer
+// overwrote or was still writing meanwhile are dropped
+class TraceBuffer {
+public:
+    static const size_t capacity = size_t(1) << 16;
+
 private:
-    unique_ptr<Node> root;                    // Root node of the BST
-    unordered_map<string, Course*> courseMap; // Hash map for O(1) course lookup
+    struct Slot {
+        atomic<uint64_t> sequence{ 0 };     // 2 * position + 1 while written, + 2 when done
+        atomic<const char*> name{ nullptr };
+        atomic<const char*> category{ nullptr };
+        atomic<uint32_t> threadId{ 0 };
+        atomic<uint64_t> startNanos{ 0 };
+        atomic<uint64_t> durationNanos{ 0 };
+    };
 
-    // Private helper methods
-    void addNode(Node* node, Course* course);
-    void printSampleSchedule(const Node* node) const;
-    void printCourseInformation(const Node* node, const string& courseId) const;
-    bool hasCycle(Course* course, unordered_set<string>& visited, unordered_set<string>& recursionStack);
-    void topologicalSortUtil(Course* course, unordered_set<string>& visited, stack<Course*>& Stack);
-    void destroyTree(unique_ptr<Node>& node);
-    bool isValidCourseId(const string& courseId) const;
-    void validatePrerequisites(const Course* course) const;
+    unique_ptr<Slot[]> slots{ new Slot[capacity] };
+    atomic<uint64_t> head{ 0 };     // Spans ever written
+    atomic<uint64_t> floor{ 0 };    // Spans before this were cleared
 
 public:
-    // Constructors and assignment operators
-    BinarySearchTree() = default;
-    ~BinarySearchTree() { destroyTree(root); }
+    void Record(const char* name, const char* category, uint32_t threadId, uint64_t start, uint64_t end) {
+        uint64_t position = head.load(memory_order_relaxed);
+        Slot& slot = slots[position & (capacity - 1)];
 
-    // Prevent copying to maintain proper memory management
-    BinarySearchTree(const BinarySearchTree&) = delete;
-    BinarySearchTree& operator=(const BinarySearchTree&) = delete;
+        // The fence keeps the field stores after the odd sequence, so a
+        // reader that sees any of them also sees the slot being written
+        slot.sequence.store(2 * position + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        slot.name.store(name, memory_order_relaxed);
+        slot.category.store(category, memory_order_relaxed);
+        slot.threadId.store(threadId, memory_order_relaxed);
+        slot.startNanos.store(start, memory_order_relaxed);
+        slot.durationNanos.store(end - start, memory_order_relaxed);
+        slot.sequence.store(2 * position + 2, memory_order_release);
+        head.store(position + 1, memory_order_release);
+    }
 
-    // Core functionality
-    void Insert(Course* course);
-    void PrintSampleSchedule() const;
-    void PrintCourseInformation(const string& courseId) const;
+    void Clear() { floor.store(head.load(memory_order_acquire), memory_order_relaxed); }
 
-    // Enhanced functionality for prerequisite management
-    vector<Course*> GetPrerequisiteOrder(const string& courseId);
-    bool ValidateAllPrerequisites() const;
-    bool HasPrerequisiteCycle(const string& courseId);
-    Course* FindCourse(const string& courseId) const;
-    void BuildDependencyGraph();
+    // Appends every span still held, oldest first
+    void CopyTo(vector<TraceRecord>& records) const {
+        uint64_t last = head.load(memory_order_acquire);
+        uint64_t first = max(floor.load(memory_order_relaxed), last > capacity ? last - capacity : 0);
+        for (uint64_t position = first; position < last; ++position) {
+            const Slot& slot = slots[position & (capacity - 1)];
+            uint64_t finished = 2 * position + 2;
+            if (slot.sequence.load(memory_order_acquire) != finished) continue;
+            TraceRecord record = { slot.name.load(memory_order_relaxed), slot.category.load(memory_order_relaxed),
+                slot.threadId.load(memory_order_relaxed), slot.startNanos.load(memory_order_relaxed),
+                slot.durationNanos.load(memory_order_relaxed) };
+
+            // Pairs with the writer's fence: a field from a later span means
+            // the sequence below has moved on too
+            atomic_thread_fence(memory_order_acquire);
+            if (slot.sequence.load(memory_order_relaxed) != finished) continue;
+            records.push_back(record);
+        }
+    }
 };
 
-//============================================================================
-// BST Method Implementations
-//============================================================================
+class Tracer {
+private:
+    static atomic<bool> enabled;
 
-// Recursively destroys the tree, freeing memory
-void BinarySearchTree::destroyTree(unique_ptr<Node>& node) {
-    if (node) {
-        destroyTree(node->left);
-        destroyTree(node->right);
-        node.reset();
+    mutex registryMutex;
+    vector<unique_ptr<TraceBuffer>> buffers;   // Every buffer ever handed out
+    vector<TraceBuffer*> retired;              // Buffers of threads that exited
+    atomic<uint32_t> nextThreadId{ 1 };
+    steady_clock::time_point epoch = steady_clock::now();
+
+    // A thread's buffer, handed back for reuse when the thread exits so that
+    // short-lived loader threads do not each keep one
+    struct ThreadLane {
+        TraceBuffer* buffer = nullptr;
+        uint32_t threadId = 0;
+        ~ThreadLane() {
+            if (buffer) Tracer::Instance().retire(buffer);
+        }
+    };
+
+    TraceBuffer* acquire() {
+        lock_guard<mutex> lock(registryMutex);
+        if (!retired.empty()) {
+            TraceBuffer* buffer = retired.back();
+            retired.pop_back();
+            return buffer;
+        }
+        buffers.push_back(make_unique<TraceBuffer>());
+        return buffers.back().get();
     }
-}
 
-// Validates course ID format (2-4 letters followed by 3+ numbers)
-bool BinarySearchTree::isValidCourseId(const string& courseId) const {
-    if (courseId.empty() || courseId.length() > 20) return false;
+    void retire(TraceBuffer* buffer) {
+        lock_guard<mutex> lock(registryMutex);
+        retired.push_back(buffer);
+    }
 
-    // Check for valid prefix (letters)
-    size_t i = 0;
-    while (i < courseId.length() && isalpha(courseId[i])) {
-        i++;
+public:
+    static Tracer& Instance() {
+        static Tracer tracer;
+        return tracer;
     }
-    if (i < 2 || i > 4) return false;
 
-    // Check for valid number sequence
-    size_t numCount = 0;
-    while (i < courseId.length()) {
-        if (!isdigit(courseId[i])) return false;
-        numCount++;
-        i++;
+    static bool Enabled() { return enabled.load(memory_order_relaxed); }
+    static void Enable() { enabled.store(true, memory_order_relaxed); }
+    static void Disable() { enabled.store(false, memory_order_relaxed); }
+
+    uint64_t Now() const {
+        return static_cast<uint64_t>(duration_cast<nanoseconds>(steady_clock::now() - epoch).count());
     }
-    if (numCount < 3) return false;
 
-    return true;
-}
+    // Records a span for the calling thread
+    void Record(const char* name, const char* category, uint64_t start, uint64_t end) {
+        static thread_local ThreadLane lane;
+        if (!lane.buffer) {
+            lane.buffer = acquire();
+            lane.threadId = nextThreadId.fetch_add(1, memory_order_relaxed);
+        }
+        lane.buffer->Record(name, category, lane.threadId, start, end);
+    }
 
-// Ensures all prerequisites exist in the course catalog
-void BinarySearchTree::validatePrerequisites(const Course* course) const {
-    for (const auto& prereqId : course->prereqs) {
-        if (!FindCourse(prereqId)) {
-            throw runtime_error("Invalid prerequisite: " + prereqId + " for course " + course->courseId);
+    // Discards every span recorded so far
+    void Clear() {
+        lock_guard<mutex> lock(registryMutex);
+        for (const auto& buffer : buffers) buffer->Clear();
+    }
+
+    // Returns every span still held, ordered by start time
+    vector<TraceRecord> Snapshot() {
+        vector<TraceRecord> records;
+        {
+            lock_guard<mutex> lock(registryMutex);
+            for (const auto& buffer : buffers) buffer->CopyTo(records);
         }
+        sort(records.begin(), records.end(), [](const TraceRecord& left, const TraceRecord& right) {
+            return left.startNanos < right.startNanos;
+        });
+        return records;
     }
-}
 
-// Inserts a new course into the BST and course map
-void BinarySearchTree::Insert(Course* course) {
-    if (!course) {
-        throw invalid_argument("Cannot insert null course");
+    // Writes the spans as complete ("X") events; times are in microseconds
+    void WriteChromeTrace(ostream& output) {
+        vector<TraceRecord> records = Snapshot();
+        output << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        for (size_t i = 0; i < records.size(); ++i) {
+            const TraceRecord& record = records[i];
+            output << (i ? ",\n" : "\n") << "{\"name\":\"" << record.name << "\",\"cat\":\"" << record.category
+                << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << record.threadId << fixed << setprecision(3)
+                << ",\"ts\":" << record.startNanos / 1000.0 << ",\"dur\":" << record.durationNanos / 1000.0 << "}";
+        }
+        output << "\n]}\n";
     }
 
-    if (!isValidCourseId(course->courseId)) {
-        throw invalid_argument("Invalid course ID format: " + course->courseId);
+    bool WriteChromeTrace(const string& filepath) {
+        ofstream output(filepath);
+        if (!output.is_open()) return false;
+        WriteChromeTrace(output);
+        return output.good();
     }
+};
 
-    // Add to hash map for O(1) lookups
-    courseMap[course->courseId] = course;
+atomic<bool> Tracer::enabled{ false };
 
-    // Add to BST for ordered traversal
-    if (!root) {
-        root = make_unique<Node>(course);
+// Records the enclosing scope as a span when tracing is on
+class TraceSpan {
+private:
+    const char* name;
+    const char* category;
+    uint64_t start;
+    bool active;
+
+public:
+    TraceSpan(const char* spanName, const char* spanCategory) :
+        name(spanName), category(spanCategory), start(0), active(Tracer::Enabled()) {
+        if (active) start = Tracer::Instance().Now();
     }
-    else {
-        addNode(root.get(), course);
+
+    ~TraceSpan() {
+        if (active) Tracer::Instance().Record(name, category, start, Tracer::Instance().Now());
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+//============================================================================
+// Node structure for BST
+// Represents a node in the binary search tree using smart pointers
+//============================================================================
+
+struct Node {
+    shared_ptr<const Course> course;  // Course data, possibly shared with other catalogs
+    uint64_t key = unpackedKey;   // Packed course ID used for comparisons
+    unique_ptr<Node> left;        // Left child node
+    unique_ptr<Node> right;       // Right child node
+
+    // Default constructor
+    Node() = default;
+
+    // Constructor with course initialization
+    Node(shared_ptr<const Course> aCourse, uint64_t packedKey) : course(move(aCourse)), key(packedKey) {}
+};
+
+//============================================================================
+// Shared course record pool
+// Interns course records so that a record loaded into several catalogs is
+// stored once. Catalogs hold the records; the pool only refers to them, so a
+// record is freed as soon as the last catalog using it is unloaded. Pooled
+// records own their titles: a title left pointing into one catalog's mapped
+// file would keep that file mapped for every catalog sharing the record, and
+// would crash all of them if the file were truncated in place
+//============================================================================
+
+class CourseRecordPool {
+private:
+    static const size_t shardCount = 16;
+
+    // Records are spread over independently locked shards so that catalogs
+    // loading in parallel rarely contend for the same lock
+    struct Shard {
+        mutex shardMutex;
+        unordered_multimap<size_t, weak_ptr<const Course>> records;
+    };
+    array<Shard, shardCount> shards;
+
+    static size_t hashRecord(const Course& course);
+
+public:
+    shared_ptr<const Course> Intern(Course&& course);
+    size_t PurgeExpired();
+    size_t Size();
+};
+
+// Combines the hashes of every field of a course record
+size_t CourseRecordPool::hashRecord(const Course& course) {
+    hash<string_view> hasher;
+    size_t seed = hasher(course.courseId);
+    auto combine = [&seed, &hasher](string_view text) {
+        seed ^= hasher(text) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    };
+    combine(course.courseTitle.view());
+    for (const auto& prereq : course.prereqs) {
+        combine(prereq);
     }
+    return seed;
 }
 
-// Helper function for recursive course insertion
-void BinarySearchTree::addNode(Node* node, Course* course) {
-    if (course->courseId < node->course->courseId) {
-        if (!node->left) {
-            node->left = make_unique<Node>(course);
+// Returns the shared record identical to course, creating it if no catalog
+// holds one yet
+shared_ptr<const Course> CourseRecordPool::Intern(Course&& course) {
+    size_t recordHash = hashRecord(course);
+    Shard& shard = shards[recordHash % shardCount];
+    lock_guard<mutex> lock(shard.shardMutex);
+
+    auto range = shard.records.equal_range(recordHash);
+    for (auto it = range.first; it != range.second;) {
+        shared_ptr<const Course> existing = it->second.lock();
+        if (!existing) {
+            it = shard.records.erase(it);  // Freed by its last catalog
+            continue;
         }
-        else {
-            addNode(node->left.get(), course);
+        if (*existing == course) {
+            return existing;
         }
+        ++it;
     }
-    else {
-        if (!node->right) {
-            node->right = make_unique<Node>(course);
+
+    if (course.courseTitle.owner() && course.courseTitle.owner()->IsMapped()) {
+        course.courseTitle = CourseTitle(course.courseTitle.str());
+    }
+
+    // Allocated separately from its control block so that the record's memory
+    // is returned as soon as the last catalog releases it
+    shared_ptr<const Course> record(new Course(move(course)));
+    shard.records.emplace(recordHash, record);
+    return record;
+}
+
+// Drops entries for records no catalog uses any more; returns how many
+size_t CourseRecordPool::PurgeExpired() {
+    size_t purged = 0;
+    for (auto& shard : shards) {
+        lock_guard<mutex> lock(shard.shardMutex);
+        for (auto it = shard.records.begin(); it != shard.records.end();) {
+            if (it->second.expired()) {
+                it = shard.records.erase(it);
+                purged++;
+            }
+            else {
+                ++it;
+            }
         }
-        else {
-            addNode(node->right.get(), course);
+    }
+    return purged;
+}
+
+// Number of distinct records currently held by at least one catalog
+size_t CourseRecordPool::Size() {
+    size_t live = 0;
+    for (auto& shard : shards) {
+        lock_guard<mutex> lock(shard.shardMutex);
+        for (const auto& entry : shard.records) {
+            if (!entry.second.expired()) live++;
         }
     }
+    return live;
 }
 
-// O(1) course lookup using hash map
-Course* BinarySearchTree::FindCourse(const string& courseId) const {
-    auto it = courseMap.find(courseId);
-    return (it != courseMap.end()) ? it->second : nullptr;
-}
+//============================================================================
+// Memory accounting
+// Counters and a counting allocator used to report memory use by subsystem
+//============================================================================
+
+// Allocation totals for one subsystem; atomic so that concurrent readers of
+// the same catalog can record their query scratch safely
+struct MemoryCounter {
+    atomic<size_t> liveBytes{ 0 };         // Bytes currently allocated
+    atomic<size_t> liveAllocations{ 0 };   // Allocations currently outstanding
+    atomic<size_t> peakBytes{ 0 };         // Highest value liveBytes reached
+    atomic<size_t> totalBytes{ 0 };        // Bytes allocated over the lifetime
+    atomic<size_t> totalAllocations{ 0 };  // Allocations over the lifetime
+
+    void recordAllocation(size_t bytes) {
+        size_t live = liveBytes.fetch_add(bytes, memory_order_relaxed) + bytes;
+        liveAllocations.fetch_add(1, memory_order_relaxed);
+        totalBytes.fetch_add(bytes, memory_order_relaxed);
+        totalAllocations.fetch_add(1, memory_order_relaxed);
+        size_t peak = peakBytes.load(memory_order_relaxed);
+        while (live > peak && !peakBytes.compare_exchange_weak(peak, live, memory_order_relaxed)) {}
+    }
+
+    void recordDeallocation(size_t bytes) {
+        liveBytes.fetch_sub(bytes, memory_order_relaxed);
+        liveAllocations.fetch_sub(1, memory_order_relaxed);
+    }
+};
+
+// Standard library allocator that reports every allocation to a MemoryCounter
+template <typename T>
+struct CountingAllocator {
+    typedef T value_type;
+    MemoryCounter* counter;
+
+    explicit CountingAllocator(MemoryCounter* memoryCounter) noexcept : counter(memoryCounter) {}
+
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>& other) noexcept : counter(other.counter) {}
+
+    T* allocate(size_t count) {
+        T* memory = static_cast<T*>(::operator new(count * sizeof(T)));
+        counter->recordAllocation(count * sizeof(T));
+        return memory;
+    }
+
+    void deallocate(T* memory, size_t count) noexcept {
+        counter->recordDeallocation(count * sizeof(T));
+        ::operator delete(memory);
+    }
+
+    template <typename U>
+    bool operator==(const CountingAllocator<U>& other) const noexcept { return counter == other.counter; }
+
+    template <typename U>
+    bool operator!=(const CountingAllocator<U>& other) const noexcept { return counter != other.counter; }
+};
+
+// Per-catalog data kept for each course
+struct CourseEntry {
+    const Course* course;             // Record owned by the tree
+};
+
+// Courses that require a course as a prerequisite, by record. Dependents
+// depend on the rest of the catalog, so they are kept per catalog rather than
+// in the shared record, and only for courses that have any
+typedef SmallVector<const Course*, 2> DependentList;
+typedef unordered_map<const Course*, DependentList, hash<const Course*>, equal_to<const Course*>,
+    CountingAllocator<pair<const Course* const, DependentList>>> DependentIndex;
+
+// Hash indexes from course ID to course, counted as their own subsystem: one
+// keyed by packed IDs and one by the IDs too long to pack
+typedef unordered_map<uint64_t, CourseEntry, hash<uint64_t>, equal_to<uint64_t>,
+    CountingAllocator<pair<const uint64_t, CourseEntry>>> PackedCourseIndex;
+typedef unordered_map<string, CourseEntry, hash<string>, equal_to<string>,
+    CountingAllocator<pair<const string, CourseEntry>>> CourseIndex;
+
+// Scratch containers used while answering a query
+typedef unordered_set<string, hash<string>, equal_to<string>, CountingAllocator<string>> ScratchSet;
+typedef stack<const Course*, deque<const Course*, CountingAllocator<const Course*>>> ScratchStack;
+
+// Query types whose scratch memory and latency are tracked separately
+enum class QueryType { Search, PrerequisitePath, Validate, Count };
+const char* const queryTypeNames[] = { "Search", "Prerequisite path", "Validate" };
+
+// Retained memory of one subsystem
+struct MemoryUsage {
+    string subsystem;
+    size_t objects;
+    size_t bytes;
+};
+
+// Scratch memory used by one query type
+struct QueryMemoryUsage {
+    string queryType;
+    size_t calls;
+    size_t allocations;   // Over all calls
+    size_t totalBytes;    // Over all calls
+    size_t peakBytes;     // Largest amount live at once
+    size_t liveBytes;     // Still allocated; zero between queries
+};
+
+// Heap bytes owned by a string, zero when it fits in the small-string buffer
+inline size_t stringHeapBytes(const string& text) {
+    static const size_t inlineCapacity = string().capacity();
+    return (text.capacity() > inlineCapacity) ? text.capacity() + 1 : 0;
+}
+
+// Heap bytes of an owned buffer; a mapping is backed by the page cache
+size_t SourceText::HeapBytes() const {
+    return mapping ? 0 : sizeof(SourceText) + stringHeapBytes(buffer);
+}
+
+// Heap bytes owned by a list of strings, including the strings themselves
+inline size_t stringListHeapBytes(const CourseIdList& list) {
+    size_t bytes = list.heapBytes();
+    for (const auto& text : list) {
+        bytes += stringHeapBytes(text);
+    }
+    return bytes;
+}
+
+//============================================================================
+// Query latency
+// HDR-style latency histograms per query type, shared by every catalog in the
+// process. Buckets are log-linear, 64 per power of two above 128 ns, so a
+// reported latency is at most 1/64 above the true one. Each thread counts into
+// its own histograms and readers merge them on demand
+//============================================================================
+
+// Latency percentiles of one query type
+struct LatencySummary {
+    string queryType;
+    uint64_t count;
+    double meanNanos;
+    uint64_t p50Nanos;
+    uint64_t p99Nanos;
+    uint64_t p999Nanos;
+    uint64_t maxNanos;
+};
+
+// Index of the highest set bit; value must be non-zero
+inline unsigned highestBit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - static_cast<unsigned>(__builtin_clzll(value));
+#else
+    unsigned bit = 0;
+    while (value >>= 1) bit++;
+    return bit;
+#endif
+}
+
+class QueryLatency {
+public:
+    static const unsigned subBucketBits = 7;
+    static const uint64_t subBucketCount = uint64_t(1) << subBucketBits;
+    static const uint64_t subBucketHalf = subBucketCount / 2;
+    static const unsigned maxMagnitude = 40;        // Latencies are capped at 2^40 ns (18 minutes)
+    static const size_t bucketCount = (maxMagnitude - subBucketBits + 2) * subBucketHalf;
+
+    // Latencies below 128 ns get a bucket each; above that a bucket spans
+    // 2^shift nanoseconds where shift grows by one per power of two
+    static size_t BucketOf(uint64_t nanos) {
+        nanos = min(nanos, (uint64_t(1) << maxMagnitude) - 1);
+        unsigned shift = (nanos < subBucketCount) ? 0 : highestBit(nanos) - (subBucketBits - 1);
+        return static_cast<size_t>(shift * subBucketHalf + (nanos >> shift));
+    }
+
+    // Highest latency that falls into a bucket
+    static uint64_t HighestIn(size_t bucket) {
+        uint64_t shift = (bucket < subBucketCount) ? 0 : bucket / subBucketHalf - 1;
+        uint64_t sub = bucket - shift * subBucketHalf;
+        return ((sub + 1) << shift) - 1;
+    }
+
+private:
+    static const size_t queryTypeCount = static_cast<size_t>(QueryType::Count);
+
+    // Histograms of one thread. Only that thread writes them, so a count is
+    // bumped with a plain load and store rather than a read-modify-write
+    struct ThreadHistograms {
+        array<array<atomic<uint64_t>, bucketCount>, queryTypeCount> buckets{};
+        array<atomic<uint64_t>, queryTypeCount> totalNanos{};
+        array<atomic<uint64_t>, queryTypeCount> maxNanos{};
+    };
+
+    mutex registryMutex;
+    vector<unique_ptr<ThreadHistograms>> histograms;   // Every set handed out
+    vector<ThreadHistograms*> retired;                 // Sets of threads that exited; counts kept
+
+    struct ThreadLane {
+        ThreadHistograms* histograms = nullptr;
+        ~ThreadLane() {
+            if (histograms) QueryLatency::Instance().retire(histograms);
+        }
+    };
+
+    ThreadHistograms* acquire() {
+        lock_guard<mutex> lock(registryMutex);
+        if (!retired.empty()) {
+            ThreadHistograms* reused = retired.back();
+            retired.pop_back();
+            return reused;
+        }
+        histograms.push_back(make_unique<ThreadHistograms>());
+        return histograms.back().get();
+    }
+
+    void retire(ThreadHistograms* set) {
+        lock_guard<mutex> lock(registryMutex);
+        retired.push_back(set);
+    }
+
+    static void bump(atomic<uint64_t>& counter, uint64_t amount) {
+        counter.store(counter.load(memory_order_relaxed) + amount, memory_order_relaxed);
+    }
+
+    // The calling thread's histograms, set up on first use
+    ThreadHistograms& threadHistograms() {
+        static thread_local ThreadLane lane;
+        if (!lane.histograms) lane.histograms = acquire();
+        return *lane.histograms;
+    }
+
+public:
+    static QueryLatency& Instance() {
+        static QueryLatency latency;
+        return latency;
+    }
+
+    // Sets up the calling thread's histograms ahead of its first query; they
+    // are a few dozen kilobytes, which the first query would otherwise clear
+    void PrepareThread() { threadHistograms(); }
+
+    // Records one query of a type on the calling thread
+    void Record(QueryType type, uint64_t nanos) {
+        size_t index = static_cast<size_t>(type);
+        ThreadHistograms& own = threadHistograms();
+        bump(own.buckets[index][BucketOf(nanos)], 1);
+        bump(own.totalNanos[index], nanos);
+        if (nanos > own.maxNanos[index].load(memory_order_relaxed)) {
+            own.maxNanos[index].store(nanos, memory_order_relaxed);
+        }
+    }
+
+    // Merges every thread's histograms into percentiles per query type
+    vector<LatencySummary> Summaries() {
+        vector<LatencySummary> summaries;
+        lock_guard<mutex> lock(registryMutex);
+        vector<uint64_t> merged(bucketCount);
+        for (size_t type = 0; type < queryTypeCount; ++type) {
+            LatencySummary summary = { queryTypeNames[type], 0, 0.0, 0, 0, 0, 0 };
+            fill(merged.begin(), merged.end(), 0);
+            uint64_t totalNanos = 0;
+            for (const auto& set : histograms) {
+                for (size_t bucket = 0; bucket < bucketCount; ++bucket) {
+                    merged[bucket] += set->buckets[type][bucket].load(memory_order_relaxed);
+                }
+                totalNanos += set->totalNanos[type].load(memory_order_relaxed);
+                summary.maxNanos = max(summary.maxNanos, set->maxNanos[type].load(memory_order_relaxed));
+            }
+            for (uint64_t count : merged) summary.count += count;
+
+            if (summary.count > 0) {
+                summary.meanNanos = static_cast<double>(totalNanos) / summary.count;
+                // The value at rank ceil(p * count), reported as its bucket's upper edge
+                auto percentile = [&](double fraction) {
+                    uint64_t rank = max<uint64_t>(1, static_cast<uint64_t>(ceil(fraction * summary.count)));
+                    uint64_t seen = 0;
+                    for (size_t bucket = 0; bucket < bucketCount; ++bucket) {
+                        seen += merged[bucket];
+                        if (seen >= rank) return min(HighestIn(bucket), summary.maxNanos);
+                    }
+                    return summary.maxNanos;
+                };
+                summary.p50Nanos = percentile(0.5);
+                summary.p99Nanos = percentile(0.99);
+                summary.p999Nanos = percentile(0.999);
+            }
+            summaries.push_back(summary);
+        }
+        return summaries;
+    }
+
+    // Discards every recorded latency; meant for quiet moments such as tests,
+    // since a query finishing meanwhile may be half counted
+    void Reset() {
+        lock_guard<mutex> lock(registryMutex);
+        for (const auto& set : histograms) {
+            for (auto& buckets : set->buckets) {
+                for (auto& count : buckets) count.store(0, memory_order_relaxed);
+            }
+            for (auto& total : set->totalNanos) total.store(0, memory_order_relaxed);
+            for (auto& highest : set->maxNanos) highest.store(0, memory_order_relaxed);
+        }
+    }
+};
+
+// Records the enclosing query's latency when it returns or throws
+class QueryTimer {
+private:
+    QueryType type;
+    steady_clock::time_point start;
+
+public:
+    explicit QueryTimer(QueryType queryType) : type(queryType), start(steady_clock::now()) {}
+
+    ~QueryTimer() {
+        QueryLatency::Instance().Record(type,
+            static_cast<uint64_t>(duration_cast<nanoseconds>(steady_clock::now() - start).count()));
+    }
+
+    QueryTimer(const QueryTimer&) = delete;
+    QueryTimer& operator=(const QueryTimer&) = delete;
+};
+
+// Displays latency percentiles per query type in microseconds
+void printLatencyReport() {
+    printSubHeader("Query Latency Report");
+    cout << "    " << setw(18) << left << "QUERY TYPE"
+        << " | " << setw(7) << right << "COUNT"
+        << " | " << setw(9) << right << "MEAN (us)"
+        << " | " << setw(9) << right << "P50"
+        << " | " << setw(9) << right << "P99"
+        << " | " << setw(9) << right << "P99.9"
+        << " | " << setw(9) << right << "MAX" << endl;
+    cout << "  " << string(91, '-') << endl;
+
+    // Values are formatted separately so cout keeps its default float format
+    auto micros = [](double nanos) {
+        ostringstream text;
+        text << fixed << setprecision(2) << nanos / 1000.0;
+        return text.str();
+    };
+    for (const auto& summary : QueryLatency::Instance().Summaries()) {
+        cout << "    " << setw(18) << left << summary.queryType
+            << " | " << setw(7) << right << summary.count
+            << " | " << setw(9) << right << micros(summary.meanNanos)
+            << " | " << setw(9) << right << micros(static_cast<double>(summary.p50Nanos))
+            << " | " << setw(9) << right << micros(static_cast<double>(summary.p99Nanos))
+            << " | " << setw(9) << right << micros(static_cast<double>(summary.p999Nanos))
+            << " | " << setw(9) << right << micros(static_cast<double>(summary.maxNanos)) << endl;
+    }
+    cout << endl;
+    printLine();
+}
+
+// Writes latency percentiles per query type as CSV, in microseconds
+bool writeLatencyCsv(const string& filepath) {
+    ofstream csv(filepath);
+    if (!csv.is_open()) return false;
+    csv << "query_type,count,mean_us,p50_us,p99_us,p999_us,max_us\n";
+    for (const auto& summary : QueryLatency::Instance().Summaries()) {
+        csv << summary.queryType << "," << summary.count << "," << summary.meanNanos / 1000.0
+            << "," << summary.p50Nanos / 1000.0 << "," << summary.p99Nanos / 1000.0
+            << "," << summary.p999Nanos / 1000.0 << "," << summary.maxNanos / 1000.0 << "\n";
+    }
+    return csv.good();
+}
+
+//============================================================================
+// Missing course ID filter
+// Split-block Bloom filter over the IDs of a loaded catalog. Feeds often name
+// courses that do not exist, and the filter answers most of those lookups
+// from one 32-byte block instead of probing the hash index
+//============================================================================
+
+// Counters and sizes reported for a catalog's filter
+struct FilterStats {
+    size_t keys;
+    size_t bytes;
+    double expectedFalsePositiveRate;   // From the bits actually set
+    size_t lookups;                     // Lookups the filter was consulted on
+    size_t rejected;                    // Answered as missing by the filter
+    size_t falsePositives;              // Passed the filter but not in the index
+};
+
+class CourseIdFilter {
+private:
+    typedef array<uint32_t, 8> Block;
+    static const size_t bitsPerKey = 12;
+
+    vector<Block> blocks;
+    size_t keyCount = 0;
+
+    size_t blockFor(uint64_t hash) const {
+        return static_cast<size_t>(((hash >> 32) * blocks.size()) >> 32);
+    }
+
+    // One bit in each of the block's eight words, chosen by a salted multiply
+    static Block maskFor(uint64_t hash) {
+        static const uint32_t salts[8] = { 0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+            0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U };
+        Block mask;
+        uint32_t low = static_cast<uint32_t>(hash);
+        for (size_t i = 0; i < mask.size(); ++i) {
+            mask[i] = 1u << ((low * salts[i]) >> 27);
+        }
+        return mask;
+    }
+
+public:
+    // Packed IDs are mixed directly; longer IDs are hashed as strings first
+    static uint64_t Hash(const string& courseId, uint64_t key) {
+        return Mix((key != unpackedKey) ? key : std::hash<string>()(courseId));
+    }
+
+    static uint64_t Mix(uint64_t hash) {
+        hash ^= hash >> 30;
+        hash *= 0xbf58476d1ce4e5b9ULL;
+        hash ^= hash >> 27;
+        hash *= 0x94d049bb133111ebULL;
+        return hash ^ (hash >> 31);
+    }
+
+    void Build(const vector<uint64_t>& hashes) {
+        keyCount = hashes.size();
+        blocks.assign(max<size_t>(1, (keyCount * bitsPerKey + 255) / 256), Block{});
+        for (uint64_t hash : hashes) {
+            Block& block = blocks[blockFor(hash)];
+            Block mask = maskFor(hash);
+            for (size_t i = 0; i < block.size(); ++i) block[i] |= mask[i];
+        }
+    }
+
+    void Clear() {
+        blocks = vector<Block>();
+        keyCount = 0;
+    }
+
+    bool IsBuilt() const { return !blocks.empty(); }
+
+    // False means the ID is certainly absent; an unbuilt filter passes all
+    bool MayContain(uint64_t hash) const {
+        if (blocks.empty()) return true;
+        const Block& block = blocks[blockFor(hash)];
+        Block mask = maskFor(hash);
+        uint32_t missing = 0;
+        for (size_t i = 0; i < block.size(); ++i) missing |= mask[i] & ~block[i];
+        return missing == 0;
+    }
+
+    size_t Keys() const { return keyCount; }
+    size_t Bytes() const { return blocks.capacity() * sizeof(Block); }
+
+    // An absent ID passes when its bit is set in all eight words of its block
+    double ExpectedFalsePositiveRate() const {
+        if (blocks.empty()) return 0.0;
+        double total = 0.0;
+        for (const auto& block : blocks) {
+            double pass = 1.0;
+            for (uint32_t word : block) pass *= bitset<32>(word).count() / 32.0;
+            total += pass;
+        }
+        return total / blocks.size();
+    }
+};
+
+// Filter counters, striped across cache lines. Each thread counts into the
+// stripe it was handed on first use, so concurrent readers of one catalog do
+// not fight over a line; the memory report sums the stripes
+class FilterCounters {
+private:
+    static const size_t stripeCount = 16;
+
+    struct alignas(64) Stripe {
+        atomic<size_t> lookups{ 0 };
+        atomic<size_t> rejects{ 0 };
+        atomic<size_t> falsePositives{ 0 };
+    };
+
+    array<Stripe, stripeCount> stripes;
+
+    // Stripes are handed out round robin, so up to 16 threads never share one
+    static size_t stripeIndex() {
+        static atomic<size_t> nextStripe{ 0 };
+        static thread_local size_t index = nextStripe.fetch_add(1, memory_order_relaxed) % stripeCount;
+        return index;
+    }
+
+    template <typename Field>
+    size_t sum(Field field) const {
+        size_t total = 0;
+        for (const auto& stripe : stripes) total += (stripe.*field).load(memory_order_relaxed);
+        return total;
+    }
+
+public:
+    void CountLookup(bool rejected) {
+        Stripe& stripe = stripes[stripeIndex()];
+        stripe.lookups.fetch_add(1, memory_order_relaxed);
+        if (rejected) stripe.rejects.fetch_add(1, memory_order_relaxed);
+    }
+
+    void CountFalsePositive() {
+        stripes[stripeIndex()].falsePositives.fetch_add(1, memory_order_relaxed);
+    }
+
+    size_t Lookups() const { return sum(&Stripe::lookups); }
+    size_t Rejects() const { return sum(&Stripe::rejects); }
+    size_t FalsePositives() const { return sum(&Stripe::falsePositives); }
+};
+
+//============================================================================
+// Binary Search Tree class definition
+// Manages course data and provides operations for course management
+//============================================================================
+
+// Defined with the prerequisite graph below
+class PrerequisiteGraph;
+enum class GraphOrder;
+
+class BinarySearchTree {
+private:
+    static const size_t queryTypeCount = static_cast<size_t>(QueryType::Count);
+
+    MemoryCounter indexMemory;                // Allocations made by the course indexes
+    mutable MemoryCounter queryMemory[queryTypeCount];  // Scratch per query type
+    mutable atomic<size_t> queryCalls[queryTypeCount] = {};
+
+    shared_ptr<CourseRecordPool> recordPool;  // Shared record storage, or null
+    unique_ptr<Node> root;                    // Root node of the BST
+    PackedCourseIndex packedMap{ PackedCourseIndex::allocator_type(&indexMemory) }; // O(1) lookup by packed ID
+    CourseIndex courseMap{ CourseIndex::allocator_type(&indexMemory) }; // O(1) lookup for IDs too long to pack
+
+    // Reverse prerequisite edges, built by the first query that needs them
+    // and dropped by any later insert. Readers that find the pointer set
+    // use the index without locking
+    mutable MemoryCounter dependentMemory;
+    mutable mutex dependentMutex;
+    mutable unique_ptr<DependentIndex> dependentStorage;
+    mutable atomic<const DependentIndex*> dependentIndex{ nullptr };
+
+    // Prerequisite edges by dense handle, built after a load and dropped by
+    // any later insert; while present, traversals and dependents use it
+    // instead of resolving prerequisites through the hash index
+    shared_ptr<const PrerequisiteGraph> graph;
+
+    // Frozen layout: records and their packed keys in Eytzinger (BFS) order
+    // from index 1, replacing the pointer tree once the catalog is complete
+    bool frozen = false;
+    bool frozenPacked = false;                // Every key packed: compare integers
+    vector<shared_ptr<const Course>> frozenRecords;
+    vector<uint64_t> frozenKeys;
+
+    // Bulk load: records inserted into an empty tree wait here in insertion
+    // order and are sorted, indexed and placed once, when the load ends
+    bool staging = false;
+    vector<shared_ptr<const Course>> staged;
+
+    // Filter over the loaded IDs, rebuilt with the dependency graph and
+    // dropped by any later insert; the counters feed the memory report
+    CourseIdFilter idFilter;
+    mutable FilterCounters filterCounters;
+
+    // Private helper methods
+    void insertRecord(shared_ptr<const Course> record);
+    void addNode(Node* node, shared_ptr<const Course> course, uint64_t key);
+    vector<uint64_t> sortStaged();
+    const CourseEntry* findEntry(const string& courseId) const;
+    const CourseEntry* findEntry(const string& courseId, uint64_t key) const;
+    bool filterPasses(const string& courseId, uint64_t key) const;
+    void forEachRecord(const Node* node, const function<void(const shared_ptr<const Course>&)>& visit) const;
+    void forEachFrozen(size_t slot, const function<void(const shared_ptr<const Course>&)>& visit) const;
+    void forEachFrozenKeyed(size_t slot, const function<void(uint64_t, const Course*)>& visit) const;
+    void layoutFrozen(vector<shared_ptr<const Course>>& sorted, const vector<uint64_t>& keys, size_t& next, size_t slot);
+    void freezeSorted(vector<shared_ptr<const Course>>& sorted, const vector<uint64_t>& keys = {});
+    size_t frozenLowerBound(const string& courseId, uint64_t key) const;
+    unique_ptr<Node> buildBalanced(vector<shared_ptr<const Course>>& sorted, size_t first, size_t last);
+    void thaw();
+    const DependentIndex& dependents() const;
+    void dropDependents();
+    vector<const Course*> dependentsOf(const Course* course) const;
+    const Course* findCourse(const string& courseId, uint32_t& handle) const;
+    void appendDependents(const Course* course, uint32_t handle, string& text) const;
+    bool graphHasCycle(const Course* course) const;
+    vector<const Course*> graphPrerequisiteOrder(const Course* course) const;
+    bool graphPrerequisitesValid() const;
+    void countGraphMemory(vector<MemoryUsage>& usage) const;
+    void printCourseInformation(const Course* course, uint32_t handle) const;
+    size_t resolvePrerequisites(const CourseIdList& prereqs, size_t first, const Course** resolved) const;
+    bool hasCycle(const Course* course, ScratchSet& visited, ScratchSet& recursionStack) const;
+    void topologicalSortUtil(const Course* course, ScratchSet& visited, ScratchStack& Stack) const;
+    void destroyTree(unique_ptr<Node>& node);
+    void validatePrerequisites(const Course* course) const;
+    void collectMemoryUsage(const Course* course, vector<MemoryUsage>& usage,
+        unordered_set<const SourceText*>& sources) const;
+    CountingAllocator<string> beginQuery(QueryType type) const;
+
+    // Visits every index entry, packed keys first
+    template <typename Visit>
+    void forEachEntry(Visit visit) {
+        for (auto& pair : packedMap) visit(pair.second);
+        for (auto& pair : courseMap) visit(pair.second);
+    }
+
+    template <typename Visit>
+    void forEachEntry(Visit visit) const {
+        for (const auto& pair : packedMap) visit(pair.second);
+        for (const auto& pair : courseMap) visit(pair.second);
+    }
+
+public:
+    // Constructors and assignment operators
+    BinarySearchTree() = default;
+    explicit BinarySearchTree(shared_ptr<CourseRecordPool> pool) : recordPool(move(pool)) {}
+    ~BinarySearchTree() { destroyTree(root); }
+
+    // Prevent copying to maintain proper memory management
+    BinarySearchTree(const BinarySearchTree&) = delete;
+    BinarySearchTree& operator=(const BinarySearchTree&) = delete;
+
+    // Core functionality
+    void Insert(Course* course);
+    void Insert(Course&& course);
+    void Insert(shared_ptr<const Course> record);
+    void InsertValidated(Course&& course);
+    void ForEachRecord(const function<void(const shared_ptr<const Course>&)>& visit) const;
+    void ForEachKeyedRecord(const function<void(uint64_t key, const Course* record)>& visit) const;
+    void PrintSampleSchedule() const;
+    void PrintCourseInformation(const string& courseId) const;
+
+    // Frozen layout: Freeze() drops the pointer tree for the Eytzinger
+    // arrays; a later insert rebuilds a balanced tree first
+    void Freeze();
+    bool IsFrozen() const { return frozen; }
+
+    // Bulk loading: from BeginBulkLoad() on an empty tree until EndBulkLoad()
+    // or Freeze(), inserts only stage their records; the hash indexes and the
+    // ordered index are built once, from the sorted records
+    void BeginBulkLoad();
+    void EndBulkLoad();
+    bool LoadChanged(const BinarySearchTree& base, const vector<shared_ptr<const Course>>& upserts,
+        const vector<string>& removals);
+
+    size_t Size() const { return packedMap.size() + courseMap.size(); }
+    static bool IsValidCourseId(const string& courseId);
+
+    // Enhanced functionality for prerequisite management
+    vector<const Course*> GetPrerequisiteOrder(const string& courseId) const;
+    bool ValidateAllPrerequisites() const;
+    bool HasPrerequisiteCycle(const string& courseId) const;
+    const Course* FindCourse(const string& courseId) const;
+    const Course* FindInTree(const string& courseId) const;
+    vector<const Course*> GetDependents(const string& courseId) const;
+    bool HasDependentIndex() const;
+    void BuildDependencyGraph();
+    void BuildPrerequisiteGraph();
+    void BuildPrerequisiteGraph(GraphOrder order);
+    bool HasPrerequisiteGraph() const { return graph != nullptr; }
+
+    // Memory accounting
+    FilterStats GetFilterStats() const;
+    vector<MemoryUsage> GetMemoryUsage() const;
+    vector<QueryMemoryUsage> GetQueryMemoryUsage() const;
+    void PrintMemoryReport() const;
+};
+
+//============================================================================
+// BST Method Implementations
+//============================================================================
+
+// Recursively destroys the tree, freeing memory
+void BinarySearchTree::destroyTree(unique_ptr<Node>& node) {
+    if (node) {
+        destroyTree(node->left);
+        destroyTree(node->right);
+        node.reset();
+    }
+}
+
+// Validates course ID format (2-4 letters followed by 3+ numbers)
+bool BinarySearchTree::IsValidCourseId(const string& courseId) {
+    if (courseId.empty() || courseId.length() > 20) return false;
+
+    // Check for valid prefix (letters)
+    // Characters are widened through unsigned char; passing a negative char
+    // to the <cctype> functions is undefined behavior
+    size_t i = 0;
+    while (i < courseId.length() && isalpha(static_cast<unsigned char>(courseId[i]))) {
+        i++;
+    }
+    if (i < 2 || i > 4) return false;
+
+    // Check for valid number sequence
+    size_t numCount = 0;
+    while (i < courseId.length()) {
+        if (!isdigit(static_cast<unsigned char>(courseId[i]))) return false;
+        numCount++;
+        i++;
+    }
+    if (numCount < 3) return false;
+
+    return true;
+}
+
+// Ensures all prerequisites exist in the course catalog
+void BinarySearchTree::validatePrerequisites(const Course* course) const {
+    for (const auto& prereqId : course->prereqs) {
+        if (!FindCourse(prereqId)) {
+            throw runtime_error("Invalid prerequisite: " + prereqId + " for course " + course->courseId);
+        }
+    }
+}
+
+// Inserts a new course into the BST and course map. The tree takes ownership
+// of the course once it has been accepted; when the tree shares a record pool,
+// an identical record already held by another catalog is used instead
+void BinarySearchTree::Insert(Course* course) {
+    TraceSpan span("Insert", "load");
+    if (!course) {
+        throw invalid_argument("Cannot insert null course");
+    }
+
+    if (!IsValidCourseId(course->courseId)) {
+        throw invalid_argument("Invalid course ID format: " + course->courseId);
+    }
+
+    if (recordPool) {
+        unique_ptr<Course> owned(course);
+        insertRecord(recordPool->Intern(move(*owned)));
+    }
+    else {
+        insertRecord(shared_ptr<const Course>(course));
+    }
+}
+
+// Inserts a course record built by value; used by the loader so that each
+// course costs a single allocation for the record and its reference count
+void BinarySearchTree::Insert(Course&& course) {
+    TraceSpan span("Insert", "load");
+    if (!IsValidCourseId(course.courseId)) {
+        throw invalid_argument("Invalid course ID format: " + course.courseId);
+    }
+
+    insertRecord(recordPool ? recordPool->Intern(move(course)) : make_shared<const Course>(move(course)));
+}
+
+// Inserts a course whose ID the caller has already checked with
+// IsValidCourseId; used by the import pipeline's insert stage
+void BinarySearchTree::InsertValidated(Course&& course) {
+    TraceSpan span("Insert", "load");
+    insertRecord(recordPool ? recordPool->Intern(move(course)) : make_shared<const Course>(move(course)));
+}
+
+// Inserts a record already shared with another catalog or catalog version
+void BinarySearchTree::Insert(shared_ptr<const Course> record) {
+    TraceSpan span("Insert", "load");
+    if (!record) {
+        throw invalid_argument("Cannot insert null course");
+    }
+
+    if (!IsValidCourseId(record->courseId)) {
+        throw invalid_argument("Invalid course ID format: " + record->courseId);
+    }
+
+    insertRecord(move(record));
+}
+
+// Visits every record in course ID order
+void BinarySearchTree::ForEachRecord(const function<void(const shared_ptr<const Course>&)>& visit) const {
+    if (frozen) {
+        forEachFrozen(1, visit);
+    }
+    else {
+        forEachRecord(root.get(), visit);
+    }
+}
+
+// In-order traversal that also passes each record's packed ID. A frozen
+// catalog keeps the keys beside the records, so they are not read to get it
+void BinarySearchTree::ForEachKeyedRecord(const function<void(uint64_t key, const Course* record)>& visit) const {
+    if (frozen) {
+        forEachFrozenKeyed(1, visit);
+    }
+    else {
+        forEachRecord(root.get(), [&visit](const shared_ptr<const Course>& record) {
+            visit(packCourseId(record->courseId), record.get());
+        });
+    }
+}
+
+// Helper function for the in-order record traversal
+void BinarySearchTree::forEachRecord(const Node* node,
+    const function<void(const shared_ptr<const Course>&)>& visit) const {
+    if (node) {
+        forEachRecord(node->left.get(), visit);
+        visit(node->course);
+        forEachRecord(node->right.get(), visit);
+    }
+}
+
+// Adds an accepted record to the course map and the BST
+void BinarySearchTree::insertRecord(shared_ptr<const Course> record) {
+    // A bulk load started on an empty tree, so nothing derived needs dropping
+    if (staging) {
+        staged.push_back(move(record));
+        return;
+    }
+
+    if (frozen) thaw();
+    idFilter.Clear();
+    dropDependents();
+    graph.reset();
+
+    // Add to hash map for O(1) lookups
+    uint64_t key = packCourseId(record->courseId);
+    if (key != unpackedKey) {
+        packedMap.insert_or_assign(key, CourseEntry{ record.get() });
+    }
+    else {
+        courseMap.insert_or_assign(record->courseId, CourseEntry{ record.get() });
+    }
+
+    // Add to BST for ordered traversal
+    if (!root) {
+        root = make_unique<Node>(move(record), key);
+    }
+    else {
+        addNode(root.get(), move(record), key);
+    }
+}
+
+// Helper function for recursive course insertion
+void BinarySearchTree::addNode(Node* node, shared_ptr<const Course> course, uint64_t key) {
+    if (courseIdLess(key, course->courseId, node->key, node->course->courseId)) {
+        if (!node->left) {
+            node->left = make_unique<Node>(move(course), key);
+        }
+        else {
+            addNode(node->left.get(), move(course), key);
+        }
+    }
+    else {
+        if (!node->right) {
+            node->right = make_unique<Node>(move(course), key);
+        }
+        else {
+            addNode(node->right.get(), move(course), key);
+        }
+    }
+}
+
+void BinarySearchTree::BeginBulkLoad() {
+    if (Size() == 0 && !frozen) staging = true;
+}
+
+// Places the staged records in a balanced tree; used when a load stops
+// before its catalog is frozen
+void BinarySearchTree::EndBulkLoad() {
+    if (!staging) return;
+    staging = false;
+    sortStaged();
+    root = buildBalanced(staged, 0, staged.size());
+    staged = vector<shared_ptr<const Course>>();
+}
+
+// Stable LSD radix sort of packed keys with their load positions, a byte per
+// pass, skipping bytes that every key shares. A comparison sort of random IDs
+// mispredicts about every other branch, and it took a third of a freeze
+void radixSortKeys(vector<pair<uint64_t, size_t>>& keys) {
+    if (keys.size() < 2) return;
+    const size_t passes = sizeof(uint64_t);
+    vector<array<size_t, 256>> counts(passes);
+    for (const auto& key : keys) {
+        for (size_t pass = 0; pass < passes; ++pass) {
+            counts[pass][(key.first >> (8 * pass)) & 255]++;
+        }
+    }
+
+    vector<pair<uint64_t, size_t>> buffer(keys.size());
+    for (size_t pass = 0; pass < passes; ++pass) {
+        array<size_t, 256>& starts = counts[pass];
+        if (starts[(keys[0].first >> (8 * pass)) & 255] == keys.size()) continue;
+        size_t offset = 0;
+        for (size_t& start : starts) {
+            size_t count = start;
+            start = offset;
+            offset += count;
+        }
+        for (const auto& key : keys) {
+            buffer[starts[(key.first >> (8 * pass)) & 255]++] = key;
+        }
+        keys.swap(buffer);
+    }
+}
+
+// Sorts the staged records by course ID and fills the hash indexes from
+// them, sized once. The sort is stable, so an ID loaded more than once keeps
+// its records in load order and its last record indexed, as tree inserts
+// would. Packed keys order IDs as their strings do, so when every ID packs
+// the sort and the index use integers instead of reaching into each record,
+// and the sorted keys are returned for the layout; otherwise none are
+vector<uint64_t> BinarySearchTree::sortStaged() {
+    vector<pair<uint64_t, size_t>> keys(staged.size());
+    for (size_t i = 0; i < staged.size(); ++i) {
+        keys[i] = { packCourseId(staged[i]->courseId), i };
+        if (keys[i].first == unpackedKey) {
+            stable_sort(staged.begin(), staged.end(),
+                [](const shared_ptr<const Course>& a, const shared_ptr<const Course>& b) {
+                    return a->courseId < b->courseId;
+                });
+            for (const auto& record : staged) {
+                uint64_t key = packCourseId(record->courseId);
+                if (key != unpackedKey) {
+                    packedMap.insert_or_assign(key, CourseEntry{ record.get() });
+                }
+                else {
+                    courseMap.insert_or_assign(record->courseId, CourseEntry{ record.get() });
+                }
+            }
+            return {};
+        }
+    }
+
+    // Equal keys keep load order
+    radixSortKeys(keys);
+    vector<shared_ptr<const Course>> sorted;
+    sorted.reserve(staged.size());
+    vector<uint64_t> sortedKeys;
+    sortedKeys.reserve(staged.size());
+    packedMap.reserve(staged.size());
+    for (const auto& key : keys) {
+        packedMap.insert_or_assign(key.first, CourseEntry{ staged[key.second].get() });
+        sorted.push_back(move(staged[key.second]));
+        sortedKeys.push_back(key.first);
+    }
+    staged.swap(sorted);
+    return sortedKeys;
+}
+
+// Looks up a course's index entry by packed key, or by string for long IDs
+const CourseEntry* BinarySearchTree::findEntry(const string& courseId) const {
+    return findEntry(courseId, packCourseId(courseId));
+}
+
+const CourseEntry* BinarySearchTree::findEntry(const string& courseId, uint64_t key) const {
+    if (key != unpackedKey) {
+        auto it = packedMap.find(key);
+        return (it != packedMap.end()) ? &it->second : nullptr;
+    }
+    auto it = courseMap.find(courseId);
+    return (it != courseMap.end()) ? &it->second : nullptr;
+}
+
+// Consults the missing-ID filter; false means the course is certainly absent
+bool BinarySearchTree::filterPasses(const string& courseId, uint64_t key) const {
+    if (!idFilter.IsBuilt()) return true;
+    bool passes = idFilter.MayContain(CourseIdFilter::Hash(courseId, key));
+    filterCounters.CountLookup(!passes);
+    return passes;
+}
+
+// O(1) course lookup using hash map; definite misses never reach the index
+const Course* BinarySearchTree::FindCourse(const string& courseId) const {
+    uint64_t key = packCourseId(courseId);
+    if (!filterPasses(courseId, key)) return nullptr;
+
+    const CourseEntry* entry = findEntry(courseId, key);
+    if (!entry && idFilter.IsBuilt()) filterCounters.CountFalsePositive();
+    return entry ? entry->course : nullptr;
+}
+
+// O(log n) lookup through the ordered index, for comparison with other indexes
+const Course* BinarySearchTree::FindInTree(const string& courseId) const {
+    uint64_t key = packCourseId(courseId);
+    if (frozen) {
+        size_t slot = frozenLowerBound(courseId, key);
+        return (slot != 0 && frozenRecords[slot]->courseId == courseId) ? frozenRecords[slot].get() : nullptr;
+    }
+
+    const Node* node = root.get();
+    while (node) {
+        bool found = (key != unpackedKey) ? key == node->key : courseId == node->course->courseId;
+        if (found) return node->course.get();
+        node = courseIdLess(key, courseId, node->key, node->course->courseId) ? node->left.get() : node->right.get();
+    }
+    return nullptr;
+}
+
+// Prepares a complete catalog for prerequisite analysis. Forward edges are
+// the records' own prerequisite lists, so only the missing-ID filter is built
+// here; reverse edges wait until a query asks for dependents
+void BinarySearchTree::BuildDependencyGraph() {
+    TraceSpan span("BuildDependencyGraph", "load");
+    // The catalog is complete, so the missing-ID filter can be built. A
+    // frozen catalog that packed every ID, none of them twice, holds the keys
+    // in one array, so no record needs to be read
+    vector<uint64_t> hashes;
+    hashes.reserve(Size());
+    if (frozen && frozenPacked && frozenKeys.size() == Size() + 1) {
+        for (size_t slot = 1; slot < frozenKeys.size(); ++slot) {
+            hashes.push_back(CourseIdFilter::Mix(frozenKeys[slot]));
+        }
+    }
+    else {
+        forEachEntry([&hashes](CourseEntry& entry) {
+            const string& courseId = entry.course->courseId;
+            hashes.push_back(CourseIdFilter::Hash(courseId, packCourseId(courseId)));
+        });
+    }
+    idFilter.Build(hashes);
+    dropDependents();
+}
+
+// Returns the reverse prerequisite edges, building them exactly once even
+// when several readers ask at the same time
+const DependentIndex& BinarySearchTree::dependents() const {
+    const DependentIndex* index = dependentIndex.load(memory_order_acquire);
+    if (index) return *index;
+
+    lock_guard<mutex> lock(dependentMutex);
+    if (!dependentStorage) {
+        TraceSpan span("Build dependents", "query");
+        auto built = make_unique<DependentIndex>(DependentIndex::allocator_type(&dependentMemory));
+        forEachEntry([this, &built](const CourseEntry& entry) {
+            const Course* course = entry.course;
+            for (const auto& prereqId : course->prereqs) {
+                const CourseEntry* prereq = findEntry(prereqId);
+                if (prereq) {
+                    (*built)[prereq->course].push_back(course);
+                }
+            }
+        });
+        dependentStorage = move(built);
+        dependentIndex.store(dependentStorage.get(), memory_order_release);
+    }
+    return *dependentStorage;
+}
+
+// Discards the reverse edges after the catalog changes; callers hold the
+// catalog exclusively, so no reader can be using them
+void BinarySearchTree::dropDependents() {
+    dependentIndex.store(nullptr, memory_order_relaxed);
+    dependentStorage.reset();
+}
+
+// Returns the courses that list the given course as a prerequisite
+vector<const Course*> BinarySearchTree::GetDependents(const string& courseId) const {
+    const Course* course = FindCourse(courseId);
+    return course ? dependentsOf(course) : vector<const Course*>();
+}
+
+// Looks up the next batch of prerequisites before any of them is walked. The
+// hash probes do not depend on each other, so they overlap, and each record
+// found is prefetched while the walk is still busy with its earlier siblings.
+// Prerequisites were validated at load, so the walk skips the missing-ID
+// filter. Returns the number of entries written, null for unknown prerequisites
+size_t BinarySearchTree::resolvePrerequisites(const CourseIdList& prereqs, size_t first,
+    const Course** resolved) const {
+    size_t count = min(prefetchBatch, prereqs.size() - first);
+    for (size_t i = 0; i < count; ++i) {
+        const CourseEntry* entry = findEntry(prereqs[first + i]);
+        resolved[i] = entry ? entry->course : nullptr;
+        if (resolved[i]) {
+            prefetchRead(resolved[i]);
+            prefetchRead(&resolved[i]->prereqs);
+        }
+    }
+    return count;
+}
+
+// Recursive DFS to detect cycles in prerequisite relationships
+bool BinarySearchTree::hasCycle(const Course* course,
+    ScratchSet& visited,
+    ScratchSet& recursionStack) const {
+    if (!course) return false;
+
+    // Mark current course as visited and add to recursion stack
+    visited.insert(course->courseId);
+    recursionStack.insert(course->courseId);
+
+    // Check all prerequisites for cycles, a batch at a time
+    const CourseIdList& prereqs = course->prereqs;
+    const Course* resolved[prefetchBatch];
+    for (size_t first = 0; first < prereqs.size(); first += prefetchBatch) {
+        size_t count = resolvePrerequisites(prereqs, first, resolved);
+        for (size_t i = 0; i < count; ++i) {
+            const Course* prereq = resolved[i];
+            if (!prereq) continue;
+            const string& prereqId = prereqs[first + i];
+
+            // If course is in recursion stack, found a cycle
+            if (recursionStack.find(prereqId) != recursionStack.end()) {
+                return true;
+            }
+
+            // Continue DFS if course hasn't been visited
+            if (visited.find(prereqId) == visited.end()) {
+                if (hasCycle(prereq, visited, recursionStack)) {
+                    return true;
+                }
+            }
+        }
+    }
+
+    // Remove course from recursion stack when backtracking
+    recursionStack.erase(course->courseId);
+    return false;
+}
+
+// Public interface for cycle detection
+bool BinarySearchTree::HasPrerequisiteCycle(const string& courseId) const {
+    TraceSpan span("HasPrerequisiteCycle", "query");
+    QueryTimer timer(QueryType::Validate);
+    const Course* course = FindCourse(courseId);
+    if (!course) {
+        throw invalid_argument("Course not found: " + courseId);
+    }
+
+    CountingAllocator<string> scratch = beginQuery(QueryType::Validate);
+    if (graph) return graphHasCycle(course);
+    ScratchSet visited(scratch);
+    ScratchSet recursionStack(scratch);
+    return hasCycle(course, visited, recursionStack);
+}
+
+// Helper function for topological sort using DFS
+void BinarySearchTree::topologicalSortUtil(const Course* course,
+    ScratchSet& visited,
+    ScratchStack& Stack) const {
+    visited.insert(course->courseId);
+
+    // Recursively visit all prerequisites, a batch at a time
+    const CourseIdList& prereqs = course->prereqs;
+    const Course* resolved[prefetchBatch];
+    for (size_t first = 0; first < prereqs.size(); first += prefetchBatch) {
+        size_t count = resolvePrerequisites(prereqs, first, resolved);
+        for (size_t i = 0; i < count; ++i) {
+            if (resolved[i] && visited.find(prereqs[first + i]) == visited.end()) {
+                topologicalSortUtil(resolved[i], visited, Stack);
+            }
+        }
+    }
+
+    // Push current course to stack after visiting all prerequisites
+    Stack.push(course);
+}
+
+// Returns prerequisites in order they should be taken
+vector<const Course*> BinarySearchTree::GetPrerequisiteOrder(const string& courseId) const {
+    TraceSpan span("GetPrerequisiteOrder", "query");
+    QueryTimer timer(QueryType::PrerequisitePath);
+    const Course* course = FindCourse(courseId);
+    if (!course) {
+        throw invalid_argument("Course not found: " + courseId);
+    }
+
+    CountingAllocator<string> scratch = beginQuery(QueryType::PrerequisitePath);
+    if (graph) return graphPrerequisiteOrder(course);
+
+    // Verify no cycles exist before attempting topological sort
+    {
+        ScratchSet cycleVisited(scratch);
+        ScratchSet recursionStack(scratch);
+        if (hasCycle(course, cycleVisited, recursionStack)) {
+            throw runtime_error("Circular prerequisite dependency detected for: " + courseId);
+        }
+    }
+
+    ScratchSet visited(scratch);
+    ScratchStack Stack{ CountingAllocator<const Course*>(scratch) };
+    vector<const Course*> result;
+
+    // Process each prerequisite
+    const Course* resolved[prefetchBatch];
+    for (size_t first = 0; first < course->prereqs.size(); first += prefetchBatch) {
+        size_t count = resolvePrerequisites(course->prereqs, first, resolved);
+        for (size_t i = 0; i < count; ++i) {
+            if (resolved[i] && visited.find(course->prereqs[first + i]) == visited.end()) {
+                topologicalSortUtil(resolved[i], visited, Stack);
+            }
+        }
+    }
+
+    // Convert stack to vector and reverse for proper order
+    while (!Stack.empty()) {
+        result.push_back(Stack.top());
+        Stack.pop();
+    }
+
+    reverse(result.begin(), result.end());
+    return result;
+}
+
+// Validates prerequisites for all courses in the catalog
+bool BinarySearchTree::ValidateAllPrerequisites() const {
+    TraceSpan span("ValidateAllPrerequisites", "load");
+    if (graph) return graphPrerequisitesValid();
+    bool valid = true;
+    forEachEntry([this, &valid](const CourseEntry& entry) {
+        if (!valid) return;
+        try {
+            validatePrerequisites(entry.course);
+        }
+        catch (const runtime_error& e) {
+            cerr << "Validation error: " << e.what() << endl;
+            valid = false;
+        }
+    });
+    return valid;
+}
+
+// Displays complete course catalog in alphabetical order
+void BinarySearchTree::PrintSampleSchedule() const {
+    TraceSpan span("PrintSampleSchedule", "query");
+    printSubHeader("Complete Course Catalog");
+    cout << "    COURSE ID  | COURSE TITLE" << endl;
+    cout << "  " << string(73, '-') << endl;
+
+    if (Size() == 0) {
+        cout << "    No courses available." << endl;
+        return;
+    }
+
+    // Perform in-order traversal to print courses alphabetically. Rows are
+    // gathered and written a chunk at a time rather than flushed one by one
+    const size_t chunkBytes = 64 * 1024;
+    string text;
+    text.reserve(chunkBytes + 256);
+    ForEachRecord([&text](const shared_ptr<const Course>& course) {
+        const string& courseId = course->courseId;
+        text.append("    ").append(courseId);
+        if (courseId.size() < 10) text.append(10 - courseId.size(), ' ');
+        text.append(" | ").append(course->courseTitle.view()).append("\n");
+        if (text.size() >= chunkBytes) {
+            cout << text;
+            text.clear();
+        }
+    });
+    cout << text << "\n    End of course catalog.\n" << endl;
+    printLine();
+}
+
+// Public interface for course information display; the course is found
+// through the ordered index, frozen or not
+void BinarySearchTree::PrintCourseInformation(const string& courseId) const {
+    TraceSpan span("PrintCourseInformation", "query");
+    if (Size() == 0) {
+        cout << "No courses available." << endl;
+        return;
+    }
+
+    // Only the lookup is timed, so console output stays out of the histogram
+    const Course* course = nullptr;
+    uint32_t handle = UINT32_MAX;
+    {
+        QueryTimer timer(QueryType::Search);
+        beginQuery(QueryType::Search);
+        uint64_t key = packCourseId(courseId);
+        course = filterPasses(courseId, key) ? findCourse(courseId, handle) : nullptr;
+    }
+    if (!course) {
+        thread_local string message;
+        message.assign("Course ").append(courseId).append(" not found");
+        printError(message);
+        return;
+    }
+    printCourseInformation(course, handle);
+}
+
+// Displays detailed information for a specific course. The details are
+// built in one string and written at once: they are a dozen short lines, and
+// each stream insertion costs more than finding the course did. The string
+// is kept per thread, so repeated searches reuse its buffer
+void BinarySearchTree::printCourseInformation(const Course* course, uint32_t handle) const {
+    static const string header = subHeaderText("Course Details");
+    static const string footer = "\n" + lineText();
+    thread_local string text;
+    text.assign(header);
+    text.append("    Course ID:   ").append(course->courseId);
+    text.append("\n    Title:       ").append(course->courseTitle.view());
+    text.append("\n    Prerequisites:\n");
+
+    // Display prerequisites or "None" if empty
+    if (course->prereqs.empty()) {
+        text.append("        None\n");
+    }
+    else {
+        for (const auto& prereq : course->prereqs) {
+            text.append("        - ").append(prereq).append("\n");
+        }
+    }
+
+    // Display courses that require this course
+    text.append("    Required by:\n");
+    appendDependents(course, handle, text);
+    text.append(footer);
+    cout << text << flush;
+}
+
+//============================================================================
+// Frozen catalog layout
+// A loaded catalog no longer changes, so its records are laid out as an
+// implicit tree in one array, in Eytzinger (BFS) order: the children of slot
+// k are slots 2k and 2k+1. Searches walk the array without branching on the
+// comparison and prefetch the grandchildren four slots at a time
+//============================================================================
+
+// Lays out the catalog and releases the pointer tree
+void BinarySearchTree::Freeze() {
+    if (frozen) return;
+    TraceSpan span("Freeze", "load");
+    if (staging) {
+        staging = false;
+        vector<uint64_t> keys = sortStaged();
+        freezeSorted(staged, keys);
+        staged = vector<shared_ptr<const Course>>();
+        return;
+    }
+
+    vector<shared_ptr<const Course>> sorted;
+    sorted.reserve(Size());
+    forEachRecord(root.get(), [&sorted](const shared_ptr<const Course>& record) {
+        sorted.push_back(record);
+    });
+    destroyTree(root);
+    freezeSorted(sorted);
+}
+
+// Lays out records already in course ID order. keys, when given, are their
+// packed IDs, so the layout need not read the records in tree order
+void BinarySearchTree::freezeSorted(vector<shared_ptr<const Course>>& sorted, const vector<uint64_t>& keys) {
+    frozenRecords.assign(sorted.size() + 1, nullptr);
+    frozenKeys.assign(sorted.size() + 1, unpackedKey);
+    size_t next = 0;
+    layoutFrozen(sorted, keys, next, 1);
+
+    frozenPacked = true;
+    for (size_t slot = 1; slot < frozenKeys.size(); ++slot) {
+        if (frozenKeys[slot] == unpackedKey) frozenPacked = false;
+    }
+    frozen = true;
+}
+
+// Fills the slots by in-order traversal of the implicit tree
+void BinarySearchTree::layoutFrozen(vector<shared_ptr<const Course>>& sorted, const vector<uint64_t>& keys,
+    size_t& next, size_t slot) {
+    if (slot >= frozenRecords.size()) return;
+    layoutFrozen(sorted, keys, next, 2 * slot);
+    frozenKeys[slot] = keys.empty() ? packCourseId(sorted[next]->courseId) : keys[next];
+    frozenRecords[slot] = move(sorted[next++]);
+    layoutFrozen(sorted, keys, next, 2 * slot + 1);
+}
+
+void BinarySearchTree::forEachFrozen(size_t slot, const function<void(const shared_ptr<const Course>&)>& visit) const {
+    if (slot >= frozenRecords.size()) return;
+    forEachFrozen(2 * slot, visit);
+    visit(frozenRecords[slot]);
+    forEachFrozen(2 * slot + 1, visit);
+}
+
+void BinarySearchTree::forEachFrozenKeyed(size_t slot, const function<void(uint64_t, const Course*)>& visit) const {
+    if (slot >= frozenRecords.size()) return;
+    forEachFrozenKeyed(2 * slot, visit);
+    visit(frozenKeys[slot], frozenRecords[slot].get());
+    forEachFrozenKeyed(2 * slot + 1, visit);
+}
+
+// Returns the slot of the first record not less than the ID, or 0. Every
+// comparison only picks the next slot, and after the walk the trailing right
+// turns are undone to recover the last left turn
+size_t BinarySearchTree::frozenLowerBound(const string& courseId, uint64_t key) const {
+    size_t count = frozenRecords.size() - 1;
+    size_t slot = 1;
+    if (frozenPacked) {
+        // A catalog of packed IDs cannot contain an ID that does not pack
+        if (key == unpackedKey) return 0;
+        const uint64_t* keys = frozenKeys.data();
+        while (slot <= count) {
+            prefetchRead(keys + 4 * slot);
+            slot = 2 * slot + (keys[slot] < key);
+        }
+    }
+    else {
+        const shared_ptr<const Course>* records = frozenRecords.data();
+        while (slot <= count) {
+            prefetchRead(records + 4 * slot);
+            slot = 2 * slot + (records[slot]->courseId < courseId);
+        }
+    }
+    while (slot & 1) slot >>= 1;
+    return slot >> 1;
+}
+
+// Rebuilds a balanced pointer tree from a frozen layout before an insert
+void BinarySearchTree::thaw() {
+    vector<shared_ptr<const Course>> sorted;
+    sorted.reserve(frozenRecords.size());
+    forEachFrozen(1, [&sorted](const shared_ptr<const Course>& record) {
+        sorted.push_back(record);
+    });
+    root = buildBalanced(sorted, 0, sorted.size());
+
+    frozenRecords = vector<shared_ptr<const Course>>();
+    frozenKeys = vector<uint64_t>();
+    frozen = false;
+}
+
+unique_ptr<Node> BinarySearchTree::buildBalanced(vector<shared_ptr<const Course>>& sorted, size_t first, size_t last) {
+    if (first >= last) return nullptr;
+    size_t middle = first + (last - first) / 2;
+    uint64_t key = packCourseId(sorted[middle]->courseId);
+    unique_ptr<Node> node = make_unique<Node>(move(sorted[middle]), key);
+    node->left = buildBalanced(sorted, first, middle);
+    node->right = buildBalanced(sorted, middle + 1, last);
+    return node;
+}
+
+// Fills an empty catalog with another catalog's records, some replaced or
+// removed. The base is already in course ID order, so the changes are merged
+// in and laid out frozen without inserting record by record. Only the
+// changed records have their prerequisites validated
+bool BinarySearchTree::LoadChanged(const BinarySearchTree& base,
+    const vector<shared_ptr<const Course>>& upserts, const vector<string>& removals) {
+    TraceSpan span("LoadChanged", "load");
+    if (Size() != 0) {
+        throw logic_error("LoadChanged needs an empty catalog");
+    }
+
+    auto byId = [](const shared_ptr<const Course>& a, const shared_ptr<const Course>& b) {
+        return a->courseId < b->courseId;
+    };
+    vector<shared_ptr<const Course>> changed(upserts);
+    sort(changed.begin(), changed.end(), byId);
+    vector<string> removed(removals);
+    sort(removed.begin(), removed.end());
+
+    vector<shared_ptr<const Course>> sorted;
+    sorted.reserve(base.Size() + changed.size());
+    size_t next = 0;
+    base.ForEachRecord([&](const shared_ptr<const Course>& record) {
+        while (next < changed.size() && changed[next]->courseId < record->courseId) {
+            sorted.push_back(changed[next++]);
+        }
+        if (next < changed.size() && changed[next]->courseId == record->courseId) {
+            sorted.push_back(changed[next++]);
+        }
+        else if (!binary_search(removed.begin(), removed.end(), record->courseId)) {
+            sorted.push_back(record);
+        }
+    });
+    sorted.insert(sorted.end(), changed.begin() + next, changed.end());
+
+    for (const auto& record : sorted) {
+        uint64_t key = packCourseId(record->courseId);
+        if (key != unpackedKey) {
+            packedMap.insert_or_assign(key, CourseEntry{ record.get() });
+        }
+        else {
+            courseMap.insert_or_assign(record->courseId, CourseEntry{ record.get() });
+        }
+    }
+    freezeSorted(sorted);
+    BuildDependencyGraph();
+
+    bool valid = true;
+    for (const auto& record : changed) {
+        try {
+            validatePrerequisites(record.get());
+        }
+        catch (const runtime_error& e) {
+            cerr << "Validation error: " << e.what() << endl;
+            valid = false;
+        }
+    }
+    return valid;
+}
+
+//============================================================================
+// Memory accounting
+// Reports retained memory by subsystem and scratch memory by query type
+//============================================================================
+
+// Counts a query and returns an allocator charging its scratch memory
+CountingAllocator<string> BinarySearchTree::beginQuery(QueryType type) const {
+    size_t index = static_cast<size_t>(type);
+    queryCalls[index].fetch_add(1, memory_order_relaxed);
+    return CountingAllocator<string>(&queryMemory[index]);
+}
+
+// Helper function that adds one course and its prerequisites to the totals.
+// Records shared with other catalogs are counted in each of them; source
+// text shared by several titles is counted once
+void BinarySearchTree::collectMemoryUsage(const Course* course, vector<MemoryUsage>& usage,
+    unordered_set<const SourceText*>& sources) const {
+    usage[1].objects++;
+    usage[1].bytes += sizeof(Course);
+
+    size_t bytes = stringHeapBytes(course->courseId);
+    if (bytes > 0) {
+        usage[3].objects++;
+        usage[3].bytes += bytes;
+    }
+
+    const SourceText* source = course->courseTitle.owner();
+    if (source && sources.insert(source).second) {
+        usage[7].objects++;
+        usage[7].bytes += source->HeapBytes();
+    }
+
+    usage[4].objects += course->prereqs.size();
+    usage[4].bytes += stringListHeapBytes(course->prereqs);
+}
+
+// Returns the memory retained by the loaded catalog, by subsystem. Sizes are
+// the bytes requested from the allocator; allocator overhead is not included
+vector<MemoryUsage> BinarySearchTree::GetMemoryUsage() const {
+    vector<MemoryUsage> usage = {
+        { frozen ? "Ordered index (frozen)" : "BST nodes", 0, 0 },
+        { "Course records", 0, 0 },
+        { "Course index (hash maps)", 0, 0 },
+        { "Course ID strings", 0, 0 },
+        { "Prerequisite lists", 0, 0 },
+        { "Dependent course lists", 0, 0 },
+        { "Missing-ID filter", idFilter.Keys(), idFilter.Bytes() },
+        { "Title source text", 0, 0 },
+        { "Prerequisite graph", 0, 0 }
+    };
+
+    unordered_set<const SourceText*> sources;
+    ForEachRecord([this, &usage, &sources](const shared_ptr<const Course>& record) {
+        collectMemoryUsage(record.get(), usage, sources);
+    });
+
+    // One node per record, or one slot of each frozen array per record
+    usage[0].objects = usage[1].objects;
+    usage[0].bytes = frozen ?
+        frozenRecords.capacity() * sizeof(shared_ptr<const Course>) + frozenKeys.capacity() * sizeof(uint64_t) :
+        usage[0].objects * sizeof(Node);
+
+    // Buckets and entries are counted exactly by the index allocator; packed
+    // keys are stored inline, and only string keys too long for the
+    // small-string buffer own a further allocation
+    usage[2].objects = Size();
+    usage[2].bytes = indexMemory.liveBytes.load(memory_order_relaxed);
+    for (const auto& pair : courseMap) {
+        usage[2].bytes += stringHeapBytes(pair.first);
+    }
+
+    // Reverse edges count only once a query has built them
+    countGraphMemory(usage);
+    if (const DependentIndex* index = dependentIndex.load(memory_order_acquire)) {
+        usage[5].bytes = dependentMemory.liveBytes.load(memory_order_relaxed);
+        for (const auto& pair : *index) {
+            usage[5].objects += pair.second.size();
+            usage[5].bytes += pair.second.heapBytes();
+        }
+    }
+    return usage;
+}
+
+// Returns the scratch memory used by each query type so far
+vector<QueryMemoryUsage> BinarySearchTree::GetQueryMemoryUsage() const {
+    vector<QueryMemoryUsage> usage;
+    for (size_t i = 0; i < queryTypeCount; ++i) {
+        usage.push_back({ queryTypeNames[i],
+            queryCalls[i].load(memory_order_relaxed),
+            queryMemory[i].totalAllocations.load(memory_order_relaxed),
+            queryMemory[i].totalBytes.load(memory_order_relaxed),
+            queryMemory[i].peakBytes.load(memory_order_relaxed),
+            queryMemory[i].liveBytes.load(memory_order_relaxed) });
+    }
+    return usage;
+}
+
+// Displays retained memory by subsystem and scratch memory by query type
+void BinarySearchTree::PrintMemoryReport() const {
+    printSubHeader("Memory Usage Report");
+    cout << "    " << setw(30) << left << "SUBSYSTEM"
+        << " | " << setw(10) << right << "OBJECTS"
+        << " | " << setw(12) << right << "BYTES" << endl;
+    cout << "  " << string(73, '-') << endl;
+
+    size_t totalBytes = 0;
+    for (const auto& usage : GetMemoryUsage()) {
+        cout << "    " << setw(30) << left << usage.subsystem
+            << " | " << setw(10) << right << usage.objects
+            << " | " << setw(12) << right << usage.bytes << endl;
+        totalBytes += usage.bytes;
+    }
+    cout << "    " << setw(30) << left << "Total retained"
+        << " | " << setw(10) << right << ""
+        << " | " << setw(12) << right << totalBytes << endl;
+
+    cout << "\n    Query scratch memory (released when each query returns):" << endl;
+    cout << "    " << setw(18) << left << "QUERY TYPE"
+        << " | " << setw(7) << right << "CALLS"
+        << " | " << setw(11) << right << "ALLOCATIONS"
+        << " | " << setw(12) << right << "TOTAL BYTES"
+        << " | " << setw(10) << right << "PEAK BYTES" << endl;
+    cout << "  " << string(73, '-') << endl;
+    for (const auto& usage : GetQueryMemoryUsage()) {
+        cout << "    " << setw(18) << left << usage.queryType
+            << " | " << setw(7) << right << usage.calls
+            << " | " << setw(11) << right << usage.allocations
+            << " | " << setw(12) << right << usage.totalBytes
+            << " | " << setw(10) << right << usage.peakBytes << endl;
+    }
+
+    // Rates are formatted separately so cout keeps its default float format
+    FilterStats filter = GetFilterStats();
+    ostringstream expected;
+    expected << fixed << setprecision(3) << filter.expectedFalsePositiveRate * 100.0;
+    cout << "\n    Missing-ID filter: " << filter.keys << " IDs in " << filter.bytes << " bytes, expected "
+        << expected.str() << "% false positives" << endl;
+    cout << "    " << filter.lookups << " lookups, " << filter.rejected << " rejected by the filter, "
+        << filter.falsePositives << " false positives";
+    size_t absentLookups = filter.rejected + filter.falsePositives;
+    if (absentLookups > 0) {
+        ostringstream observed;
+        observed << fixed << setprecision(3) << 100.0 * filter.falsePositives / absentLookups;
+        cout << " (" << observed.str() << "% of absent IDs)";
+    }
+    cout << endl << endl;
+    printLine();
+}
+
+// Filter size, estimated false-positive rate and counters since load
+FilterStats BinarySearchTree::GetFilterStats() const {
+    return FilterStats{ idFilter.Keys(), idFilter.Bytes(), idFilter.ExpectedFalsePositiveRate(),
+        filterCounters.Lookups(), filterCounters.Rejects(), filterCounters.FalsePositives() };
+}
+
+//============================================================================
+// File loading functions
+// Reads course data in CSV format and populates the BST. A catalog that fits
+// in one block is parsed and inserted on the calling thread; larger feeds go
+// through the import pipeline so reading, parsing and indexing overlap
+//============================================================================
+
+// Bytes read from the input at a time
+const size_t loaderBlockBytes = size_t(1) << 20;
+
+// Splits one CSV line of source text into a course; returns false for lines
+// with fewer than two fields. The field vector is reused for every line, and
+// the title stays a view into the source, so a course costs only the
+// allocations for the ID and prerequisite storage it keeps
+bool parseCourseLine(string_view line, const shared_ptr<const SourceText>& source,
+    vector<string_view>& fields, Course& course) {
+    fields.clear();
+    size_t start = 0;
+    size_t end = line.find(',');
+    while (end != string_view::npos) {
+        fields.push_back(line.substr(start, end - start));
+        start = end + 1;
+        end = line.find(',', start);
+    }
+    fields.push_back(line.substr(start));
+
+    // Skip invalid lines
+    if (fields.size() < 2) return false;
+
+    course = Course(string(fields[0]), CourseTitle(source, fields[1]));
+    course.prereqs.reserve(fields.size() - 2);
+    for (size_t i = 2; i < fields.size(); ++i) {
+        if (!fields[i].empty()) {
+            course.prereqs.emplace_back(fields[i]);
+        }
+    }
+    return true;
+}
+
+// Calls visit for every non-empty line of a block, without its line ending.
+// Input is read in binary mode, so a CRLF line ending is removed here
+template <typename Visit>
+void forEachLine(string_view block, Visit visit) {
+    size_t start = 0;
+    while (start < block.size()) {
+        size_t end = block.find('\n', start);
+        if (end == string_view::npos) end = block.size();
+        size_t lineEnd = (end > start && block[end - 1] == '\r') ? end - 1 : end;
+        if (lineEnd > start) visit(block.substr(start, lineEnd - start));
+        start = end + 1;
+    }
+}
+
+// Reads the next block of whole lines. Bytes after the block's last newline
+// are carried over to the next block, and a line longer than a block grows
+// the block until it ends. At the end of the input the block holds the rest,
+// and the input stream is left failed. Returns false once nothing is left
+bool readCatalogBlock(istream& inputFile, string& carry, string& block, size_t blockBytes) {
+    TraceSpan span("Read block", "load");
+    block.swap(carry);
+    carry.clear();
+    while (inputFile) {
+        size_t filled = block.size();
+        block.resize(filled + blockBytes);
+        inputFile.read(&block[filled], static_cast<streamsize>(blockBytes));
+        block.resize(filled + static_cast<size_t>(inputFile.gcount()));
+        if (!inputFile) break;
+
+        size_t lastNewline = block.find_last_of('\n');
+        if (lastNewline != string::npos) {
+            carry.assign(block, lastNewline + 1, string::npos);
+            block.resize(lastNewline + 1);
+            return true;
+        }
+    }
+    return !block.empty();
+}
+
+// Lines of the input, numbered in file order, and the source they are in
+struct CatalogBlock {
+    size_t sequence = 0;
+    shared_ptr<const SourceText> source;
+    string_view text;
+};
+
+// Cuts one input into blocks of whole lines
+class CatalogBlockReader {
+public:
+    virtual ~CatalogBlockReader() = default;
+
+    // Fills the next block; returns false once nothing is left
+    virtual bool Next(CatalogBlock& block) = 0;
+
+    // True once the last block has been returned
+    virtual bool Done() const = 0;
+};
+
+// Reads a stream into blocks, each kept as the source of its titles
+class StreamBlockReader : public CatalogBlockReader {
+private:
+    istream& input;
+    size_t blockBytes;
+    string carry;
+
+public:
+    // Starts with any bytes the caller already read from the stream
+    StreamBlockReader(istream& inputFile, size_t bytesPerBlock, string leading = string()) :
+        input(inputFile),
+        blockBytes(bytesPerBlock),
+        carry(move(leading)) {}
+
+    bool Next(CatalogBlock& block) override {
+        string text;
+        if (!readCatalogBlock(input, carry, text, blockBytes)) return false;
+
+        // Titles keep the block alive, so a short last block gives back the
+        // unused part of its buffer
+        if (text.capacity() > text.size() + text.size() / 8) {
+            text.shrink_to_fit();
+        }
+        block.source = make_shared<const SourceText>(move(text));
+        block.text = block.source->Text();
+        return true;
+    }
+
+    bool Done() const override { return !input; }
+};
+
+// Cuts a mapped file into blocks without copying it; a block ends at the
+// last newline within blockBytes, or at the first one after a longer line
+class MappedBlockReader : public CatalogBlockReader {
+private:
+    shared_ptr<const SourceText> source;
+    size_t blockBytes;
+    size_t offset = 0;
+
+public:
+    MappedBlockReader(shared_ptr<const SourceText> mapped, size_t bytesPerBlock) :
+        source(move(mapped)),
+        blockBytes(bytesPerBlock) {}
+
+    bool Next(CatalogBlock& block) override {
+        TraceSpan span("Read block", "load");
+        string_view text = source->Text();
+        if (offset >= text.size()) return false;
+
+        size_t end = text.size();
+        if (text.size() - offset > blockBytes) {
+            size_t newline = text.rfind('\n', offset + blockBytes - 1);
+            if (newline == string_view::npos || newline < offset) {
+                newline = text.find('\n', offset + blockBytes);
+            }
+            if (newline != string_view::npos) end = newline + 1;
+        }
+
+        block.source = source;
+        block.text = text.substr(offset, end - offset);
+        offset = end;
+        return true;
+    }
+
+    bool Done() const override { return offset >= source->Text().size(); }
+};
+
+// Compression formats recognised by their leading magic bytes
+enum class CatalogCompression { None, Gzip, Zstd };
+
+const size_t compressionMagicBytes = 4;
+const size_t compressedChunkBytes = size_t(1) << 18;
+
+inline CatalogCompression detectCompression(string_view leading) {
+    if (leading.size() >= 2 && leading[0] == '\x1f' && leading[1] == '\x8b') return CatalogCompression::Gzip;
+    if (leading.size() >= 4 && leading.substr(0, 4) == string_view("\x28\xb5\x2f\xfd", 4)) return CatalogCompression::Zstd;
+    return CatalogCompression::None;
+}
+
+inline const char* compressionName(CatalogCompression compression) {
+    return compression == CatalogCompression::Gzip ? "gzip" : compression == CatalogCompression::Zstd ? "zstd" : "plain";
+}
+
+// Decompresses one input incrementally. Decode consumes a prefix of the
+// input and appends at most limit bytes of output, returning how many it
+// appended; corrupt data throws
+class StreamDecoder {
+public:
+    virtual ~StreamDecoder() = default;
+    virtual size_t Decode(string_view& input, string& output, size_t limit) = 0;
+
+    // True when the input so far ends exactly at the end of a stream
+    virtual bool Finished() const = 0;
+};
+
+#ifdef ENHANCEMENT_TWO_GZIP
+// gzip through zlib; concatenated members are read as one stream
+class GzipDecoder : public StreamDecoder {
+private:
+    z_stream stream{};
+    bool finished = false;
+
+public:
+    GzipDecoder() {
+        if (inflateInit2(&stream, 15 + 16) != Z_OK) throw runtime_error("Unable to start gzip decompression");
+    }
+
+    ~GzipDecoder() override { inflateEnd(&stream); }
+
+    GzipDecoder(const GzipDecoder&) = delete;
+    GzipDecoder& operator=(const GzipDecoder&) = delete;
+
+    size_t Decode(string_view& input, string& output, size_t limit) override {
+        if (finished) {
+            if (input.empty()) return 0;
+            inflateReset(&stream);
+            finished = false;
+        }
+
+        size_t available = min<size_t>(input.size(), 1u << 30);
+        limit = min<size_t>(limit, 1u << 30);
+        size_t filled = output.size();
+        output.resize(filled + limit);
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+        stream.avail_in = static_cast<uInt>(available);
+        stream.next_out = reinterpret_cast<Bytef*>(&output[filled]);
+        stream.avail_out = static_cast<uInt>(limit);
+
+        int status = inflate(&stream, Z_NO_FLUSH);
+        input.remove_prefix(available - stream.avail_in);
+        size_t produced = limit - stream.avail_out;
+        output.resize(filled + produced);
+
+        if (status == Z_STREAM_END) {
+            finished = true;
+        }
+        else if (status != Z_OK && status != Z_BUF_ERROR) {
+            throw runtime_error(string("Corrupt gzip data: ") + (stream.msg ? stream.msg : "inflate failed"));
+        }
+        return produced;
+    }
+
+    bool Finished() const override { return finished; }
+};
+#endif
+
+#ifdef ENHANCEMENT_TWO_ZSTD
+// Zstandard through libzstd; concatenated frames are read as one stream
+class ZstdDecoder : public StreamDecoder {
+private:
+    ZSTD_DStream* stream;
+    bool finished = false;
+
+public:
+    ZstdDecoder() : stream(ZSTD_createDStream()) {
+        if (!stream) throw runtime_error("Unable to start zstd decompression");
+        ZSTD_initDStream(stream);
+    }
+
+    ~ZstdDecoder() override { ZSTD_freeDStream(stream); }
+
+    ZstdDecoder(const ZstdDecoder&) = delete;
+    ZstdDecoder& operator=(const ZstdDecoder&) = delete;
+
+    size_t Decode(string_view& input, string& output, size_t limit) override {
+        size_t filled = output.size();
+        output.resize(filled + limit);
+        ZSTD_inBuffer in = { input.data(), input.size(), 0 };
+        ZSTD_outBuffer out = { &output[filled], limit, 0 };
+
+        size_t status = ZSTD_decompressStream(stream, &out, &in);
+        if (ZSTD_isError(status)) {
+            output.resize(filled);
+            throw runtime_error(string("Corrupt zstd data: ") + ZSTD_getErrorName(status));
+        }
+        input.remove_prefix(in.pos);
+        output.resize(filled + out.pos);
+
+        // A call that made no progress leaves the end-of-frame state as it was
+        if (in.pos > 0 || out.pos > 0) finished = status == 0;
+        return out.pos;
+    }
+
+    bool Finished() const override { return finished; }
+};
+#endif
+
+// Returns a decoder for the format, or null when this build cannot read it
+unique_ptr<StreamDecoder> makeDecoder(CatalogCompression compression) {
+#ifdef ENHANCEMENT_TWO_GZIP
+    if (compression == CatalogCompression::Gzip) return unique_ptr<StreamDecoder>(new GzipDecoder());
+#endif
+#ifdef ENHANCEMENT_TWO_ZSTD
+    if (compression == CatalogCompression::Zstd) return unique_ptr<StreamDecoder>(new ZstdDecoder());
+#endif
+    (void)compression;
+    return nullptr;
+}
+
+// Decompresses an input into blocks of whole lines, a block at a time, so
+// the decompressed catalog is never held whole. Compressed bytes come from a
+// stream in chunks or from a mapped file. Each block is kept as the source
+// of its titles, as for uncompressed streams
+class CompressedBlockReader : public CatalogBlockReader {
+private:
+    unique_ptr<StreamDecoder> decoder;
+    istream* input;                        // Null when reading a mapping
+    shared_ptr<const SourceText> mapped;
+    size_t blockBytes;
+    string compressed;                     // Chunk read from the stream
+    string_view pending;                   // Compressed bytes not yet decoded
+    string carry;
+    bool ended = false;
+
+    // Refills the compressed bytes; false once the input is exhausted
+    bool readCompressed() {
+        if (!input || !*input) return false;
+        compressed.resize(compressedChunkBytes);
+        input->read(&compressed[0], static_cast<streamsize>(compressed.size()));
+        compressed.resize(static_cast<size_t>(input->gcount()));
+        pending = compressed;
+        return !compressed.empty();
+    }
+
+public:
+    // Reads from a stream whose first bytes the caller already consumed
+    CompressedBlockReader(unique_ptr<StreamDecoder> streamDecoder, istream& inputFile, string leading,
+        size_t bytesPerBlock) :
+        decoder(move(streamDecoder)),
+        input(&inputFile),
+        blockBytes(bytesPerBlock),
+        compressed(move(leading)) {
+        pending = compressed;
+    }
+
+    // Reads from a whole compressed file mapped into memory
+    CompressedBlockReader(unique_ptr<StreamDecoder> streamDecoder, shared_ptr<const SourceText> mappedFile,
+        size_t bytesPerBlock) :
+        decoder(move(streamDecoder)),
+        input(nullptr),
+        mapped(move(mappedFile)),
+        blockBytes(bytesPerBlock) {
+        pending = mapped->Text();
+    }
+
+    bool Next(CatalogBlock& block) override {
+        TraceSpan span("Decompress block", "load");
+        string text;
+        text.swap(carry);
+        size_t target = text.size() + blockBytes;
+        while (!ended) {
+            if (text.size() >= target) {
+                size_t lastNewline = text.find_last_of('\n');
+                if (lastNewline != string::npos) {
+                    carry.assign(text, lastNewline + 1, string::npos);
+                    text.resize(lastNewline + 1);
+                    break;
+                }
+                target = text.size() + blockBytes;    // A line longer than a block
+            }
+
+            size_t produced = decoder->Decode(pending, text, target - text.size());
+            if (produced == 0 && pending.empty() && !readCompressed()) {
+                if (!decoder->Finished()) throw runtime_error("Compressed catalog is truncated");
+                ended = true;
+            }
+        }
+        if (text.empty()) return false;
+
+        if (text.capacity() > text.size() + text.size() / 8) {
+            text.shrink_to_fit();
+        }
+        block.source = make_shared<const SourceText>(move(text));
+        block.text = block.source->Text();
+        return true;
+    }
+
+    bool Done() const override { return ended && carry.empty(); }
+};
+
+// Builds the dependency graph, validates and freezes a catalog once every
+// course has been inserted
+void finishLoad(BinarySearchTree* bst) {
+    // The loaded catalog is read-only from here on; freezing also indexes a
+    // bulk load's records
+    bst->Freeze();
+
+    // Build prerequisite relationships after all courses are indexed. Its
+    // traversals can run through a prerequisite graph built once
+    bst->BuildDependencyGraph();
+    bst->BuildPrerequisiteGraph();
+
+    // Validate all prerequisites; building the graph has already resolved them
+    if (!bst->ValidateAllPrerequisites()) {
+        cerr << "Warning: Some prerequisites could not be validated" << endl;
+    }
+
+    // The menu searches from the thread that loaded the catalog
+    QueryLatency::Instance().PrepareThread();
+}
+
+// Stages a load's inserts for as long as it runs, so the ordered index is
+// built once at the end rather than course by course; a load that fails
+// before it is frozen still leaves an ordered tree behind
+class BulkLoadScope {
+private:
+    BinarySearchTree* bst;
+
+public:
+    explicit BulkLoadScope(BinarySearchTree* tree) : bst(tree) { bst->BeginBulkLoad(); }
+    ~BulkLoadScope() { bst->EndBulkLoad(); }
+
+    BulkLoadScope(const BulkLoadScope&) = delete;
+    BulkLoadScope& operator=(const BulkLoadScope&) = delete;
+};
+
+//============================================================================
+// Import pipeline
+// Stages connected by bounded lock-free queues: a reader thread cuts the
+// input into blocks of whole lines, parser threads turn blocks into batches of
+// courses, a validator thread checks every course ID, and the calling thread
+// inserts the batches in file order. A full queue stalls the stage feeding
+// it, so at most a few blocks are in flight however large the feed is
+//============================================================================
+
+// Bounded multi-producer multi-consumer queue (Vyukov's sequence-numbered
+// ring). Push and Pop yield a few times while the queue is full or empty,
+// then park until another thread pops, pushes, finishes or cancels; they
+// give up when the pipeline is cancelled, and Pop also once every producer
+// is done and the queue has drained
+template <typename T>
+class BoundedQueue {
+private:
+    static const int spinLimit = 16;   // Yields before a waiting thread parks
+
+    struct Cell {
+        atomic<size_t> sequence;
+        T value;
+    };
+
+    unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) atomic<size_t> enqueuePosition{ 0 };
+    alignas(64) atomic<size_t> dequeuePosition{ 0 };
+    atomic<size_t> producers;
+    const atomic<bool>& cancelled;
+
+    // Parked threads; the lock-free path only takes the mutex when some exist
+    mutex parkMutex;
+    condition_variable parked;
+    atomic<size_t> sleepers{ 0 };
+
+    bool full() const {
+        size_t position = enqueuePosition.load(memory_order_relaxed);
+        return cells[position & mask].sequence.load(memory_order_acquire) < position;
+    }
+
+    bool empty() const {
+        size_t position = dequeuePosition.load(memory_order_relaxed);
+        return cells[position & mask].sequence.load(memory_order_acquire) < position + 1;
+    }
+
+    // Blocks until ready() holds or the queue is woken. The fence pairs with
+    // the one in wakeSleepers: either the waker sees this sleeper, or this
+    // check sees the waker's update
+    template <typename Ready>
+    void park(Ready ready) {
+        unique_lock<mutex> lock(parkMutex);
+        sleepers.fetch_add(1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (!ready()) parked.wait(lock);
+        sleepers.fetch_sub(1, memory_order_relaxed);
+    }
+
+    // Wakes parked threads after a push or pop
+    void wakeSleepers() {
+        atomic_thread_fence(memory_order_seq_cst);
+        if (sleepers.load(memory_order_relaxed) != 0) Wake();
+    }
+
+    bool tryPush(T& value) {
+        size_t position = enqueuePosition.load(memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells[position & mask];
+            size_t sequence = cell.sequence.load(memory_order_acquire);
+            if (sequence == position) {
+                if (enqueuePosition.compare_exchange_weak(position, position + 1, memory_order_relaxed)) {
+                    cell.value = move(value);
+                    cell.sequence.store(position + 1, memory_order_release);
+                    return true;
+                }
+            }
+            else if (sequence < position) {
+                return false;
+            }
+            else {
+                position = enqueuePosition.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPop(T& value) {
+        size_t position = dequeuePosition.load(memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells[position & mask];
+            size_t sequence = cell.sequence.load(memory_order_acquire);
+            if (sequence == position + 1) {
+                if (dequeuePosition.compare_exchange_weak(position, position + 1, memory_order_relaxed)) {
+                    value = move(cell.value);
+                    cell.sequence.store(position + mask + 1, memory_order_release);
+                    return true;
+                }
+            }
+            else if (sequence < position + 1) {
+                return false;
+            }
+            else {
+                position = dequeuePosition.load(memory_order_relaxed);
+            }
+        }
+    }
+
+public:
+    // Capacity must be a power of two
+    BoundedQueue(size_t capacity, size_t producerCount, const atomic<bool>& cancelFlag) :
+        cells(new Cell[capacity]), mask(capacity - 1), producers(producerCount), cancelled(cancelFlag) {
+        for (size_t i = 0; i < capacity; ++i) {
+            cells[i].sequence.store(i, memory_order_relaxed);
+        }
+    }
+
+    bool Push(T value) {
+        for (int attempt = 0; !tryPush(value); ++attempt) {
+            if (cancelled.load(memory_order_relaxed)) return false;
+            if (attempt < spinLimit) {
+                this_thread::yield();
+            }
+            else {
+                park([this] { return !full() || cancelled.load(memory_order_relaxed); });
+            }
+        }
+        wakeSleepers();
+        return true;
+    }
+
+    bool Pop(T& value) {
+        for (int attempt = 0; !tryPop(value); ++attempt) {
+            if (cancelled.load(memory_order_relaxed)) return false;
+            if (producers.load(memory_order_acquire) == 0) {
+                if (!tryPop(value)) return false;
+                break;
+            }
+            if (attempt < spinLimit) {
+                this_thread::yield();
+            }
+            else {
+                park([this] {
+                    return !empty() || cancelled.load(memory_order_relaxed) ||
+                        producers.load(memory_order_acquire) == 0;
+                });
+            }
+        }
+        wakeSleepers();
+        return true;
+    }
+
+    // Called by each producer after its last push
+    void ProducerDone() {
+        producers.fetch_sub(1, memory_order_release);
+        Wake();
+    }
+
+    // Wakes every parked thread, e.g. after the pipeline is cancelled
+    void Wake() {
+        lock_guard<mutex> lock(parkMutex);
+        parked.notify_all();
+    }
+};
+
+// Courses parsed from one block; invalidAt is the first course whose ID
+// failed validation, or the batch size if every ID passed
+struct CourseBatch {
+    size_t sequence = 0;
+    vector<Course> courses;
+    size_t invalidAt = 0;
+};
+
+class ImportPipeline {
+private:
+    static const size_t queueCapacity = 8;
+
+    CatalogBlockReader& reader;
+    BinarySearchTree* bst;
+    size_t parserCount;
+
+    atomic<bool> cancelled{ false };
+    mutex errorMutex;
+    string error;                      // First failure; empty on success
+
+    BoundedQueue<CatalogBlock> blocks;
+    BoundedQueue<CourseBatch> parsed;
+    BoundedQueue<CourseBatch> validated;
+
+    // Records the first failure and stops every stage
+    void fail(const string& message) {
+        {
+            lock_guard<mutex> lock(errorMutex);
+            if (error.empty()) error = message;
+        }
+        cancelled.store(true, memory_order_relaxed);
+        blocks.Wake();
+        parsed.Wake();
+        validated.Wake();
+    }
+
+    void readStage(CatalogBlock first) {
+        try {
+            if (blocks.Push(move(first))) {
+                CatalogBlock block;
+                block.sequence = 1;
+                while (reader.Next(block)) {
+                    size_t sequence = block.sequence;
+                    if (!blocks.Push(move(block))) break;
+                    block = CatalogBlock();
+                    block.sequence = sequence + 1;
+                }
+            }
+        }
+        catch (const exception& e) {
+            fail(e.what());
+        }
+        blocks.ProducerDone();
+    }
+
+    void parseStage() {
+        try {
+            vector<string_view> fields;
+            CatalogBlock block;
+            while (blocks.Pop(block)) {
+                TraceSpan span("Parse block", "load");
+                CourseBatch batch;
+                batch.sequence = block.sequence;
+                batch.courses.reserve(count(block.text.begin(), block.text.end(), '\n') + 1);
+                Course course;
+                forEachLine(block.text, [&](string_view line) {
+                    if (parseCourseLine(line, block.source, fields, course)) {
+                        batch.courses.push_back(move(course));
+                    }
+                });
+                if (!parsed.Push(move(batch))) break;
+            }
+        }
+        catch (const exception& e) {
+            fail(e.what());
+        }
+        parsed.ProducerDone();
+    }
+
+    void validateStage() {
+        try {
+            CourseBatch batch;
+            while (parsed.Pop(batch)) {
+                TraceSpan span("Validate batch", "load");
+                batch.invalidAt = batch.courses.size();
+                for (size_t i = 0; i < batch.courses.size(); ++i) {
+                    if (!BinarySearchTree::IsValidCourseId(batch.courses[i].courseId)) {
+                        batch.invalidAt = i;
+                        break;
+                    }
+                }
+                if (!validated.Push(move(batch))) break;
+            }
+        }
+        catch (const exception& e) {
+            fail(e.what());
+        }
+        validated.ProducerDone();
+    }
+
+    // Inserts batches in file order, holding back any that arrive early.
+    // Courses before an invalid ID are kept, as a line-by-line load would
+    void insertStage() {
+        map<size_t, CourseBatch> early;
+        size_t next = 0;
+        CourseBatch batch;
+        while (validated.Pop(batch)) {
+            early.emplace(batch.sequence, move(batch));
+            for (auto it = early.find(next); it != early.end(); it = early.find(next)) {
+                CourseBatch& ready = it->second;
+                for (size_t i = 0; i < ready.invalidAt; ++i) {
+                    bst->InsertValidated(move(ready.courses[i]));
+                }
+                if (ready.invalidAt < ready.courses.size()) {
+                    fail("Invalid course ID format: " + ready.courses[ready.invalidAt].courseId);
+                    return;
+                }
+                early.erase(it);
+                next++;
+            }
+        }
+    }
+
+public:
+    ImportPipeline(CatalogBlockReader& blockReader, BinarySearchTree* target) :
+        reader(blockReader),
+        bst(target),
+        parserCount(max<size_t>(1, min<size_t>(4, thread::hardware_concurrency() > 3 ?
+            thread::hardware_concurrency() - 3 : 1))),
+        blocks(queueCapacity, 1, cancelled),
+        parsed(queueCapacity, parserCount, cancelled),
+        validated(queueCapacity, 1, cancelled) {}
+
+    // Runs every stage, starting from a block the caller already read;
+    // returns the first error, or an empty string once every course is
+    // inserted
+    string Run(CatalogBlock first) {
+        vector<thread> stages;
+        stages.emplace_back(&ImportPipeline::readStage, this, move(first));
+        for (size_t i = 0; i < parserCount; ++i) {
+            stages.emplace_back(&ImportPipeline::parseStage, this);
+        }
+        stages.emplace_back(&ImportPipeline::validateStage, this);
+
+        try {
+            insertStage();
+        }
+        catch (const exception& e) {
+            fail(e.what());
+        }
+        for (auto& stage : stages) {
+            stage.join();
+        }
+        return error;
+    }
+};
+
+// Loads every block of one input into the BST
+bool loadCatalogBlocks(CatalogBlockReader& reader, BinarySearchTree* bst) {
+    TraceSpan span("Load catalog", "load");
+
+    // Validate BST pointer
+    if (!bst) {
+        cout << "  Unable to open BST pointer" << endl;
+        return false;
+    }
+
+    BulkLoadScope bulk(bst);
+    try {
+        CatalogBlock first;
+        if (!reader.Next(first)) {
+            finishLoad(bst);
+            return true;
+        }
+
+        // The whole catalog fit in one block: no threads needed
+        if (reader.Done()) {
+            vector<string_view> fields;
+            Course course;
+            bool inserted = true;
+            forEachLine(first.text, [&](string_view line) {
+                if (!inserted) return;
+                {
+                    TraceSpan tokenizeSpan("Tokenize", "load");
+                    if (!parseCourseLine(line, first.source, fields, course)) return;
+                }
+
+                // Attempt to insert course into BST
+                try {
+                    bst->Insert(move(course));
+                }
+                catch (const invalid_argument& e) {
+                    cerr << "Error processing file: " << e.what() << endl;
+                    inserted = false;
+                }
+            });
+            if (!inserted) return false;
+        }
+        else {
+            ImportPipeline pipeline(reader, bst);
+            string error = pipeline.Run(move(first));
+            if (!error.empty()) {
+                cerr << "Error processing file: " << error << endl;
+                return false;
+            }
+        }
+
+        finishLoad(bst);
+        return true;
+    }
+    catch (const exception& e) {
+        cerr << "Error processing file: " << e.what() << endl;
+        return false;
+    }
+}
+
+// Explains why this build cannot read compressed input
+string unsupportedCompression(CatalogCompression compression) {
+    return string(compressionName(compression)) + " input needs a build with " +
+        (compression == CatalogCompression::Gzip ? "ENHANCEMENT_TWO_GZIP and zlib" : "ENHANCEMENT_TWO_ZSTD and libzstd");
+}
+
+// Picks the reader for a stream from its leading bytes; returns null and
+// sets error when the stream is compressed in a format this build cannot read
+unique_ptr<CatalogBlockReader> openCatalogStream(istream& inputFile, size_t blockBytes, string& error) {
+    string leading(compressionMagicBytes, '\0');
+    inputFile.read(&leading[0], static_cast<streamsize>(leading.size()));
+    leading.resize(static_cast<size_t>(inputFile.gcount()));
+
+    CatalogCompression compression = detectCompression(leading);
+    if (compression == CatalogCompression::None) {
+        return make_unique<StreamBlockReader>(inputFile, blockBytes, move(leading));
+    }
+    unique_ptr<StreamDecoder> decoder = makeDecoder(compression);
+    if (!decoder) {
+        error = unsupportedCompression(compression);
+        return nullptr;
+    }
+    return make_unique<CompressedBlockReader>(move(decoder), inputFile, move(leading), blockBytes);
+}
+
+// A catalog file opened for reading: mapped, or read through its stream
+struct CatalogFile {
+    ifstream stream;
+    unique_ptr<CatalogBlockReader> reader;
+};
+
+// Opens a catalog file with the reader that suits it. Regular files are
+// mapped so titles point into the file, and compressed files are decoded
+// straight from the mapping; anything else is read as a stream. Returns
+// false and sets error when the file cannot be opened or decoded
+bool openCatalogFile(const string& filepath, size_t blockBytes, CatalogFile& file, string& error) {
+    if (shared_ptr<const SourceText> mapped = SourceText::Map(filepath)) {
+        CatalogCompression compression = detectCompression(mapped->Text().substr(0, compressionMagicBytes));
+        if (compression == CatalogCompression::None) {
+            file.reader = make_unique<MappedBlockReader>(move(mapped), blockBytes);
+            return true;
+        }
+        unique_ptr<StreamDecoder> decoder = makeDecoder(compression);
+        if (!decoder) {
+            error = unsupportedCompression(compression);
+            return false;
+        }
+        file.reader = make_unique<CompressedBlockReader>(move(decoder), move(mapped), blockBytes);
+        return true;
+    }
+
+    file.stream.open(filepath, ios::binary);
+    if (!file.stream.is_open()) {
+        error = "Unable to open file: " + filepath;
+        return false;
+    }
+    file.reader = openCatalogStream(file.stream, blockBytes, error);
+    return file.reader != nullptr;
+}
+
+// Parses CSV course data from any input stream. gzip and zstd input is
+// recognised by its magic bytes and decompressed as it is read; open such
+// streams in binary mode
+bool loadDataStructure(istream& inputFile, BinarySearchTree* bst, size_t blockBytes = loaderBlockBytes) {
+    string error;
+    unique_ptr<CatalogBlockReader> reader = openCatalogStream(inputFile, max<size_t>(blockBytes, 1), error);
+    if (!reader) {
+        cerr << "Error processing file: " << error << endl;
+        return false;
+    }
+    return loadCatalogBlocks(*reader, bst);
+}
+
+// Opens a course data file and loads it into the BST
+bool loadDataStructure(const string& filepath, BinarySearchTree* bst, size_t blockBytes = loaderBlockBytes) {
+    CatalogFile file;
+    string error;
+    if (!openCatalogFile(filepath, max<size_t>(blockBytes, 1), file, error)) {
+        cout << "  " << error << endl;
+        return false;
+    }
+    return loadCatalogBlocks(*file.reader, bst);
+}
+
+//============================================================================
+// Multi-file import
+// Loads a directory of catalog files, or the files matching a wildcard, as
+// one catalog. Worker threads read and parse whole files concurrently while
+// the calling thread merges finished files in name order, so the result is
+// the same as loading the files one after another. Prerequisites are
+// resolved once, across every file, after the last merge
+//============================================================================
+
+// Outcome of one file of a multi-file import
+struct CatalogFileResult {
+    string path;
+    size_t bytes = 0;                 // Size on disk, compressed or not
+    size_t courses = 0;
+    double parseMilliseconds = 0;     // Reading, decompressing and parsing
+    double mergeMilliseconds = 0;     // Inserting into the catalog
+    string error;                     // Empty on success
+};
+
+inline bool hasWildcard(const string& path) {
+    return path.find_first_of("*?") != string::npos;
+}
+
+// Matches a file name against a pattern of literal characters, * and ?
+bool matchesWildcard(string_view name, string_view pattern) {
+    size_t n = 0;
+    size_t p = 0;
+    size_t starPattern = string_view::npos;
+    size_t starName = 0;
+    while (n < name.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+            n++;
+            p++;
+        }
+        else if (p < pattern.size() && pattern[p] == '*') {
+            starPattern = p++;
+            starName = n;
+        }
+        else if (starPattern != string_view::npos) {
+            // Let the last * absorb one more character
+            p = starPattern + 1;
+            n = ++starName;
+        }
+        else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') p++;
+    return p == pattern.size();
+}
+
+// Lists the files named by a directory, or by a wildcard in the last path
+// component, in name order. Subdirectories and hidden files are skipped; any
+// other path names just itself
+vector<string> expandCatalogPaths(const string& pattern) {
+    error_code status;
+    filesystem::path directory;
+    string namePattern = "*";
+    if (filesystem::is_directory(pattern, status)) {
+        directory = pattern;
+    }
+    else if (hasWildcard(pattern)) {
+        filesystem::path path(pattern);
+        directory = path.has_parent_path() ? path.parent_path() : filesystem::path(".");
+        namePattern = path.filename().string();
+    }
+    else {
+        return { pattern };
+    }
+
+    vector<string> paths;
+    for (const auto& entry : filesystem::directory_iterator(directory, status)) {
+        string name = entry.path().filename().string();
+        if (name.empty() || name[0] == '.' || !entry.is_regular_file(status)) continue;
+        if (matchesWildcard(name, namePattern)) paths.push_back(entry.path().string());
+    }
+    sort(paths.begin(), paths.end());
+    return paths;
+}
+
+// Reads and parses every course of one file, checking each course ID; on
+// failure the result's error says why
+void parseCatalogFile(const string& path, size_t blockBytes, vector<Course>& courses, CatalogFileResult& result) {
+    TraceSpan span("Parse file", "load");
+    auto start = steady_clock::now();
+    result.path = path;
+    try {
+        error_code status;
+        uintmax_t bytes = filesystem::file_size(path, status);
+        result.bytes = status ? 0 : static_cast<size_t>(bytes);
+
+        CatalogFile file;
+        string error;
+        if (!openCatalogFile(path, blockBytes, file, error)) {
+            result.error = error;
+        }
+        vector<string_view> fields;
+        Course course;
+        CatalogBlock block;
+        while (result.error.empty() && file.reader->Next(block)) {
+            forEachLine(block.text, [&](string_view line) {
+                if (!result.error.empty() || !parseCourseLine(line, block.source, fields, course)) return;
+                if (!BinarySearchTree::IsValidCourseId(course.courseId)) {
+                    result.error = "Invalid course ID format: " + course.courseId;
+                    return;
+                }
+                courses.push_back(move(course));
+            });
+        }
+    }
+    catch (const exception& e) {
+        result.error = e.what();
+    }
+    result.courses = courses.size();
+    result.parseMilliseconds = duration<double, milli>(steady_clock::now() - start).count();
+}
+
+// Loads several catalog files into one catalog. Every file gets a result,
+// in path order; the load fails if any file does
+bool loadCatalogFiles(const vector<string>& paths, BinarySearchTree* bst, vector<CatalogFileResult>& results,
+    size_t blockBytes = loaderBlockBytes) {
+    TraceSpan span("Load catalog files", "load");
+    results.assign(paths.size(), CatalogFileResult());
+
+    // Validate BST pointer
+    if (!bst) {
+        cout << "  Unable to open BST pointer" << endl;
+        return false;
+    }
+    if (paths.empty()) return false;
+
+    // Parsed files wait here until the merge reaches them
+    struct ParsedFile {
+        vector<Course> courses;
+        bool ready = false;
+    };
+    vector<ParsedFile> parsed(paths.size());
+    mutex readyMutex;
+    condition_variable readyCondition;
+    atomic<size_t> nextFile{ 0 };
+    blockBytes = max<size_t>(blockBytes, 1);
+
+    auto parseFiles = [&]() {
+        for (size_t i = nextFile.fetch_add(1); i < paths.size(); i = nextFile.fetch_add(1)) {
+            vector<Course> courses;
+            parseCatalogFile(paths[i], blockBytes, courses, results[i]);
+            {
+                lock_guard<mutex> lock(readyMutex);
+                parsed[i].courses = move(courses);
+                parsed[i].ready = true;
+            }
+            readyCondition.notify_all();
+        }
+    };
+    size_t workerCount = min(paths.size(), max<size_t>(1, min<size_t>(8, thread::hardware_concurrency())));
+    BulkLoadScope bulk(bst);
+    vector<thread> workers;
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back(parseFiles);
+    }
+
+    // A failed file stops the merge, but every file is still parsed so each
+    // one reports its own errors
+    bool loaded = true;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        vector<Course> courses;
+        {
+            unique_lock<mutex> lock(readyMutex);
+            readyCondition.wait(lock, [&parsed, i]() { return parsed[i].ready; });
+            courses = move(parsed[i].courses);
+        }
+        if (!results[i].error.empty()) loaded = false;
+        if (!loaded) continue;
+
+        try {
+            TraceSpan mergeSpan("Merge file", "load");
+            auto start = steady_clock::now();
+            for (auto& course : courses) {
+                bst->InsertValidated(move(course));
+            }
+            results[i].mergeMilliseconds = duration<double, milli>(steady_clock::now() - start).count();
+        }
+        catch (const exception& e) {
+            results[i].error = e.what();
+            loaded = false;
+        }
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    if (loaded) {
+        finishLoad(bst);
+    }
+    return loaded;
+}
+
+// Displays the outcome of each file of a multi-file import
+void printImportReport(const vector<CatalogFileResult>& results) {
+    printSubHeader("Import Report");
+    cout << "    " << setw(24) << left << "FILE"
+        << " | " << setw(8) << right << "COURSES"
+        << " | " << setw(10) << right << "PARSE (ms)"
+        << " | " << setw(10) << right << "MERGE (ms)"
+        << " | STATUS" << endl;
+    cout << "  " << string(73, '-') << endl;
+
+    size_t totalCourses = 0;
+    for (const auto& result : results) {
+        ostringstream parse;
+        ostringstream merge;
+        parse << fixed << setprecision(2) << result.parseMilliseconds;
+        merge << fixed << setprecision(2) << result.mergeMilliseconds;
+        cout << "    " << setw(24) << left << filesystem::path(result.path).filename().string()
+            << " | " << setw(8) << right << result.courses
+            << " | " << setw(10) << right << parse.str()
+            << " | " << setw(10) << right << merge.str()
+            << " | " << (result.error.empty() ? "OK" : result.error) << endl;
+        totalCourses += result.courses;
+    }
+    cout << "    " << results.size() << " files, " << totalCourses << " courses" << endl << endl;
+}
+
+//============================================================================
+// Adaptive radix tree index
+// Ordered index over course IDs as an alternative to the BST. IDs share long
+// department prefixes, so inner nodes store the compressed common prefix and
+// branch on a single byte, growing from 4 to 16, 48 and 256 children as
+// needed. Each ID is followed by an implicit 0 byte so no key is a prefix of
+// another and shorter IDs sort first
+//============================================================================
+
+struct ArtNode {
+    enum Type : uint8_t { Leaf, Node4, Node16, Node48, Node256 };
+
+    Type type;
+
+    explicit ArtNode(Type nodeType) : type(nodeType) {}
+    virtual ~ArtNode() = default;
+};
+
+struct ArtLeaf : ArtNode {
+    shared_ptr<const Course> record;
+
+    explicit ArtLeaf(shared_ptr<const Course> aRecord) : ArtNode(Leaf), record(move(aRecord)) {}
+};
+
+// Inner nodes keep the whole compressed prefix, so lookups never need to
+// re-check it against a leaf
+struct ArtInner : ArtNode {
+    string prefix;
+    uint16_t childCount = 0;
+
+    explicit ArtInner(Type nodeType) : ArtNode(nodeType) {}
+};
+
+struct ArtNode4 : ArtInner {
+    uint8_t keys[4] = {};                 // Sorted
+    unique_ptr<ArtNode> children[4];
+
+    ArtNode4() : ArtInner(Node4) {}
+};
+
+struct ArtNode16 : ArtInner {
+    uint8_t keys[16] = {};                // Sorted
+    unique_ptr<ArtNode> children[16];
+
+    ArtNode16() : ArtInner(Node16) {}
+};
+
+struct ArtNode48 : ArtInner {
+    uint8_t childIndex[256] = {};         // Slot + 1, or 0 when absent
+    unique_ptr<ArtNode> children[48];
+
+    ArtNode48() : ArtInner(Node48) {}
+};
+
+struct ArtNode256 : ArtInner {
+    unique_ptr<ArtNode> children[256];
+
+    ArtNode256() : ArtInner(Node256) {}
+};
+
+class CourseRadixTree {
+public:
+    struct NodeCounts {
+        size_t leaves = 0;
+        size_t node4 = 0;
+        size_t node16 = 0;
+        size_t node48 = 0;
+        size_t node256 = 0;
+    };
+
+private:
+    unique_ptr<ArtNode> root;
+    size_t recordCount = 0;
+
+    static uint8_t keyByte(const string& key, size_t depth);
+    static unique_ptr<ArtNode>* findChild(ArtInner* node, uint8_t byte);
+    static const ArtNode* findChild(const ArtInner* node, uint8_t byte);
+    static void addChild(unique_ptr<ArtNode>& slot, uint8_t byte, unique_ptr<ArtNode> child);
+    static unique_ptr<ArtNode> grow(ArtInner* node);
+    static void visitInOrder(const ArtNode* node, const function<void(const shared_ptr<const Course>&)>& visit);
+    static void countNodes(const ArtNode* node, NodeCounts& counts);
+    bool insert(unique_ptr<ArtNode>& slot, shared_ptr<const Course>& record, size_t depth);
+
+public:
+    CourseRadixTree() = default;
+    explicit CourseRadixTree(const BinarySearchTree& catalog);
+
+    // Inserts or replaces a record; returns true when the ID was new
+    bool Insert(shared_ptr<const Course> record);
+    const Course* Find(const string& courseId) const;
+    void ForEachRecord(const function<void(const shared_ptr<const Course>&)>& visit) const;
+    void ForEachWithPrefix(const string& prefix, const function<void(const shared_ptr<const Course>&)>& visit) const;
+
+    size_t Size() const { return recordCount; }
+    NodeCounts GetNodeCounts() const;
+};
+
+// Builds the index over every record of a loaded catalog
+CourseRadixTree::CourseRadixTree(const BinarySearchTree& catalog) {
+    catalog.ForEachRecord([this](const shared_ptr<const Course>& record) {
+        Insert(record);
+    });
+}
+
+// Byte of a key at a depth, with the implicit terminator past the end
+uint8_t CourseRadixTree::keyByte(const string& key, size_t depth) {
+    return depth < key.size() ? static_cast<uint8_t>(key[depth]) : 0;
+}
+
+const ArtNode* CourseRadixTree::findChild(const ArtInner* node, uint8_t byte) {
+    switch (node->type) {
+    case ArtNode::Node4: {
+        const ArtNode4* n = static_cast<const ArtNode4*>(node);
+        for (uint16_t i = 0; i < n->childCount; ++i) {
+            if (n->keys[i] == byte) return n->children[i].get();
+        }
+        return nullptr;
+    }
+    case ArtNode::Node16: {
+        const ArtNode16* n = static_cast<const ArtNode16*>(node);
+#ifdef COURSE_ART_SSE2
+        // Compare all 16 keys at once and keep matches among the used slots
+        __m128i matches = _mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(byte)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(n->keys)));
+        unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(matches)) & ((1u << n->childCount) - 1);
+        if (mask == 0) return nullptr;
+        unsigned int slot = 0;
+        while (!(mask & (1u << slot))) slot++;
+        return n->children[slot].get();
+#else
+        for (uint16_t i = 0; i < n->childCount; ++i) {
+            if (n->keys[i] == byte) return n->children[i].get();
+        }
+        return nullptr;
+#endif
+    }
+    case ArtNode::Node48: {
+        const ArtNode48* n = static_cast<const ArtNode48*>(node);
+        return n->childIndex[byte] ? n->children[n->childIndex[byte] - 1].get() : nullptr;
+    }
+    case ArtNode::Node256:
+        return static_cast<const ArtNode256*>(node)->children[byte].get();
+    default:
+        return nullptr;
+    }
+}
+
+// Mutable variant: returns the slot holding the child so it can be replaced
+unique_ptr<ArtNode>* CourseRadixTree::findChild(ArtInner* node, uint8_t byte) {
+    const ArtNode* child = findChild(static_cast<const ArtInner*>(node), byte);
+    if (!child) return nullptr;
+    switch (node->type) {
+    case ArtNode::Node4: {
+        ArtNode4* n = static_cast<ArtNode4*>(node);
+        for (uint16_t i = 0; i < n->childCount; ++i) {
+            if (n->children[i].get() == child) return &n->children[i];
+        }
+        return nullptr;
+    }
+    case ArtNode::Node16: {
+        ArtNode16* n = static_cast<ArtNode16*>(node);
+        for (uint16_t i = 0; i < n->childCount; ++i) {
+            if (n->children[i].get() == child) return &n->children[i];
+        }
+        return nullptr;
+    }
+    case ArtNode::Node48: {
+        ArtNode48* n = static_cast<ArtNode48*>(node);
+        return &n->children[n->childIndex[byte] - 1];
+    }
+    default:
+        return &static_cast<ArtNode256*>(node)->children[byte];
+    }
+}
+
+// Moves a full node's prefix and children into the next larger node type
+unique_ptr<ArtNode> CourseRadixTree::grow(ArtInner* node) {
+    switch (node->type) {
+    case ArtNode::Node4: {
+        ArtNode4* n = static_cast<ArtNode4*>(node);
+        unique_ptr<ArtNode16> bigger = make_unique<ArtNode16>();
+        for (uint16_t i = 0; i < n->childCount; ++i) {
+            bigger->keys[i] = n->keys[i];
+            bigger->children[i] = move(n->children[i]);
+        }
+        bigger->childCount = n->childCount;
+        bigger->prefix = move(n->prefix);
+        return bigger;
+    }
+    case ArtNode::Node16: {
+        ArtNode16* n = static_cast<ArtNode16*>(node);
+        unique_ptr<ArtNode48> bigger = make_unique<ArtNode48>();
+        for (uint16_t i = 0; i < n->childCount; ++i) {
+            bigger->childIndex[n->keys[i]] = static_cast<uint8_t>(i + 1);
+            bigger->children[i] = move(n->children[i]);
+        }
+        bigger->childCount = n->childCount;
+        bigger->prefix = move(n->prefix);
+        return bigger;
+    }
+    default: {
+        ArtNode48* n = static_cast<ArtNode48*>(node);
+        unique_ptr<ArtNode256> bigger = make_unique<ArtNode256>();
+        for (int byte = 0; byte < 256; ++byte) {
+            if (n->childIndex[byte]) bigger->children[byte] = move(n->children[n->childIndex[byte] - 1]);
+        }
+        bigger->childCount = n->childCount;
+        bigger->prefix = move(n->prefix);
+        return bigger;
+    }
+    }
+}
+
+// Adds a child under a byte not yet present, growing the node if it is full
+void CourseRadixTree::addChild(unique_ptr<ArtNode>& slot, uint8_t byte, unique_ptr<ArtNode> child) {
+    ArtInner* node = static_cast<ArtInner*>(slot.get());
+    bool full = (node->type == ArtNode::Node4 && node->childCount == 4) ||
+        (node->type == ArtNode::Node16 && node->childCount == 16) ||
+        (node->type == ArtNode::Node48 && node->childCount == 48);
+    if (full) {
+        slot = grow(node);
+        node = static_cast<ArtInner*>(slot.get());
+    }
+
+    switch (node->type) {
+    case ArtNode::Node4:
+    case ArtNode::Node16: {
+        // Both small node types keep their keys sorted for ordered iteration
+        uint8_t* keys = (node->type == ArtNode::Node4) ? static_cast<ArtNode4*>(node)->keys : static_cast<ArtNode16*>(node)->keys;
+        unique_ptr<ArtNode>* children = (node->type == ArtNode::Node4) ?
+            static_cast<ArtNode4*>(node)->children : static_cast<ArtNode16*>(node)->children;
+        uint16_t position = 0;
+        while (position < node->childCount && keys[position] < byte) position++;
+        for (uint16_t i = node->childCount; i > position; --i) {
+            keys[i] = keys[i - 1];
+            children[i] = move(children[i - 1]);
+        }
+        keys[position] = byte;
+        children[position] = move(child);
+        break;
+    }
+    case ArtNode::Node48: {
+        ArtNode48* n = static_cast<ArtNode48*>(node);
+        n->children[n->childCount] = move(child);
+        n->childIndex[byte] = static_cast<uint8_t>(n->childCount + 1);
+        break;
+    }
+    default:
+        static_cast<ArtNode256*>(node)->children[byte] = move(child);
+        break;
+    }
+    node->childCount++;
+}
+
+bool CourseRadixTree::Insert(shared_ptr<const Course> record) {
+    bool added = insert(root, record, 0);
+    if (added) recordCount++;
+    return added;
+}
+
+// Descends from a slot at the given key depth, splitting a leaf or a
+// compressed prefix where the new key diverges
+bool CourseRadixTree::insert(unique_ptr<ArtNode>& slot, shared_ptr<const Course>& record, size_t depth) {
+    const string& key = record->courseId;
+    if (!slot) {
+        slot = make_unique<ArtLeaf>(move(record));
+        return true;
+    }
+
+    if (slot->type == ArtNode::Leaf) {
+        ArtLeaf* leaf = static_cast<ArtLeaf*>(slot.get());
+        const string& leafKey = leaf->record->courseId;
+        if (leafKey == key) {
+            leaf->record = move(record);
+            return false;
+        }
+
+        size_t split = depth;
+        while (keyByte(leafKey, split) == keyByte(key, split)) split++;
+        unique_ptr<ArtNode> node = make_unique<ArtNode4>();
+        static_cast<ArtInner*>(node.get())->prefix = key.substr(depth, split - depth);
+        uint8_t newByte = keyByte(key, split);
+        addChild(node, keyByte(leafKey, split), move(slot));
+        addChild(node, newByte, make_unique<ArtLeaf>(move(record)));
+        slot = move(node);
+        return true;
+    }
+
+    ArtInner* node = static_cast<ArtInner*>(slot.get());
+    size_t matched = 0;
+    while (matched < node->prefix.size() &&
+        static_cast<uint8_t>(node->prefix[matched]) == keyByte(key, depth + matched)) {
+        matched++;
+    }
+    if (matched < node->prefix.size()) {
+        // The key leaves the compressed path: split it with a new Node4
+        unique_ptr<ArtNode> parent = make_unique<ArtNode4>();
+        static_cast<ArtInner*>(parent.get())->prefix = node->prefix.substr(0, matched);
+        uint8_t oldByte = static_cast<uint8_t>(node->prefix[matched]);
+        node->prefix.erase(0, matched + 1);
+        uint8_t newByte = keyByte(key, depth + matched);
+        addChild(parent, oldByte, move(slot));
+        addChild(parent, newByte, make_unique<ArtLeaf>(move(record)));
+        slot = move(parent);
+        return true;
+    }
+
+    depth += node->prefix.size();
+    uint8_t byte = keyByte(key, depth);
+    unique_ptr<ArtNode>* child = findChild(node, byte);
+    if (child) {
+        return insert(*child, record, depth + 1);
+    }
+    addChild(slot, byte, make_unique<ArtLeaf>(move(record)));
+    return true;
+}
+
+// Point lookup: one byte comparison per level after each compressed prefix
+const Course* CourseRadixTree::Find(const string& courseId) const {
+    const ArtNode* node = root.get();
+    size_t depth = 0;
+    while (node) {
+        if (node->type == ArtNode::Leaf) {
+            const Course* course = static_cast<const ArtLeaf*>(node)->record.get();
+            return course->courseId == courseId ? course : nullptr;
+        }
+        const ArtInner* inner = static_cast<const ArtInner*>(node);
+        if (depth > courseId.size() || courseId.compare(depth, inner->prefix.size(), inner->prefix) != 0) {
+            return nullptr;
+        }
+        depth += inner->prefix.size();
+        node = findChild(inner, keyByte(courseId, depth));
+        depth++;
+    }
+    return nullptr;
+}
+
+// Visits children in ascending byte order, which is course ID order
+void CourseRadixTree::visitInOrder(const ArtNode* node, const function<void(const shared_ptr<const Course>&)>& visit) {
+    switch (node->type) {
+    case ArtNode::Leaf:
+        visit(static_cast<const ArtLeaf*>(node)->record);
+        break;
+    case ArtNode::Node4: {
+        const ArtNode4* n = static_cast<const ArtNode4*>(node);
+        for (uint16_t i = 0; i < n->childCount; ++i) visitInOrder(n->children[i].get(), visit);
+        break;
+    }
+    case ArtNode::Node16: {
+        const ArtNode16* n = static_cast<const ArtNode16*>(node);
+        for (uint16_t i = 0; i < n->childCount; ++i) visitInOrder(n->children[i].get(), visit);
+        break;
+    }
+    case ArtNode::Node48: {
+        const ArtNode48* n = static_cast<const ArtNode48*>(node);
+        for (int byte = 0; byte < 256; ++byte) {
+            if (n->childIndex[byte]) visitInOrder(n->children[n->childIndex[byte] - 1].get(), visit);
+        }
+        break;
+    }
+    case ArtNode::Node256: {
+        const ArtNode256* n = static_cast<const ArtNode256*>(node);
+        for (int byte = 0; byte < 256; ++byte) {
+            if (n->children[byte]) visitInOrder(n->children[byte].get(), visit);
+        }
+        break;
+    }
+    }
+}
+
+void CourseRadixTree::ForEachRecord(const function<void(const shared_ptr<const Course>&)>& visit) const {
+    if (root) visitInOrder(root.get(), visit);
+}
+
+// Descends along the prefix, then visits the whole subtree below it in order
+void CourseRadixTree::ForEachWithPrefix(const string& prefix,
+    const function<void(const shared_ptr<const Course>&)>& visit) const {
+    const ArtNode* node = root.get();
+    size_t depth = 0;
+    while (node && depth < prefix.size()) {
+        if (node->type == ArtNode::Leaf) {
+            const shared_ptr<const Course>& record = static_cast<const ArtLeaf*>(node)->record;
+            if (record->courseId.compare(0, prefix.size(), prefix) == 0) visit(record);
+            return;
+        }
+        const ArtInner* inner = static_cast<const ArtInner*>(node);
+        size_t compared = min(inner->prefix.size(), prefix.size() - depth);
+        if (prefix.compare(depth, compared, inner->prefix, 0, compared) != 0) return;
+        depth += inner->prefix.size();
+        if (depth >= prefix.size()) break;
+        node = findChild(inner, static_cast<uint8_t>(prefix[depth]));
+        depth++;
+    }
+    if (node) visitInOrder(node, visit);
+}
+
+void CourseRadixTree::countNodes(const ArtNode* node, NodeCounts& counts) {
+    switch (node->type) {
+    case ArtNode::Leaf: counts.leaves++; return;
+    case ArtNode::Node4: counts.node4++; break;
+    case ArtNode::Node16: counts.node16++; break;
+    case ArtNode::Node48: counts.node48++; break;
+    case ArtNode::Node256: counts.node256++; break;
+    }
+    const ArtInner* inner = static_cast<const ArtInner*>(node);
+    for (int byte = 0; byte < 256; ++byte) {
+        const ArtNode* child = findChild(inner, static_cast<uint8_t>(byte));
+        if (child) countNodes(child, counts);
+    }
+}
+
+CourseRadixTree::NodeCounts CourseRadixTree::GetNodeCounts() const {
+    NodeCounts counts;
+    if (root) countNodes(root.get(), counts);
+    return counts;
+}
+
+//============================================================================
+// Prerequisite graph
+// Compact copy of a catalog's prerequisite edges for traversal-heavy work.
+// Courses get dense integer handles and each course's prerequisites are one
+// contiguous run of handles (compressed sparse rows). Handles start in
+// course ID order, which scatters a prerequisite walk across memory; a
+// relabeling pass renumbers them so that related courses sit close together.
+// Callers work with course IDs and records, so renumbering is invisible
+// except through the handle mapping accessors. A loaded catalog builds one
+// and runs its prerequisite orders, cycle checks and dependents through it
+//============================================================================
+
+enum class GraphOrder {
+    CourseId,            // Handles in course ID order, as built
+    TopologicalLevel,    // By longest prerequisite chain below each course
+    BreadthFirst,        // Breadth-first along prerequisites from top courses
+    ReverseCuthillMcKee  // Bandwidth-reducing order of the undirected graph
+};
+
+class PrerequisiteGraph {
+public:
+    static constexpr uint32_t noHandle = UINT32_MAX;
+
+private:
+    vector<const Course*> courses;        // Record by handle
+    vector<uint32_t> offsets;             // Prerequisites of h: edges[offsets[h], offsets[h + 1])
+    vector<uint32_t> edges;
+    vector<uint64_t> builtKeys;           // Packed ID by handle as built, in course ID order
+    bool builtPacked = true;              // Every ID packed: search the keys alone
+    vector<uint32_t> currentHandles;      // Handle as built to current handle
+    vector<uint32_t> originalHandles;     // Current handle to handle as built
+    vector<pair<const Course*, const string*>> missing;  // Prerequisites not in the catalog
+
+    // Reverse edges in the same layout, built by the first query that needs
+    // them; readers that find them built use them without locking
+    mutable mutex reverseMutex;
+    mutable atomic<bool> reverseBuilt{ false };
+    mutable vector<uint32_t> reverseOffsets;
+    mutable vector<uint32_t> reverseEdges;
+
+    static atomic<GraphOrder> loadOrder;
+
+    uint32_t builtHandleOf(const string& courseId) const;
+    void buildReverse() const;
+    bool postOrder(uint32_t start, vector<const Course*>* order) const;
+    vector<uint32_t> levelOrder() const;
+    vector<uint32_t> breadthFirstOrder() const;
+    vector<uint32_t> reverseCuthillMcKeeOrder() const;
+    void renumber(const vector<uint32_t>& order);
+
+public:
+    explicit PrerequisiteGraph(const BinarySearchTree& catalog);
+
+    PrerequisiteGraph(const PrerequisiteGraph&) = delete;
+    PrerequisiteGraph& operator=(const PrerequisiteGraph&) = delete;
+
+    // Renumbers the handles; traversal results are unchanged
+    void Relabel(GraphOrder order);
+
+    // Order the loaders relabel each catalog's graph in; course ID order
+    // (no relabeling) unless changed
+    static GraphOrder LoadOrder() { return loadOrder.load(memory_order_relaxed); }
+    static void SetLoadOrder(GraphOrder order) { loadOrder.store(order, memory_order_relaxed); }
+
+    size_t Size() const { return courses.size(); }
+    size_t EdgeCount() const { return edges.size(); }
+
+    // Each listed prerequisite left out because no course has its ID, with
+    // the course listing it, in course ID order
+    const vector<pair<const Course*, const string*>>& MissingPrerequisites() const { return missing; }
+    uint32_t HandleOf(const string& courseId) const;
+    const Course* CourseOf(uint32_t handle) const { return courses[handle]; }
+    uint32_t OriginalHandle(uint32_t handle) const { return originalHandles[handle]; }
+    uint64_t KeyOf(uint32_t handle) const { return builtKeys[originalHandles[handle]]; }
+    pair<const uint32_t*, const uint32_t*> Prerequisites(uint32_t handle) const {
+        return { edges.data() + offsets[handle], edges.data() + offsets[handle + 1] };
+    }
+
+    // Courses that list the course as a prerequisite, once per listing. The
+    // reverse edges are built by the first call, or ahead of it
+    pair<const uint32_t*, const uint32_t*> Dependents(uint32_t handle) const;
+    void BuildDependents() const { buildReverse(); }
+    bool HasDependents() const { return reverseBuilt.load(memory_order_acquire); }
+
+    // Every course reachable through prerequisites, excluding the course
+    vector<uint32_t> PrerequisiteClosure(uint32_t handle) const;
+
+    // Same order and errors as BinarySearchTree::GetPrerequisiteOrder
+    vector<const Course*> GetPrerequisiteOrder(const string& courseId) const;
+    vector<const Course*> GetPrerequisiteOrder(uint32_t handle) const;
+    bool HasCycleFrom(uint32_t handle) const;
+
+    // Mean distance between a course's handle and its prerequisites' handles
+    double MeanEdgeDistance() const;
+
+    // Bytes of the forward and, once built, the reverse edges
+    size_t Bytes() const;
+    size_t DependentBytes() const;
+};
+
+atomic<GraphOrder> PrerequisiteGraph::loadOrder{ GraphOrder::CourseId };
+
+// Visit marks shared by every walk on a thread. A walk takes fresh stamp
+// values instead of clearing the marks, so repeated walks never clear or
+// reallocate them
+struct GraphWalkMarks {
+    vector<uint32_t> marks;
+    uint32_t stamp = 0;
+    vector<pair<uint32_t, uint32_t>> path;    // Handle and next edge
+
+    // Reserves count stamp values for a walk over size handles; returns the first
+    uint32_t Begin(size_t size, uint32_t count) {
+        if (marks.size() < size || stamp > UINT32_MAX - count) {
+            marks.assign(max(marks.size(), size), 0);
+            stamp = 0;
+        }
+        uint32_t first = stamp + 1;
+        stamp += count;
+        return first;
+    }
+
+    static GraphWalkMarks& ForThread() {
+        thread_local GraphWalkMarks walk;
+        return walk;
+    }
+};
+
+// Handles follow the catalog's course ID order; prerequisites that are not
+// in the catalog are left out, as the BST traversals skip them, and kept
+// aside for validation. An ID listed twice keeps the record its index finds,
+// the later one. The catalog hands over its packed IDs, so handles are
+// assigned without reading a record unless an ID does not pack; resolving the
+// edges reads every record, so that pass prefetches a batch of records
+// ahead, which are laid out in load order rather than ID order
+PrerequisiteGraph::PrerequisiteGraph(const BinarySearchTree& catalog) {
+    courses.reserve(catalog.Size());
+    builtKeys.reserve(catalog.Size());
+    catalog.ForEachKeyedRecord([this](uint64_t key, const Course* record) {
+        bool repeated = !courses.empty() && ((key != unpackedKey) ? key == builtKeys.back() :
+            courses.back()->courseId == record->courseId);
+        if (repeated) {
+            courses.back() = record;
+            return;
+        }
+        builtPacked = builtPacked && key != unpackedKey;
+        builtKeys.push_back(key);
+        courses.push_back(record);
+    });
+
+    currentHandles.resize(courses.size());
+    originalHandles.resize(courses.size());
+    for (uint32_t h = 0; h < courses.size(); ++h) currentHandles[h] = originalHandles[h] = h;
+
+    offsets.reserve(courses.size() + 1);
+    offsets.push_back(0);
+    for (size_t h = 0; h < courses.size(); ++h) {
+        if (h + prefetchBatch < courses.size()) prefetchRead(&courses[h + prefetchBatch]->prereqs);
+        const Course* course = courses[h];
+        for (const auto& prereqId : course->prereqs) {
+            uint32_t prereq = builtHandleOf(prereqId);
+            if (prereq != noHandle) {
+                edges.push_back(prereq);
+            }
+            else {
+                missing.emplace_back(course, &prereqId);
+            }
+        }
+        offsets.push_back(static_cast<uint32_t>(edges.size()));
+    }
+}
+
+// Binary search of the handles as built, which are in course ID order.
+// Packed keys are compared as integers, without branching on the comparison,
+// and both possible next probes are prefetched, so a search costs its cache
+// misses rather than mispredicted branches
+uint32_t PrerequisiteGraph::builtHandleOf(const string& courseId) const {
+    uint64_t key = packCourseId(courseId);
+    if (builtPacked) {
+        if (key == unpackedKey || builtKeys.empty()) return noHandle;
+        const uint64_t* base = builtKeys.data();
+        size_t count = builtKeys.size();
+        while (count > 1) {
+            size_t half = count / 2;
+            prefetchRead(base + half / 2);
+            prefetchRead(base + half + half / 2);
+            base = (base[half] < key) ? base + half : base;
+            count -= half;
+        }
+        size_t found = (base - builtKeys.data()) + (*base < key);
+        return (found < builtKeys.size() && builtKeys[found] == key) ? static_cast<uint32_t>(found) : noHandle;
+    }
+
+    size_t low = 0;
+    size_t high = builtKeys.size();
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (courseIdLess(builtKeys[middle], courses[currentHandles[middle]]->courseId, key, courseId)) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+    return (low < builtKeys.size() && courses[currentHandles[low]]->courseId == courseId) ?
+        static_cast<uint32_t>(low) : noHandle;
+}
+
+uint32_t PrerequisiteGraph::HandleOf(const string& courseId) const {
+    uint32_t built = builtHandleOf(courseId);
+    return (built != noHandle) ? currentHandles[built] : noHandle;
+}
+
+// Counts each course's dependents, then places them, so the reverse edges
+// take two allocations however many courses there are
+void PrerequisiteGraph::buildReverse() const {
+    if (reverseBuilt.load(memory_order_acquire)) return;
+    lock_guard<mutex> lock(reverseMutex);
+    if (reverseBuilt.load(memory_order_relaxed)) return;
+
+    TraceSpan span("Build dependents", "query");
+    vector<uint32_t> starts(courses.size() + 1, 0);
+    for (uint32_t prereq : edges) starts[prereq + 1]++;
+    for (size_t h = 0; h < courses.size(); ++h) starts[h + 1] += starts[h];
+
+    vector<uint32_t> placed(edges.size());
+    vector<uint32_t> next(starts.begin(), starts.end() - 1);
+    for (uint32_t h = 0; h < courses.size(); ++h) {
+        for (uint32_t i = offsets[h]; i < offsets[h + 1]; ++i) {
+            placed[next[edges[i]]++] = h;
+        }
+    }
+    reverseOffsets = move(starts);
+    reverseEdges = move(placed);
+    reverseBuilt.store(true, memory_order_release);
+}
+
+pair<const uint32_t*, const uint32_t*> PrerequisiteGraph::Dependents(uint32_t handle) const {
+    buildReverse();
+    return { reverseEdges.data() + reverseOffsets[handle], reverseEdges.data() + reverseOffsets[handle + 1] };
+}
+
+// Depth-first walk with a per-thread visit stamp, so repeated closures never
+// clear or reallocate a visited set
+vector<uint32_t> PrerequisiteGraph::PrerequisiteClosure(uint32_t handle) const {
+    GraphWalkMarks& walk = GraphWalkMarks::ForThread();
+    uint32_t stamp = walk.Begin(courses.size(), 1);
+    vector<uint32_t>& marks = walk.marks;
+
+    vector<uint32_t> closure;
+    vector<uint32_t> pending(1, handle);
+    marks[handle] = stamp;
+    while (!pending.empty()) {
+        uint32_t current = pending.back();
+        pending.pop_back();
+
+        // Prefetch the marks and edge offsets of the whole run first, so the
+        // loop below does not wait on each neighbour in turn
+        for (uint32_t i = offsets[current]; i < offsets[current + 1]; ++i) {
+            prefetchRead(&marks[edges[i]]);
+            prefetchRead(&offsets[edges[i]]);
+        }
+        for (uint32_t i = offsets[current]; i < offsets[current + 1]; ++i) {
+            uint32_t prereq = edges[i];
+            if (marks[prereq] != stamp) {
+                marks[prereq] = stamp;
+                closure.push_back(prereq);
+                pending.push_back(prereq);
+            }
+        }
+    }
+    return closure;
+}
+
+// Iterative post-order walk below a course, adding each course reached after
+// its own prerequisites. A prerequisite still on the walk's path closes a
+// cycle, and the walk stops there and returns false
+bool PrerequisiteGraph::postOrder(uint32_t start, vector<const Course*>* order) const {
+    GraphWalkMarks& walk = GraphWalkMarks::ForThread();
+    const uint32_t onPath = walk.Begin(courses.size(), 2);
+    const uint32_t done = onPath + 1;
+    vector<uint32_t>& marks = walk.marks;
+    vector<pair<uint32_t, uint32_t>>& path = walk.path;
+
+    path.clear();
+    marks[start] = onPath;
+    path.push_back({ start, offsets[start] });
+    while (!path.empty()) {
+        uint32_t current = path.back().first;
+        uint32_t& next = path.back().second;
+        if (next == offsets[current]) {
+            // First visit: prefetch where every prerequisite's run starts
+            for (uint32_t i = offsets[current]; i < offsets[current + 1]; ++i) {
+                prefetchRead(&offsets[edges[i]]);
+                prefetchRead(&marks[edges[i]]);
+            }
+        }
+        if (next < offsets[current + 1]) {
+            uint32_t prereq = edges[next++];
+            if (marks[prereq] == onPath) return false;
+            if (marks[prereq] != done) {
+                marks[prereq] = onPath;
+                path.push_back({ prereq, offsets[prereq] });
+            }
+            continue;
+        }
+        marks[current] = done;
+        if (order && current != start) order->push_back(courses[current]);
+        path.pop_back();
+    }
+    return true;
+}
+
+vector<const Course*> PrerequisiteGraph::GetPrerequisiteOrder(const string& courseId) const {
+    uint32_t start = HandleOf(courseId);
+    if (start == noHandle) {
+        throw invalid_argument("Course not found: " + courseId);
+    }
+    return GetPrerequisiteOrder(start);
+}
+
+vector<const Course*> PrerequisiteGraph::GetPrerequisiteOrder(uint32_t handle) const {
+    vector<const Course*> order;
+    if (!postOrder(handle, &order)) {
+        throw runtime_error("Circular prerequisite dependency detected for: " + courses[handle]->courseId);
+    }
+    return order;
+}
+
+bool PrerequisiteGraph::HasCycleFrom(uint32_t handle) const {
+    return !postOrder(handle, nullptr);
+}
+
+double PrerequisiteGraph::MeanEdgeDistance() const {
+    if (edges.empty()) return 0.0;
+    double total = 0.0;
+    for (uint32_t h = 0; h < courses.size(); ++h) {
+        for (uint32_t i = offsets[h]; i < offsets[h + 1]; ++i) {
+            total += (edges[i] > h) ? edges[i] - h : h - edges[i];
+        }
+    }
+    return total / edges.size();
+}
+
+size_t PrerequisiteGraph::Bytes() const {
+    return courses.capacity() * sizeof(const Course*) + (offsets.capacity() + edges.capacity() +
+        currentHandles.capacity() + originalHandles.capacity()) * sizeof(uint32_t) +
+        builtKeys.capacity() * sizeof(uint64_t);
+}
+
+size_t PrerequisiteGraph::DependentBytes() const {
+    if (!HasDependents()) return 0;
+    return (reverseOffsets.capacity() + reverseEdges.capacity()) * sizeof(uint32_t);
+}
+
+// Courses without prerequisites first, then by longest chain below them.
+// Courses on a cycle never get a level and are placed last
+vector<uint32_t> PrerequisiteGraph::levelOrder() const {
+    buildReverse();
+    vector<uint32_t> remaining(courses.size());
+    vector<uint32_t> level(courses.size(), noHandle);
+    vector<uint32_t> ready;
+    for (uint32_t h = 0; h < courses.size(); ++h) {
+        remaining[h] = offsets[h + 1] - offsets[h];
+        if (remaining[h] == 0) {
+            level[h] = 0;
+            ready.push_back(h);
+        }
+    }
+    for (size_t i = 0; i < ready.size(); ++i) {
+        uint32_t current = ready[i];
+        for (uint32_t e = reverseOffsets[current]; e < reverseOffsets[current + 1]; ++e) {
+            uint32_t dependent = reverseEdges[e];
+            if (--remaining[dependent] == 0) {
+                level[dependent] = level[current] + 1;
+                ready.push_back(dependent);
+            }
+        }
+    }
+
+    vector<uint32_t> order(courses.size());
+    for (uint32_t h = 0; h < order.size(); ++h) order[h] = h;
+    stable_sort(order.begin(), order.end(), [&level](uint32_t a, uint32_t b) { return level[a] < level[b]; });
+    return order;
+}
+
+// Starts from each course nothing depends on and numbers its prerequisites
+// as they are reached, so a course's closure follows it closely
+vector<uint32_t> PrerequisiteGraph::breadthFirstOrder() const {
+    buildReverse();
+    vector<uint8_t> seen(courses.size(), 0);
+    vector<uint32_t> order;
+    order.reserve(courses.size());
+
+    auto visitFrom = [&](uint32_t start) {
+        seen[start] = 1;
+        size_t first = order.size();
+        order.push_back(start);
+        for (size_t i = first; i < order.size(); ++i) {
+            uint32_t current = order[i];
+            for (uint32_t e = offsets[current]; e < offsets[current + 1]; ++e) {
+                if (!seen[edges[e]]) {
+                    seen[edges[e]] = 1;
+                    order.push_back(edges[e]);
+                }
+            }
+        }
+    };
+    for (uint32_t h = 0; h < courses.size(); ++h) {
+        if (reverseOffsets[h] == reverseOffsets[h + 1] && !seen[h]) visitFrom(h);
+    }
+    for (uint32_t h = 0; h < courses.size(); ++h) {
+        if (!seen[h]) visitFrom(h);   // Courses reachable only around a cycle
+    }
+    return order;
+}
+
+// Cuthill-McKee over prerequisite and dependent edges, starting each
+// component at a course of lowest degree and taking neighbours by degree,
+// then reversed
+vector<uint32_t> PrerequisiteGraph::reverseCuthillMcKeeOrder() const {
+    buildReverse();
+    vector<uint32_t> degree(courses.size());
+    for (uint32_t h = 0; h < courses.size(); ++h) {
+        degree[h] = (offsets[h + 1] - offsets[h]) + (reverseOffsets[h + 1] - reverseOffsets[h]);
+    }
+    auto byDegree = [&degree](uint32_t a, uint32_t b) {
+        return degree[a] < degree[b] || (degree[a] == degree[b] && a < b);
+    };
+
+    vector<uint32_t> starts(courses.size());
+    for (uint32_t h = 0; h < starts.size(); ++h) starts[h] = h;
+    sort(starts.begin(), starts.end(), byDegree);
+
+    vector<uint8_t> seen(courses.size(), 0);
+    vector<uint32_t> order;
+    order.reserve(courses.size());
+    vector<uint32_t> adjacent;
+    auto take = [&](uint32_t neighbour) {
+        if (!seen[neighbour]) {
+            seen[neighbour] = 1;
+            adjacent.push_back(neighbour);
+        }
+    };
+    for (uint32_t start : starts) {
+        if (seen[start]) continue;
+        seen[start] = 1;
+        size_t first = order.size();
+        order.push_back(start);
+        for (size_t i = first; i < order.size(); ++i) {
+            uint32_t current = order[i];
+            adjacent.clear();
+            for (uint32_t e = reverseOffsets[current]; e < reverseOffsets[current + 1]; ++e) take(reverseEdges[e]);
+            for (uint32_t e = offsets[current]; e < offsets[current + 1]; ++e) take(edges[e]);
+            sort(adjacent.begin(), adjacent.end(), byDegree);
+            order.insert(order.end(), adjacent.begin(), adjacent.end());
+        }
+    }
+    reverse(order.begin(), order.end());
+    return order;
+}
+
+void PrerequisiteGraph::Relabel(GraphOrder order) {
+    switch (order) {
+    case GraphOrder::CourseId:
+        // Back to the handles as built
+        renumber(vector<uint32_t>(currentHandles));
+        break;
+    case GraphOrder::TopologicalLevel:
+        renumber(levelOrder());
+        break;
+    case GraphOrder::BreadthFirst:
+        renumber(breadthFirstOrder());
+        break;
+    case GraphOrder::ReverseCuthillMcKee:
+        renumber(reverseCuthillMcKeeOrder());
+        break;
+    }
+}
+
+// Applies an order listing the current handles in their new positions; the
+// reverse edges are rebuilt from the new handles when next needed
+void PrerequisiteGraph::renumber(const vector<uint32_t>& order) {
+    vector<uint32_t> newHandle(order.size());
+    for (uint32_t h = 0; h < order.size(); ++h) newHandle[order[h]] = h;
+
+    vector<const Course*> newCourses(courses.size());
+    vector<uint32_t> newOffsets;
+    vector<uint32_t> newEdges;
+    vector<uint32_t> newOriginals(courses.size());
+    newOffsets.reserve(offsets.size());
+    newEdges.reserve(edges.size());
+    newOffsets.push_back(0);
+    for (uint32_t h = 0; h < order.size(); ++h) {
+        uint32_t old = order[h];
+        newCourses[h] = courses[old];
+        newOriginals[h] = originalHandles[old];
+        for (uint32_t i = offsets[old]; i < offsets[old + 1]; ++i) {
+            newEdges.push_back(newHandle[edges[i]]);
+        }
+        newOffsets.push_back(static_cast<uint32_t>(newEdges.size()));
+    }
+    for (auto& handle : currentHandles) handle = newHandle[handle];
+
+    courses = move(newCourses);
+    offsets = move(newOffsets);
+    edges = move(newEdges);
+    originalHandles = move(newOriginals);
+    reverseBuilt.store(false, memory_order_relaxed);
+    reverseOffsets = vector<uint32_t>();
+    reverseEdges = vector<uint32_t>();
+}
+
+// Builds the catalog's prerequisite graph in the given handle order; its
+// prerequisite orders, cycle checks and dependents run through the graph
+// from then on, until the catalog changes. The reverse edges are a few
+// passes over the forward ones, so they are built here rather than left to
+// the first query that shows a course
+void BinarySearchTree::BuildPrerequisiteGraph(GraphOrder order) {
+    TraceSpan span("Build prerequisite graph", "load");
+    auto built = make_shared<PrerequisiteGraph>(*this);
+    if (order != GraphOrder::CourseId) {
+        built->Relabel(order);
+    }
+    built->BuildDependents();
+    graph = move(built);
+}
+
+void BinarySearchTree::BuildPrerequisiteGraph() {
+    BuildPrerequisiteGraph(PrerequisiteGraph::LoadOrder());
+}
+
+// Whether the reverse edges have been built, by the graph or without one
+bool BinarySearchTree::HasDependentIndex() const {
+    return graph ? graph->HasDependents() : dependentIndex.load(memory_order_acquire) != nullptr;
+}
+
+// Courses that list a course as a prerequisite, from the graph's reverse
+// edges when there is a graph, and from the dependent index otherwise
+vector<const Course*> BinarySearchTree::dependentsOf(const Course* course) const {
+    vector<const Course*> result;
+    if (graph) {
+        uint32_t handle = graph->HandleOf(course->courseId);
+        if (handle == PrerequisiteGraph::noHandle) return result;
+        auto range = graph->Dependents(handle);
+        for (const uint32_t* dependent = range.first; dependent != range.second; ++dependent) {
+            result.push_back(graph->CourseOf(*dependent));
+        }
+        return result;
+    }
+
+    const DependentIndex& index = dependents();
+    auto it = index.find(course);
+    if (it != index.end()) result.assign(it->second.begin(), it->second.end());
+    return result;
+}
+
+// Finds a course for display. With a graph, its handle search finds the
+// record too, so the dependents need no second search; handle is left alone
+// otherwise
+const Course* BinarySearchTree::findCourse(const string& courseId, uint32_t& handle) const {
+    if (!graph) return FindInTree(courseId);
+    handle = graph->HandleOf(courseId);
+    return (handle != PrerequisiteGraph::noHandle) ? graph->CourseOf(handle) : nullptr;
+}
+
+// Appends a "- ID" line per dependent, or "None", reading the graph's reverse
+// edges in place. handle is the course's graph handle if findCourse set it
+void BinarySearchTree::appendDependents(const Course* course, uint32_t handle, string& text) const {
+    if (!graph) {
+        const DependentIndex& index = dependents();
+        auto it = index.find(course);
+        if (it == index.end() || it->second.empty()) {
+            text.append("        None\n");
+            return;
+        }
+        for (const Course* dependent : it->second) {
+            text.append("        - ").append(dependent->courseId).append("\n");
+        }
+        return;
+    }
+
+    if (handle == PrerequisiteGraph::noHandle) handle = graph->HandleOf(course->courseId);
+    auto range = (handle != PrerequisiteGraph::noHandle) ? graph->Dependents(handle) :
+        pair<const uint32_t*, const uint32_t*>();
+    if (range.first == range.second) {
+        text.append("        None\n");
+        return;
+    }
+    // A packed ID is unpacked from the graph's keys rather than read from
+    // its record, which is rarely cached
+    for (const uint32_t* dependent = range.first; dependent != range.second; ++dependent) {
+        uint64_t key = graph->KeyOf(*dependent);
+        text.append("        - ");
+        if (key != unpackedKey) {
+            appendPackedCourseId(key, text);
+        }
+        else {
+            text.append(graph->CourseOf(*dependent)->courseId);
+        }
+        text.append("\n");
+    }
+}
+
+bool BinarySearchTree::graphHasCycle(const Course* course) const {
+    return graph->HasCycleFrom(graph->HandleOf(course->courseId));
+}
+
+vector<const Course*> BinarySearchTree::graphPrerequisiteOrder(const Course* course) const {
+    return graph->GetPrerequisiteOrder(graph->HandleOf(course->courseId));
+}
+
+// The graph left out exactly the prerequisites that are not in the catalog;
+// the first is reported as the hash walk would report it
+bool BinarySearchTree::graphPrerequisitesValid() const {
+    const auto& missing = graph->MissingPrerequisites();
+    if (missing.empty()) return true;
+    cerr << "Validation error: Invalid prerequisite: " << *missing.front().second << " for course "
+        << missing.front().first->courseId << endl;
+    return false;
+}
+
+// The graph's own arrays, and its reverse edges as the dependent lists
+void BinarySearchTree::countGraphMemory(vector<MemoryUsage>& usage) const {
+    if (!graph) return;
+    usage[8].objects = graph->Size();
+    usage[8].bytes = graph->Bytes();
+    if (graph->HasDependents()) {
+        usage[5].objects = graph->EdgeCount();
+        usage[5].bytes = graph->DependentBytes();
+    }
+}
+
+//============================================================================
+// Transfer equivalences
+// Courses of different catalogs that are accepted as equivalent for transfer
+// credit, kept as equivalence classes in a union-find structure
+//============================================================================
+
+// A course identified by the catalog that defines it
+struct CatalogCourse {
+    string tenant;
+    string courseId;
+};
+
+class TransferEquivalence {
+private:
+    unordered_map<string, size_t> elementIndex;  // Catalog course key to element
+    vector<CatalogCourse> courses;               // Element to catalog course
+    vector<size_t> parent;                       // Union-find parent links
+    vector<vector<size_t>> members;              // Class members, kept at each root
+
+    size_t elementFor(const CatalogCourse& course);
+    size_t findRoot(size_t element) const;
+
+public:
+    static const size_t noClass = static_cast<size_t>(-1);
+
+    static string MakeKey(const CatalogCourse& course);
+
+    void AddEquivalence(const CatalogCourse& a, const CatalogCourse& b);
+    size_t ClassOf(const CatalogCourse& course) const;
+    vector<CatalogCourse> EquivalentCourses(const CatalogCourse& course) const;
+    size_t Size() const { return courses.size(); }
+};
+
+// Key of a catalog course; the separator cannot occur in a tenant name read
+// from a line of text
+string TransferEquivalence::MakeKey(const CatalogCourse& course) {
+    return course.tenant + '\n' + course.courseId;
+}
+
+// Returns the element for a course, adding it as a class of its own if new
+size_t TransferEquivalence::elementFor(const CatalogCourse& course) {
+    auto inserted = elementIndex.emplace(MakeKey(course), courses.size());
+    if (inserted.second) {
+        courses.push_back(course);
+        parent.push_back(courses.size() - 1);
+        members.push_back({ courses.size() - 1 });
+    }
+    return inserted.first->second;
+}
+
+// Follows parent links to the class root. Union by size keeps every path
+// logarithmic, so lookups need not compress paths and stay read-only
+size_t TransferEquivalence::findRoot(size_t element) const {
+    while (parent[element] != element) {
+        element = parent[element];
+    }
+    return element;
+}
+
+// Records that two courses are equivalent, merging their classes
+void TransferEquivalence::AddEquivalence(const CatalogCourse& a, const CatalogCourse& b) {
+    size_t rootA = findRoot(elementFor(a));
+    size_t rootB = findRoot(elementFor(b));
+    if (rootA == rootB) return;
+
+    // Attach the smaller class below the larger one
+    if (members[rootA].size() < members[rootB].size()) {
+        swap(rootA, rootB);
+    }
+    parent[rootB] = rootA;
+    members[rootA].insert(members[rootA].end(), members[rootB].begin(), members[rootB].end());
+    members[rootB].clear();
+    members[rootB].shrink_to_fit();
+}
+
+// Returns the class of a course, or noClass if it has no equivalences
+size_t TransferEquivalence::ClassOf(const CatalogCourse& course) const {
+    auto it = elementIndex.find(MakeKey(course));
+    return (it != elementIndex.end()) ? findRoot(it->second) : noClass;
+}
+
+// Returns every course equivalent to the given one, including itself
+vector<CatalogCourse> TransferEquivalence::EquivalentCourses(const CatalogCourse& course) const {
+    size_t root = ClassOf(course);
+    if (root == noClass) {
+        return { course };
+    }
+
+    vector<CatalogCourse> equivalents;
+    for (size_t element : members[root]) {
+        equivalents.push_back(courses[element]);
+    }
+    return equivalents;
+}
+
+//============================================================================
+// Versioned catalog history
+// Keeps every version of a catalog in a persistent search tree. A new version
+// copies only the nodes on the paths to changed courses and shares the rest
+// of the tree, and the course records themselves, with earlier versions
+//============================================================================
+
+// Immutable tree node. Nodes are ordered by course ID and heap-ordered by a
+// priority derived from the ID (a treap), so the tree stays balanced and a
+// given set of courses always has the same shape in every version
+struct PersistentNode {
+    shared_ptr<const Course> course;
+    size_t priority;
+    shared_ptr<const PersistentNode> left;
+    shared_ptr<const PersistentNode> right;
+};
+
+typedef shared_ptr<const PersistentNode> PersistentTree;
+
+// One committed version of a catalog
+struct CatalogVersion {
+    string label;          // Catalog year or source file
+    PersistentTree root;
+    size_t courseCount;
+};
+
+// Storage used by a history compared with keeping every version in full
+struct HistoryUsage {
+    size_t versions;
+    size_t storedNodes;     // Distinct tree nodes over all versions
+    size_t fullCopyNodes;   // Nodes needed if every version were a full copy
+};
+
+class CatalogHistory {
+private:
+    mutable shared_mutex versionsMutex;   // Guards the version list
+    mutex commitMutex;                    // Serializes commits; readers never wait for it
+    vector<CatalogVersion> versions;
+
+    static size_t priorityOf(const string& courseId);
+    static PersistentTree makeNode(shared_ptr<const Course> course, size_t priority,
+        PersistentTree left, PersistentTree right);
+    static PersistentTree insert(const PersistentTree& node, shared_ptr<const Course> course, size_t priority);
+    static PersistentTree merge(const PersistentTree& left, const PersistentTree& right);
+    static PersistentTree erase(const PersistentTree& node, const string& courseId, bool& removed);
+    static const Course* find(const PersistentTree& node, const string& courseId);
+    static void collect(const PersistentTree& node, vector<const Course*>& courses);
+
+    PersistentTree rootOf(size_t version) const;
+    size_t commitChanges(const string& label, const vector<shared_ptr<const Course>>& upserts,
+        const vector<string>& removals);
+    bool hasCycle(const PersistentTree& root, const Course* course,
+        unordered_set<string>& visited, unordered_set<string>& recursionStack) const;
+    void topologicalSortUtil(const PersistentTree& root, const Course* course,
+        unordered_set<string>& visited, vector<const Course*>& order) const;
+
+public:
+    static const size_t latest = static_cast<size_t>(-1);
+
+    // Creating versions
+    size_t CommitCatalog(const string& label, const BinarySearchTree& catalog);
+    size_t CommitChanges(const string& label, const vector<shared_ptr<const Course>>& upserts,
+        const vector<string>& removals);
+
+    // Version information
+    size_t VersionCount() const;
+    string VersionLabel(size_t version) const;
+    size_t CourseCount(size_t version = latest) const;
+    HistoryUsage GetUsage() const;
+
+    // Queries as of a version
+    const Course* FindCourse(const string& courseId, size_t version = latest) const;
+    vector<const Course*> GetCourses(size_t version = latest) const;
+    vector<const Course*> GetPrerequisiteOrder(const string& courseId, size_t version = latest) const;
+    bool HasPrerequisiteCycle(const string& courseId, size_t version = latest) const;
+    shared_ptr<BinarySearchTree> Materialize(size_t version = latest) const;
+};
+
+// Pseudo-random priority from a course ID (splitmix64 finalizer over its hash)
+size_t CatalogHistory::priorityOf(const string& courseId) {
+    uint64_t value = hash<string>()(courseId) + 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return static_cast<size_t>(value ^ (value >> 31));
+}
+
+PersistentTree CatalogHistory::makeNode(shared_ptr<const Course> course, size_t priority,
+    PersistentTree left, PersistentTree right) {
+    return make_shared<const PersistentNode>(PersistentNode{ move(course), priority, move(left), move(right) });
+}
+
+// Returns a tree with the course added or replaced, copying only the path to it
+PersistentTree CatalogHistory::insert(const PersistentTree& node, shared_ptr<const Course> course, size_t priority) {
+    if (!node) {
+        return makeNode(move(course), priority, nullptr, nullptr);
+    }
+
+    const string& courseId = course->courseId;
+    if (courseId == node->course->courseId) {
+        return makeNode(move(course), node->priority, node->left, node->right);
+    }
+
+    if (courseId < node->course->courseId) {
+        PersistentTree left = insert(node->left, move(course), priority);
+        if (left->priority > node->priority) {  // Rotate the new node up
+            return makeNode(left->course, left->priority, left->left,
+                makeNode(node->course, node->priority, left->right, node->right));
+        }
+        return makeNode(node->course, node->priority, move(left), node->right);
+    }
+
+    PersistentTree right = insert(node->right, move(course), priority);
+    if (right->priority > node->priority) {
+        return makeNode(right->course, right->priority,
+            makeNode(node->course, node->priority, node->left, right->left), right->right);
+    }
+    return makeNode(node->course, node->priority, node->left, move(right));
+}
+
+// Joins two trees whose keys are all ordered left before right
+PersistentTree CatalogHistory::merge(const PersistentTree& left, const PersistentTree& right) {
+    if (!left) return right;
+    if (!right) return left;
+    if (left->priority > right->priority) {
+        return makeNode(left->course, left->priority, left->left, merge(left->right, right));
+    }
+    return makeNode(right->course, right->priority, merge(left, right->left), right->right);
+}
+
+// Returns a tree without the course, copying only the path to it
+PersistentTree CatalogHistory::erase(const PersistentTree& node, const string& courseId, bool& removed) {
+    if (!node) return node;
+
+    if (courseId == node->course->courseId) {
+        removed = true;
+        return merge(node->left, node->right);
+    }
+
+    if (courseId < node->course->courseId) {
+        PersistentTree left = erase(node->left, courseId, removed);
+        return removed ? makeNode(node->course, node->priority, move(left), node->right) : node;
+    }
+    PersistentTree right = erase(node->right, courseId, removed);
+    return removed ? makeNode(node->course, node->priority, node->left, move(right)) : node;
+}
+
+const Course* CatalogHistory::find(const PersistentTree& node, const string& courseId) {
+    const PersistentNode* current = node.get();
+    while (current) {
+        if (courseId == current->course->courseId) return current->course.get();
+        current = (courseId < current->course->courseId) ? current->left.get() : current->right.get();
+    }
+    return nullptr;
+}
+
+void CatalogHistory::collect(const PersistentTree& node, vector<const Course*>& courses) {
+    if (node) {
+        collect(node->left, courses);
+        courses.push_back(node->course.get());
+        collect(node->right, courses);
+    }
+}
+
+// Root of a version; throws for a version that was never committed
+PersistentTree CatalogHistory::rootOf(size_t version) const {
+    shared_lock<shared_mutex> lock(versionsMutex);
+    if (version == latest) {
+        return versions.empty() ? nullptr : versions.back().root;
+    }
+    if (version >= versions.size()) {
+        throw out_of_range("Catalog version not found: " + to_string(version));
+    }
+    return versions[version].root;
+}
+
+// Commits a loaded catalog as the next version. Only courses that differ from
+// the latest version are copied in; records shared through the host's pool
+// are recognised by identity, others by comparing their fields. The diff is
+// taken and applied under the commit lock, so a commit racing this one
+// cannot change the latest version in between
+size_t CatalogHistory::CommitCatalog(const string& label, const BinarySearchTree& catalog) {
+    lock_guard<mutex> commitLock(commitMutex);
+    vector<shared_ptr<const Course>> upserts;
+    vector<string> removals;
+    PersistentTree previous = rootOf(latest);
+
+    catalog.ForEachRecord([&](const shared_ptr<const Course>& record) {
+        const Course* existing = find(previous, record->courseId);
+        if (existing != record.get() && !(existing && *existing == *record)) {
+            upserts.push_back(record);
+        }
+    });
+
+    vector<const Course*> previousCourses;
+    collect(previous, previousCourses);
+    for (const Course* course : previousCourses) {
+        if (!catalog.FindCourse(course->courseId)) {
+            removals.push_back(course->courseId);
+        }
+    }
+
+    return commitChanges(label, upserts, removals);
+}
+
+// Commits the latest version with courses added, replaced or removed;
+// returns the new version number
+size_t CatalogHistory::CommitChanges(const string& label, const vector<shared_ptr<const Course>>& upserts,
+    const vector<string>& removals) {
+    lock_guard<mutex> commitLock(commitMutex);
+    return commitChanges(label, upserts, removals);
+}
+
+// Builds the next version from the latest under the commit lock. The new
+// tree is built while readers still see the latest version; only appending
+// it takes the version list's exclusive lock
+size_t CatalogHistory::commitChanges(const string& label, const vector<shared_ptr<const Course>>& upserts,
+    const vector<string>& removals) {
+    PersistentTree root = rootOf(latest);
+    size_t courseCount = CourseCount(latest);
+
+    for (const auto& record : upserts) {
+        if (!find(root, record->courseId)) courseCount++;
+        root = insert(root, record, priorityOf(record->courseId));
+    }
+    for (const auto& courseId : removals) {
+        bool removed = false;
+        root = erase(root, courseId, removed);
+        if (removed) courseCount--;
+    }
+
+    unique_lock<shared_mutex> lock(versionsMutex);
+    versions.push_back({ label.empty() ? "version " + to_string(versions.size()) : label, move(root), courseCount });
+    return versions.size() - 1;
+}
+
+size_t CatalogHistory::VersionCount() const {
+    shared_lock<shared_mutex> lock(versionsMutex);
+    return versions.size();
+}
+
+string CatalogHistory::VersionLabel(size_t version) const {
+    shared_lock<shared_mutex> lock(versionsMutex);
+    if (version >= versions.size()) {
+        throw out_of_range("Catalog version not found: " + to_string(version));
+    }
+    return versions[version].label;
+}
+
+size_t CatalogHistory::CourseCount(size_t version) const {
+    shared_lock<shared_mutex> lock(versionsMutex);
+    if (versions.empty()) return 0;
+    if (version == latest) return versions.back().courseCount;
+    if (version >= versions.size()) {
+        throw out_of_range("Catalog version not found: " + to_string(version));
+    }
+    return versions[version].courseCount;
+}
+
+// Counts the tree nodes actually stored, shared nodes once
+HistoryUsage CatalogHistory::GetUsage() const {
+    shared_lock<shared_mutex> lock(versionsMutex);
+    HistoryUsage usage = { versions.size(), 0, 0 };
+    unordered_set<const PersistentNode*> seen;
+    vector<const PersistentNode*> pending;
+    for (const auto& version : versions) {
+        usage.fullCopyNodes += version.courseCount;
+        if (version.root) pending.push_back(version.root.get());
+        while (!pending.empty()) {
+            const PersistentNode* node = pending.back();
+            pending.pop_back();
+            if (!seen.insert(node).second) continue;  // Shared subtree already counted
+            if (node->left) pending.push_back(node->left.get());
+            if (node->right) pending.push_back(node->right.get());
+        }
+    }
+    usage.storedNodes = seen.size();
+    return usage;
+}
+
+// O(log n) lookup of a course as of a version
+const Course* CatalogHistory::FindCourse(const string& courseId, size_t version) const {
+    return find(rootOf(version), courseId);
+}
+
+// Returns every course of a version in course ID order
+vector<const Course*> CatalogHistory::GetCourses(size_t version) const {
+    vector<const Course*> courses;
+    collect(rootOf(version), courses);
+    return courses;
+}
+
+// Recursive DFS to detect cycles in prerequisite relationships of a version
+bool CatalogHistory::hasCycle(const PersistentTree& root, const Course* course,
+    unordered_set<string>& visited, unordered_set<string>& recursionStack) const {
+    visited.insert(course->courseId);
+    recursionStack.insert(course->courseId);
+
+    for (const auto& prereqId : course->prereqs) {
+        const Course* prereq = find(root, prereqId);
+        if (!prereq) continue;
+
+        if (recursionStack.count(prereqId)) return true;
+        if (!visited.count(prereqId) && hasCycle(root, prereq, visited, recursionStack)) return true;
+    }
+
+    recursionStack.erase(course->courseId);
+    return false;
+}
+
+// Helper function for topological sort of a version using DFS
+void CatalogHistory::topologicalSortUtil(const PersistentTree& root, const Course* course,
+    unordered_set<string>& visited, vector<const Course*>& order) const {
+    visited.insert(course->courseId);
+
+    for (const auto& prereqId : course->prereqs) {
+        const Course* prereq = find(root, prereqId);
+        if (prereq && !visited.count(prereqId)) {
+            topologicalSortUtil(root, prereq, visited, order);
+        }
+    }
+    order.push_back(course);
+}
+
+// Cycle detection as of a version
+bool CatalogHistory::HasPrerequisiteCycle(const string& courseId, size_t version) const {
+    PersistentTree root = rootOf(version);
+    const Course* course = find(root, courseId);
+    if (!course) {
+        throw invalid_argument("Course not found: " + courseId);
+    }
+
+    unordered_set<string> visited;
+    unordered_set<string> recursionStack;
+    return hasCycle(root, course, visited, recursionStack);
+}
+
+// Returns prerequisites as of a version in the order they should be taken
+vector<const Course*> CatalogHistory::GetPrerequisiteOrder(const string& courseId, size_t version) const {
+    PersistentTree root = rootOf(version);
+    const Course* course = find(root, courseId);
+    if (!course) {
+        throw invalid_argument("Course not found: " + courseId);
+    }
+
+    {
+        unordered_set<string> cycleVisited;
+        unordered_set<string> recursionStack;
+        if (hasCycle(root, course, cycleVisited, recursionStack)) {
+            throw runtime_error("Circular prerequisite dependency detected for: " + courseId);
+        }
+    }
+
+    // Prerequisites finish before the courses that need them, so post-order
+    // is already the order to take them in
+    unordered_set<string> visited;
+    vector<const Course*> order;
+    for (const auto& prereqId : course->prereqs) {
+        const Course* prereq = find(root, prereqId);
+        if (prereq && !visited.count(prereqId)) {
+            topologicalSortUtil(root, prereq, visited, order);
+        }
+    }
+    return order;
+}
+
+// Builds a full catalog for a version, sharing its course records. Records
+// are inserted in pre-order, so the tree takes the version's balanced shape
+shared_ptr<BinarySearchTree> CatalogHistory::Materialize(size_t version) const {
+    auto catalog = make_shared<BinarySearchTree>();
+    vector<const PersistentNode*> pending;
+    PersistentTree root = rootOf(version);
+    if (root) pending.push_back(root.get());
+    while (!pending.empty()) {
+        const PersistentNode* node = pending.back();
+        pending.pop_back();
+        catalog->Insert(node->course);
+        if (node->right) pending.push_back(node->right.get());
+        if (node->left) pending.push_back(node->left.get());
+    }
+    catalog->BuildDependencyGraph();
+    catalog->Freeze();
+    catalog->BuildPrerequisiteGraph();
+    return catalog;
+}
+
+//============================================================================
+// Catalog journal
+// Makes live course edits durable without rewriting the catalog file. Each
+// edit is appended to a write-ahead log before it is acknowledged, and the
+// log is periodically compacted into a binary snapshot. Recovery loads the
+// snapshot and replays only the log written since
+//============================================================================
+
+enum class MutationType : uint8_t { UpsertCourse = 1, RemoveCourse = 2, AddPrerequisite = 3, RemovePrerequisite = 4 };
+
+// One edit; for prerequisite edits the course holds the ID and one prerequisite
+struct CourseMutation {
+    MutationType type;
+    Course course;
+
+    static CourseMutation Upsert(Course course) { return { MutationType::UpsertCourse, move(course) }; }
+    static CourseMutation Remove(const string& courseId) { return { MutationType::RemoveCourse, Course(courseId, "") }; }
+    static CourseMutation AddPrerequisite(const string& courseId, const string& prereqId);
+    static CourseMutation RemovePrerequisite(const string& courseId, const string& prereqId);
+};
+
+CourseMutation CourseMutation::AddPrerequisite(const string& courseId, const string& prereqId) {
+    CourseMutation mutation = { MutationType::AddPrerequisite, Course(courseId, "") };
+    mutation.course.prereqs.push_back(prereqId);
+    return mutation;
+}
+
+CourseMutation CourseMutation::RemovePrerequisite(const string& courseId, const string& prereqId) {
+    CourseMutation mutation = { MutationType::RemovePrerequisite, Course(courseId, "") };
+    mutation.course.prereqs.push_back(prereqId);
+    return mutation;
+}
+
+// Binary encoding shared by log records and snapshots. Integers are written
+// little-endian byte by byte so files are portable between machines
+namespace journal_format {
+
+const char snapshotMagic[] = "CATSNAP1";
+
+inline void putUint32(string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+}
+
+inline void putUint64(string& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+}
+
+inline void putString(string& out, string_view text) {
+    putUint32(out, static_cast<uint32_t>(text.size()));
+    out += text;
+}
+
+inline void putCourse(string& out, const Course& course) {
+    putString(out, course.courseId);
+    putString(out, course.courseTitle.view());
+    putUint32(out, static_cast<uint32_t>(course.prereqs.size()));
+    for (const auto& prereq : course.prereqs) {
+        putString(out, prereq);
+    }
+}
+
+// FNV-1a checksum used to detect torn or corrupted records
+inline uint32_t checksum(const char* data, size_t length) {
+    uint32_t hashValue = 2166136261u;
+    for (size_t i = 0; i < length; ++i) {
+        hashValue = (hashValue ^ static_cast<unsigned char>(data[i])) * 16777619u;
+    }
+    return hashValue;
+}
+
+// Reads the encoding back; any read past the end marks the reader as failed.
+// Titles read from a source point into it rather than being copied
+struct Reader {
+    string_view data;
+    size_t offset;
+    bool ok;
+    shared_ptr<const SourceText> source;
+
+    Reader(string_view bytes, size_t start, shared_ptr<const SourceText> titleSource = nullptr) :
+        data(bytes), offset(start), ok(true), source(move(titleSource)) {}
+
+    bool has(size_t count) {
+        ok = ok && count <= data.size() - offset;
+        return ok;
+    }
+
+    uint64_t getInteger(int width) {
+        if (!has(static_cast<size_t>(width))) return 0;
+        uint64_t value = 0;
+        for (int i = 0; i < width; ++i) {
+            value |= static_cast<uint64_t>(static_cast<unsigned char>(data[offset + i])) << (8 * i);
+        }
+        offset += width;
+        return value;
+    }
+
+    string getString() {
+        size_t length = static_cast<size_t>(getInteger(4));
+        if (!has(length)) return string();
+        string text(data.substr(offset, length));
+        offset += length;
+        return text;
+    }
+
+    CourseTitle getTitle() {
+        size_t length = static_cast<size_t>(getInteger(4));
+        if (!has(length)) return CourseTitle();
+        string_view text = data.substr(offset, length);
+        offset += length;
+        return source ? CourseTitle(source, text) : CourseTitle(string(text));
+    }
+
+    Course getCourse() {
+        string courseId = getString();
+        Course course(move(courseId), getTitle());
+        size_t prereqCount = static_cast<size_t>(getInteger(4));
+        for (size_t i = 0; ok && i < prereqCount; ++i) {
+            course.prereqs.push_back(getString());
+        }
+        return course;
+    }
+};
+
+// Reads a whole file; returns false if it does not exist
+inline bool readFile(const string& path, string& contents) {
+    ifstream file(path, ios::binary);
+    if (!file.is_open()) return false;
+    contents.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    return true;
+}
+
+// Flushes a file through to the storage device
+inline bool syncFile(FILE* file) {
+    if (fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+} // namespace journal_format
+
+class CatalogJournal {
+private:
+    string logPath;
+    string snapshotPath;
+    size_t compactionThreshold;        // Log records that trigger compaction
+
+    mutable mutex journalMutex;        // Guards everything below
+    condition_variable batchWritten;
+    FILE* logFile = nullptr;
+    string pendingBatch;               // Encoded records not yet written
+    uint64_t lastSequence = 0;         // Sequence of the last record appended
+    uint64_t durableSequence = 0;      // Sequence of the last record on disk
+    bool flushing = false;             // A leader is writing a batch
+    bool writeFailed = false;
+    size_t logRecords = 0;             // Records in the log since the snapshot
+    size_t groupCommits = 0;           // Batches written
+    unordered_map<string, shared_ptr<const Course>> courses;  // Durable catalog
+    deque<pair<uint64_t, CourseMutation>> pendingMutations;   // Queued, not yet on disk
+
+    bool courseExists(const string& courseId) const;
+    void validateMutation(const CourseMutation& mutation) const;
+    void applyMutation(const CourseMutation& mutation);
+    void flushThrough(unique_lock<mutex>& lock, uint64_t sequence);
+    bool compact(unique_lock<mutex>& lock);
+
+public:
+    CatalogJournal(string logFilePath, string snapshotFilePath, size_t compactAfter = 10000) :
+        logPath(move(logFilePath)), snapshotPath(move(snapshotFilePath)), compactionThreshold(compactAfter) {}
+    ~CatalogJournal();
+
+    CatalogJournal(const CatalogJournal&) = delete;
+    CatalogJournal& operator=(const CatalogJournal&) = delete;
+
+    // Recovery and durability
+    bool Open();
+    uint64_t Apply(const CourseMutation& mutation);
+    uint64_t Apply(const vector<CourseMutation>& mutations);
+    bool Compact();
+
+    // Current catalog
+    bool BuildCatalog(BinarySearchTree* bst) const;
+    shared_ptr<const Course> Find(const string& courseId) const;
+    size_t Size() const;
+    size_t LogRecords() const;
+    size_t GroupCommits() const;
+};
+
+CatalogJournal::~CatalogJournal() {
+    if (logFile) {
+        fclose(logFile);
+    }
+}
+
+// Recovers the catalog from the snapshot and the log, then opens the log for
+// appending. A torn record at the end of the log (a crash mid-write) is cut
+// off; a damaged snapshot is reported rather than silently ignored
+bool CatalogJournal::Open() {
+    using namespace journal_format;
+    unique_lock<mutex> lock(journalMutex);
+    courses.clear();
+    pendingMutations.clear();
+    pendingBatch.clear();
+    uint64_t snapshotSequence = 0;
+
+    // Titles recovered from the snapshot point into it, mapped where possible
+    string contents;
+    shared_ptr<const SourceText> snapshot = SourceText::Map(snapshotPath);
+    if (!snapshot && readFile(snapshotPath, contents)) {
+        snapshot = make_shared<const SourceText>(move(contents));
+    }
+    if (snapshot) {
+        string_view bytes = snapshot->Text();
+        const size_t magicLength = sizeof(snapshotMagic) - 1;
+        if (bytes.size() < magicLength + 4 || bytes.compare(0, magicLength, snapshotMagic) != 0 ||
+            checksum(bytes.data(), bytes.size() - 4) !=
+            Reader(bytes, bytes.size() - 4).getInteger(4)) {
+            cerr << "Journal snapshot is damaged: " << snapshotPath << endl;
+            return false;
+        }
+
+        Reader reader(bytes, magicLength, snapshot);
+        snapshotSequence = reader.getInteger(8);
+        uint64_t count = reader.getInteger(8);
+        for (uint64_t i = 0; reader.ok && i < count; ++i) {
+            Course course = reader.getCourse();
+            string courseId = course.courseId;
+            courses[courseId] = make_shared<const Course>(move(course));
+        }
+        if (!reader.ok) {
+            cerr << "Journal snapshot is damaged: " << snapshotPath << endl;
+            return false;
+        }
+    }
+
+    // Replay the log; records already covered by the snapshot are skipped,
+    // which happens when a crash came between a snapshot and the log reset
+    lastSequence = snapshotSequence;
+    logRecords = 0;
+    size_t validLength = 0;
+    if (readFile(logPath, contents)) {
+        Reader reader(contents, 0);
+        while (reader.offset < contents.size()) {
+            uint32_t length = static_cast<uint32_t>(reader.getInteger(4));
+            uint32_t expected = static_cast<uint32_t>(reader.getInteger(4));
+            if (!reader.has(length) || checksum(contents.data() + reader.offset, length) != expected) break;
+
+            Reader record(contents, reader.offset);
+            uint64_t sequence = record.getInteger(8);
+            CourseMutation mutation = { static_cast<MutationType>(record.getInteger(1)), Course() };
+            mutation.course = record.getCourse();
+            if (!record.ok) break;
+
+            if (sequence > snapshotSequence) {
+                applyMutation(mutation);
+                lastSequence = sequence;
+                logRecords++;
+            }
+            reader.offset += length;
+            validLength = reader.offset;
+        }
+
+        if (validLength < contents.size()) {
+            filesystem::resize_file(logPath, validLength);
+        }
+    }
+    durableSequence = lastSequence;
+
+    if (logFile) {
+        fclose(logFile);
+    }
+    logFile = fopen(logPath.c_str(), "ab");
+    writeFailed = false;
+    return logFile != nullptr;
+}
+
+// Whether a course exists once every queued edit has been applied
+bool CatalogJournal::courseExists(const string& courseId) const {
+    for (auto it = pendingMutations.rbegin(); it != pendingMutations.rend(); ++it) {
+        if (it->second.course.courseId == courseId) {
+            return it->second.type != MutationType::RemoveCourse;
+        }
+    }
+    return courses.count(courseId) != 0;
+}
+
+// Rejects edits that name a course that does not exist or an invalid ID
+void CatalogJournal::validateMutation(const CourseMutation& mutation) const {
+    const string& courseId = mutation.course.courseId;
+    switch (mutation.type) {
+    case MutationType::UpsertCourse:
+        if (!BinarySearchTree::IsValidCourseId(courseId)) {
+            throw invalid_argument("Invalid course ID format: " + courseId);
+        }
+        break;
+    case MutationType::RemoveCourse:
+    case MutationType::AddPrerequisite:
+    case MutationType::RemovePrerequisite:
+        if (!courseExists(courseId)) {
+            throw invalid_argument("Course not found: " + courseId);
+        }
+        if (mutation.type != MutationType::RemoveCourse && mutation.course.prereqs.size() != 1) {
+            throw invalid_argument("Prerequisite edit needs exactly one prerequisite: " + courseId);
+        }
+        break;
+    default:
+        throw invalid_argument("Unknown course edit");
+    }
+}
+
+// Applies an edit to the current catalog. Records are immutable, so an edit
+// to a course replaces its record
+void CatalogJournal::applyMutation(const CourseMutation& mutation) {
+    const string& courseId = mutation.course.courseId;
+    auto it = courses.find(courseId);
+    switch (mutation.type) {
+    case MutationType::UpsertCourse:
+        courses[courseId] = make_shared<const Course>(mutation.course);
+        break;
+    case MutationType::RemoveCourse:
+        if (it != courses.end()) courses.erase(it);
+        break;
+    case MutationType::AddPrerequisite:
+    case MutationType::RemovePrerequisite: {
+        if (it == courses.end() || mutation.course.prereqs.empty()) break;
+        const string& prereqId = mutation.course.prereqs.front();
+        auto edited = make_shared<Course>(*it->second);
+        auto position = find(edited->prereqs.begin(), edited->prereqs.end(), prereqId);
+        if (mutation.type == MutationType::AddPrerequisite && position == edited->prereqs.end()) {
+            edited->prereqs.push_back(prereqId);
+        }
+        else if (mutation.type == MutationType::RemovePrerequisite) {
+            edited->prereqs.erase(remove(edited->prereqs.begin(), edited->prereqs.end(), prereqId), edited->prereqs.end());
+        }
+        it->second = move(edited);
+        break;
+    }
+    }
+}
+
+// Waits until the record with the given sequence is on disk. The first
+// waiting thread becomes the leader and writes every record queued so far
+// with a single write and sync (group commit); the others wait for it. The
+// leader applies the batch to the catalog only once it is durable, and drops
+// it if the write fails
+void CatalogJournal::flushThrough(unique_lock<mutex>& lock, uint64_t sequence) {
+    while (durableSequence < sequence) {
+        if (writeFailed) {
+            throw runtime_error("Unable to write journal: " + logPath);
+        }
+        if (flushing) {
+            batchWritten.wait(lock);
+            continue;
+        }
+
+        flushing = true;
+        string batch;
+        batch.swap(pendingBatch);
+        uint64_t batchEnd = lastSequence;
+
+        lock.unlock();
+        bool written = fwrite(batch.data(), 1, batch.size(), logFile) == batch.size() &&
+            journal_format::syncFile(logFile);
+        lock.lock();
+
+        flushing = false;
+        if (written) {
+            while (!pendingMutations.empty() && pendingMutations.front().first <= batchEnd) {
+                applyMutation(pendingMutations.front().second);
+                pendingMutations.pop_front();
+                logRecords++;
+            }
+            durableSequence = batchEnd;
+            groupCommits++;
+        }
+        else {
+            pendingMutations.clear();
+            writeFailed = true;
+        }
+        batchWritten.notify_all();
+    }
+}
+
+// Appends an edit to the log and applies it; returns its sequence number once
+// the edit is durable. Throws invalid_argument for an edit that cannot apply
+uint64_t CatalogJournal::Apply(const CourseMutation& mutation) {
+    return Apply(vector<CourseMutation>{ mutation });
+}
+
+// Appends edits to the log and applies them once they are durable; returns
+// the sequence number of the last one. Each edit is checked against the ones
+// before it, and if any cannot apply none of them is logged
+uint64_t CatalogJournal::Apply(const vector<CourseMutation>& mutations) {
+    using namespace journal_format;
+    unique_lock<mutex> lock(journalMutex);
+    if (!logFile) {
+        throw runtime_error("Journal is not open: " + logPath);
+    }
+    if (writeFailed) {
+        throw runtime_error("Unable to write journal: " + logPath);
+    }
+
+    // Encode the records: length, checksum, then sequence, type and course.
+    // Each edit is queued as soon as it passes, so the next sees its effect
+    string records;
+    size_t queued = 0;
+    try {
+        for (const auto& mutation : mutations) {
+            validateMutation(mutation);
+            string payload;
+            putUint64(payload, lastSequence + 1 + queued);
+            payload.push_back(static_cast<char>(mutation.type));
+            putCourse(payload, mutation.course);
+            putUint32(records, static_cast<uint32_t>(payload.size()));
+            putUint32(records, checksum(payload.data(), payload.size()));
+            records += payload;
+            pendingMutations.emplace_back(lastSequence + 1 + queued, mutation);
+            queued++;
+        }
+    }
+    catch (...) {
+        pendingMutations.erase(pendingMutations.end() - queued, pendingMutations.end());
+        throw;
+    }
+
+    lastSequence += queued;
+    uint64_t sequence = lastSequence;
+    pendingBatch += records;
+    flushThrough(lock, sequence);
+
+    if (logRecords >= compactionThreshold) {
+        compact(lock);
+    }
+    return sequence;
+}
+
+bool CatalogJournal::Compact() {
+    unique_lock<mutex> lock(journalMutex);
+    return compact(lock);
+}
+
+// Writes the current catalog as a snapshot and starts an empty log. The
+// snapshot is written to a temporary file and renamed into place, so a crash
+// leaves either the old snapshot and log or the new snapshot. Writers can
+// queue records while this waits for the log; those are not in the durable
+// catalog yet, so the snapshot is stamped with the durable sequence and the
+// records replay from the new log once their leader writes them
+bool CatalogJournal::compact(unique_lock<mutex>& lock) {
+    using namespace journal_format;
+    if (!logFile) return false;
+    flushThrough(lock, lastSequence);
+    while (flushing) {
+        batchWritten.wait(lock);
+    }
+
+    string contents = snapshotMagic;
+    putUint64(contents, durableSequence);
+    putUint64(contents, courses.size());
+    for (const auto& pair : courses) {
+        putCourse(contents, *pair.second);
+    }
+    putUint32(contents, checksum(contents.data(), contents.size()));
+
+    string temporaryPath = snapshotPath + ".tmp";
+    FILE* snapshot = fopen(temporaryPath.c_str(), "wb");
+    if (!snapshot) return false;
+    bool written = fwrite(contents.data(), 1, contents.size(), snapshot) == contents.size() && syncFile(snapshot);
+    fclose(snapshot);
+    if (!written) return false;
+    filesystem::rename(temporaryPath, snapshotPath);
+
+    fclose(logFile);
+    logFile = fopen(logPath.c_str(), "wb");
+    logRecords = 0;
+    return logFile != nullptr;
+}
+
+// Loads the current catalog through the normal BST insert path
+bool CatalogJournal::BuildCatalog(BinarySearchTree* bst) const {
+    if (!bst) return false;
+
+    vector<shared_ptr<const Course>> records;
+    {
+        lock_guard<mutex> lock(journalMutex);
+        records.reserve(courses.size());
+        for (const auto& pair : courses) {
+            records.push_back(pair.second);
+        }
+    }
+
+    // Hash order is effectively random, which keeps the BST shallow
+    for (auto& record : records) {
+        bst->Insert(move(record));
+    }
+    bst->BuildDependencyGraph();
+    if (!bst->ValidateAllPrerequisites()) {
+        cerr << "Warning: Some prerequisites could not be validated" << endl;
+    }
+    return true;
+}
+
+// Returns the durable record of a course, or null if it does not exist
+shared_ptr<const Course> CatalogJournal::Find(const string& courseId) const {
+    lock_guard<mutex> lock(journalMutex);
+    auto it = courses.find(courseId);
+    return (it != courses.end()) ? it->second : nullptr;
+}
+
+size_t CatalogJournal::Size() const {
+    lock_guard<mutex> lock(journalMutex);
+    return courses.size();
+}
+
+size_t CatalogJournal::LogRecords() const {
+    lock_guard<mutex> lock(journalMutex);
+    return logRecords;
+}
+
+size_t CatalogJournal::GroupCommits() const {
+    lock_guard<mutex> lock(journalMutex);
+    return groupCommits;
+}
+
+//============================================================================
+// Catalog diff
+// Compares two catalogs with a sorted merge over their ordered indexes and
+// produces a changeset that can be applied as an incremental update
+//============================================================================
+
+// One course present in both catalogs whose record changed
+struct CourseChange {
+    string courseId;
+    CourseTitle oldTitle;
+    CourseTitle newTitle;
+    vector<string> addedPrereqs;
+    vector<string> removedPrereqs;
+    shared_ptr<const Course> newRecord;
+};
+
+struct CatalogChangeset {
+    vector<shared_ptr<const Course>> added;
+    vector<shared_ptr<const Course>> removed;
+    vector<CourseChange> changed;
+    vector<vector<string>> newCycles;   // Prerequisite cycles not in the old catalog
+
+    bool Empty() const { return added.empty() && removed.empty() && changed.empty(); }
+    vector<CourseMutation> ToMutations() const;
+    size_t CommitTo(CatalogHistory& history, const string& label) const;
+};
+
+// Edits that turn the old catalog into the new one. Changed courses are
+// replaced whole so that prerequisite order is preserved exactly
+vector<CourseMutation> CatalogChangeset::ToMutations() const {
+    vector<CourseMutation> mutations;
+    for (const auto& record : removed) {
+        mutations.push_back(CourseMutation::Remove(record->courseId));
+    }
+    for (const auto& record : added) {
+        mutations.push_back(CourseMutation::Upsert(*record));
+    }
+    for (const auto& change : changed) {
+        mutations.push_back(CourseMutation::Upsert(*change.newRecord));
+    }
+    return mutations;
+}
+
+// Commits the changeset as a new version on top of the old catalog's history
+size_t CatalogChangeset::CommitTo(CatalogHistory& history, const string& label) const {
+    vector<shared_ptr<const Course>> upserts = added;
+    for (const auto& change : changed) {
+        upserts.push_back(change.newRecord);
+    }
+    vector<string> removals;
+    for (const auto& record : removed) {
+        removals.push_back(record->courseId);
+    }
+    return history.CommitChanges(label, upserts, removals);
+}
+
+// Records of a catalog in course ID order. Where an ID was loaded more than
+// once, the record the index resolves to is kept
+vector<shared_ptr<const Course>> orderedRecords(const BinarySearchTree& catalog) {
+    vector<shared_ptr<const Course>> records;
+    records.reserve(catalog.Size());
+    catalog.ForEachRecord([&records, &catalog](const shared_ptr<const Course>& record) {
+        if (catalog.FindCourse(record->courseId) != record.get()) return;
+        records.push_back(record);
+    });
+    return records;
+}
+
+// Strongly connected components that form prerequisite cycles, found with an
+// iterative Tarjan search so that very large catalogs cannot overflow the stack.
+// Each cycle is returned as its sorted course IDs
+vector<vector<string>> findPrerequisiteCycles(const vector<shared_ptr<const Course>>& records) {
+    const size_t unvisited = static_cast<size_t>(-1);
+    unordered_map<string, size_t> position;
+    position.reserve(records.size());
+    for (size_t i = 0; i < records.size(); ++i) {
+        position.emplace(records[i]->courseId, i);
+    }
+
+    vector<size_t> index(records.size(), unvisited);
+    vector<size_t> lowLink(records.size(), 0);
+    vector<bool> onStack(records.size(), false);
+    vector<size_t> componentStack;
+    vector<pair<size_t, size_t>> callStack;   // Course and next prerequisite to follow
+    vector<vector<string>> cycles;
+    size_t nextIndex = 0;
+
+    for (size_t start = 0; start < records.size(); ++start) {
+        if (index[start] != unvisited) continue;
+        callStack.push_back({ start, 0 });
+        index[start] = lowLink[start] = nextIndex++;
+        componentStack.push_back(start);
+        onStack[start] = true;
+
+        while (!callStack.empty()) {
+            size_t course = callStack.back().first;
+            size_t& next = callStack.back().second;
+            const CourseIdList& prereqs = records[course]->prereqs;
+
+            if (next < prereqs.size()) {
+                auto found = position.find(prereqs[next++]);
+                if (found == position.end()) continue;
+                size_t prereq = found->second;
+                if (index[prereq] == unvisited) {
+                    index[prereq] = lowLink[prereq] = nextIndex++;
+                    componentStack.push_back(prereq);
+                    onStack[prereq] = true;
+                    callStack.push_back({ prereq, 0 });
+                }
+                else if (onStack[prereq]) {
+                    lowLink[course] = min(lowLink[course], index[prereq]);
+                }
+                continue;
+            }
+
+            // All prerequisites done: close the component if this is its root
+            callStack.pop_back();
+            if (!callStack.empty()) {
+                size_t caller = callStack.back().first;
+                lowLink[caller] = min(lowLink[caller], lowLink[course]);
+            }
+            if (lowLink[course] != index[course]) continue;
+
+            vector<string> component;
+            size_t member;
+            do {
+                member = componentStack.back();
+                componentStack.pop_back();
+                onStack[member] = false;
+                component.push_back(records[member]->courseId);
+            } while (member != course);
+
+            bool selfLoop = find(prereqs.begin(), prereqs.end(), records[course]->courseId) != prereqs.end();
+            if (component.size() > 1 || selfLoop) {
+                sort(component.begin(), component.end());
+                cycles.push_back(move(component));
+            }
+        }
+    }
+    return cycles;
+}
+
+// Compares two catalogs in time linear in their size (plus the prerequisite
+// lists of courses present in both)
+CatalogChangeset diffCatalogs(const BinarySearchTree& before, const BinarySearchTree& after) {
+    vector<shared_ptr<const Course>> oldRecords = orderedRecords(before);
+    vector<shared_ptr<const Course>> newRecords = orderedRecords(after);
+    CatalogChangeset changeset;
+
+    // Sorted merge of the two ordered indexes
+    size_t i = 0;
+    size_t j = 0;
+    while (i < oldRecords.size() || j < newRecords.size()) {
+        if (j == newRecords.size() || (i < oldRecords.size() && oldRecords[i]->courseId < newRecords[j]->courseId)) {
+            changeset.removed.push_back(oldRecords[i++]);
+            continue;
+        }
+        if (i == oldRecords.size() || newRecords[j]->courseId < oldRecords[i]->courseId) {
+            changeset.added.push_back(newRecords[j++]);
+            continue;
+        }
+
+        const Course& oldCourse = *oldRecords[i];
+        const Course& newCourse = *newRecords[j];
+        if (oldRecords[i] != newRecords[j] && !(oldCourse == newCourse)) {
+            CourseChange change = { newCourse.courseId, oldCourse.courseTitle, newCourse.courseTitle, {}, {}, newRecords[j] };
+
+            // Prerequisite edges are compared as sorted lists
+            vector<string> oldPrereqs(oldCourse.prereqs.begin(), oldCourse.prereqs.end());
+            vector<string> newPrereqs(newCourse.prereqs.begin(), newCourse.prereqs.end());
+            sort(oldPrereqs.begin(), oldPrereqs.end());
+            sort(newPrereqs.begin(), newPrereqs.end());
+            set_difference(newPrereqs.begin(), newPrereqs.end(), oldPrereqs.begin(), oldPrereqs.end(),
+                back_inserter(change.addedPrereqs));
+            set_difference(oldPrereqs.begin(), oldPrereqs.end(), newPrereqs.begin(), newPrereqs.end(),
+                back_inserter(change.removedPrereqs));
+            changeset.changed.push_back(move(change));
+        }
+        i++;
+        j++;
+    }
+
+    // A cycle is new unless the old catalog had exactly the same one
+    vector<vector<string>> oldCycles = findPrerequisiteCycles(oldRecords);
+    sort(oldCycles.begin(), oldCycles.end());
+    for (auto& cycle : findPrerequisiteCycles(newRecords)) {
+        if (!binary_search(oldCycles.begin(), oldCycles.end(), cycle)) {
+            changeset.newCycles.push_back(move(cycle));
+        }
+    }
+    return changeset;
+}
+
+// Displays a changeset grouped by kind of change
+void printChangeset(const CatalogChangeset& changeset) {
+    printSubHeader("Catalog Changes");
+
+    cout << "    Added courses (" << changeset.added.size() << "):" << endl;
+    for (const auto& record : changeset.added) {
+        cout << "        + " << left << setw(10) << record->courseId << "| " << record->courseTitle << endl;
+    }
+
+    cout << "    Removed courses (" << changeset.removed.size() << "):" << endl;
+    for (const auto& record : changeset.removed) {
+        cout << "        - " << left << setw(10) << record->courseId << "| " << record->courseTitle << endl;
+    }
+
+    cout << "    Changed courses (" << changeset.changed.size() << "):" << endl;
+    for (const auto& change : changeset.changed) {
+        cout << "        * " << change.courseId << endl;
+        if (change.oldTitle != change.newTitle) {
+            cout << "            Title: \"" << change.oldTitle << "\" -> \"" << change.newTitle << "\"" << endl;
+        }
+        for (const auto& prereq : change.addedPrereqs) {
+            cout << "            + Prerequisite " << prereq << endl;
+        }
+        for (const auto& prereq : change.removedPrereqs) {
+            cout << "            - Prerequisite " << prereq << endl;
+        }
+        if (change.oldTitle == change.newTitle && change.addedPrereqs.empty() && change.removedPrereqs.empty()) {
+            cout << "            Prerequisite order changed" << endl;
+        }
+    }
+
+    cout << "    New prerequisite cycles (" << changeset.newCycles.size() << "):" << endl;
+    for (const auto& cycle : changeset.newCycles) {
+        cout << "        ! ";
+        for (size_t k = 0; k < cycle.size(); ++k) {
+            cout << (k ? ", " : "") << cycle[k];
+        }
+        cout << endl;
+    }
+    cout << endl;
+    printLine();
+}
+
+//============================================================================
+// Catalog host
+// Hosts many named catalogs (tenants) in one process. Each tenant is served
+// from an immutable snapshot, and identical course records are shared between
+// tenants through a single record pool
+//============================================================================
+
+// A tenant served from a journal. Edits are applied and published under the
+// tenant's lock, so its snapshots and versions follow the journal's order
+struct TenantJournal {
+    CatalogJournal journal;
+    shared_ptr<const BinarySearchTree> published;  // Last snapshot built from the journal
+
+    TenantJournal(string logPath, string snapshotPath) : journal(move(logPath), move(snapshotPath)) {}
+};
+
+class CatalogHost {
+private:
+    shared_ptr<CourseRecordPool> recordPool;
+    mutable shared_mutex catalogsMutex;    // Guards the tenant map only
+    map<string, shared_ptr<const BinarySearchTree>> catalogs;
+    map<string, shared_ptr<CatalogHistory>> histories;  // Every loaded version per tenant
+    map<string, shared_ptr<TenantJournal>> journals;    // Tenants edited live
+    map<string, shared_ptr<mutex>> tenantLocks;         // One per tenant name ever used
+
+    mutable shared_mutex equivalenceMutex; // Guards the transfer equivalences
+    TransferEquivalence equivalences;
+
+    void publishCatalog(const string& tenant, shared_ptr<const BinarySearchTree> catalog);
+    shared_ptr<CatalogHistory> historyFor(const string& tenant);
+    shared_ptr<mutex> tenantLock(const string& tenant);
+    bool refusesLoad(const string& tenant) const;
+    void publishJournal(const string& tenant, TenantJournal& journaled, const string& label);
+    void publishEdits(const string& tenant, TenantJournal& journaled, vector<string> courseIds, const string& label);
+    void publishLoaded(const string& tenant, const string& label, shared_ptr<const BinarySearchTree> catalog);
+    string courseIdentity(const CatalogCourse& course) const;
 
-// Builds graph of course dependencies for prerequisite analysis
-void BinarySearchTree::BuildDependencyGraph() {
-    // Clear existing dependencies
-    for (auto& pair : courseMap) {
-        pair.second->dependentCourses.clear();
-    }
+public:
+    CatalogHost() : recordPool(make_shared<CourseRecordPool>()) {}
 
-    // Build new dependency relationships
-    for (const auto& pair : courseMap) {
-        Course* course = pair.second;
-        for (const auto& prereqId : course->prereqs) {
-            Course* prereq = FindCourse(prereqId);
-            if (prereq) {
-                prereq->dependentCourses.push_back(course->courseId);
-            }
-        }
-    }
-}
+    // Loading and unloading
+    bool LoadCatalog(const string& tenant, const string& filepath);
+    bool LoadCatalog(const string& tenant, istream& input, const string& label = "");
+    bool LoadCatalogFiles(const string& tenant, const string& pattern, vector<CatalogFileResult>& results);
+    bool UnloadCatalog(const string& tenant);
 
-// Recursive DFS to detect cycles in prerequisite relationships
-bool BinarySearchTree::hasCycle(Course* course,
-    unordered_set<string>& visited,
-    unordered_set<string>& recursionStack) {
-    if (!course) return false;
+    // Live editing through a write-ahead journal
+    bool OpenJournal(const string& tenant, const string& directory);
+    uint64_t ApplyEdits(const string& tenant, const vector<CourseMutation>& edits);
 
-    // Mark current course as visited and add to recursion stack
-    visited.insert(course->courseId);
-    recursionStack.insert(course->courseId);
+    // Query routing
+    shared_ptr<const BinarySearchTree> GetCatalog(const string& tenant) const;
+    shared_ptr<const CatalogHistory> GetHistory(const string& tenant) const;
+    shared_ptr<const BinarySearchTree> GetCatalogAsOf(const string& tenant, size_t version) const;
+    vector<string> GetTenants() const;
 
-    // Check all prerequisites for cycles
-    for (const auto& prereqId : course->prereqs) {
-        Course* prereq = FindCourse(prereqId);
-        if (!prereq) continue;
+    // Sharing statistics
+    size_t SharedRecordCount() const { return recordPool->Size(); }
+    size_t RecordReferenceCount() const;
+    void PrintHostReport() const;
 
-        // If course is in recursion stack, found a cycle
-        if (recursionStack.find(prereqId) != recursionStack.end()) {
-            return true;
-        }
+    // Transfer equivalences and federated prerequisite resolution
+    void AddEquivalence(const CatalogCourse& a, const CatalogCourse& b);
+    bool LoadEquivalences(const string& filepath);
+    bool LoadEquivalences(istream& input);
+    bool IsPrerequisiteSatisfied(const CatalogCourse& prerequisite, const vector<CatalogCourse>& completed) const;
+    vector<CatalogCourse> GetFederatedPrerequisiteOrder(const CatalogCourse& target,
+        const vector<CatalogCourse>& completed) const;
+};
 
-        // Continue DFS if course hasn't been visited
-        if (visited.find(prereqId) == visited.end()) {
-            if (hasCycle(prereq, visited, recursionStack)) {
-                return true;
-            }
-        }
+// Swaps a newly built snapshot in for a tenant. Readers holding the previous
+// snapshot keep using it; it is freed outside the lock once they let go
+void CatalogHost::publishCatalog(const string& tenant, shared_ptr<const BinarySearchTree> catalog) {
+    TraceSpan span("Publish catalog", "load");
+    shared_ptr<const BinarySearchTree> previous;
+    {
+        unique_lock<shared_mutex> lock(catalogsMutex);
+        previous = exchange(catalogs[tenant], move(catalog));
     }
-
-    // Remove course from recursion stack when backtracking
-    recursionStack.erase(course->courseId);
-    return false;
+    previous.reset();
+    recordPool->PurgeExpired();
 }
 
-// Public interface for cycle detection
-bool BinarySearchTree::HasPrerequisiteCycle(const string& courseId) {
-    Course* course = FindCourse(courseId);
-    if (!course) {
-        throw invalid_argument("Course not found: " + courseId);
+// Returns the lock that serializes a tenant's loads, edits and unloads.
+// Locks are never removed, so a thread waiting on one after the tenant is
+// unloaded still shares it with every later caller
+shared_ptr<mutex> CatalogHost::tenantLock(const string& tenant) {
+    unique_lock<shared_mutex> lock(catalogsMutex);
+    shared_ptr<mutex>& tenantMutex = tenantLocks[tenant];
+    if (!tenantMutex) {
+        tenantMutex = make_shared<mutex>();
     }
-
-    unordered_set<string> visited;
-    unordered_set<string> recursionStack;
-    return hasCycle(course, visited, recursionStack);
+    return tenantMutex;
 }
 
-// Helper function for topological sort using DFS
-void BinarySearchTree::topologicalSortUtil(Course* course,
-    unordered_set<string>& visited,
-    stack<Course*>& Stack) {
-    visited.insert(course->courseId);
+// Whether a load into a tenant must be refused because it is served from a
+// journal. A journaled tenant changes only through its edits; a loaded file
+// would be reverted by the next edit, which builds on the journal's catalog
+bool CatalogHost::refusesLoad(const string& tenant) const {
+    shared_lock<shared_mutex> lock(catalogsMutex);
+    if (!journals.count(tenant)) return false;
+    cerr << "Catalog is journaled; edit it instead of loading a file: " << tenant << endl;
+    return true;
+}
 
-    // Recursively visit all prerequisites
-    for (const auto& prereqId : course->prereqs) {
-        Course* prereq = FindCourse(prereqId);
-        if (!prereq) continue;
+// Loads or reloads one tenant from a file, mapped where possible. A tenant's
+// loads, edits and unloads run one at a time, under its lock
+bool CatalogHost::LoadCatalog(const string& tenant, const string& filepath) {
+    shared_ptr<mutex> tenantMutex = tenantLock(tenant);
+    lock_guard<mutex> tenantGuard(*tenantMutex);
+    if (refusesLoad(tenant)) return false;
 
-        if (visited.find(prereqId) == visited.end()) {
-            topologicalSortUtil(prereq, visited, Stack);
-        }
+    auto catalog = make_shared<BinarySearchTree>(recordPool);
+    if (!loadDataStructure(filepath, catalog.get())) {
+        return false;
     }
-
-    // Push current course to stack after visiting all prerequisites
-    Stack.push(course);
+    publishLoaded(tenant, filepath, move(catalog));
+    return true;
 }
 
-// Returns prerequisites in order they should be taken
-vector<Course*> BinarySearchTree::GetPrerequisiteOrder(const string& courseId) {
-    Course* course = FindCourse(courseId);
-    if (!course) {
-        throw invalid_argument("Course not found: " + courseId);
-    }
+// Loads or reloads one tenant from a stream. The snapshot is built without
+// holding the host lock, so a load never blocks queries or other tenants; if
+// it fails, the tenant keeps serving its previous snapshot
+bool CatalogHost::LoadCatalog(const string& tenant, istream& input, const string& label) {
+    shared_ptr<mutex> tenantMutex = tenantLock(tenant);
+    lock_guard<mutex> tenantGuard(*tenantMutex);
+    if (refusesLoad(tenant)) return false;
 
-    // Verify no cycles exist before attempting topological sort
-    if (HasPrerequisiteCycle(courseId)) {
-        throw runtime_error("Circular prerequisite dependency detected for: " + courseId);
+    auto catalog = make_shared<BinarySearchTree>(recordPool);
+    if (!loadDataStructure(input, catalog.get())) {
+        return false;
     }
+    publishLoaded(tenant, label, move(catalog));
+    return true;
+}
 
-    unordered_set<string> visited;
-    stack<Course*> Stack;
-    vector<Course*> result;
+// Loads or reloads one tenant from every file in a directory, or every file
+// matching a wildcard, merged into one catalog
+bool CatalogHost::LoadCatalogFiles(const string& tenant, const string& pattern, vector<CatalogFileResult>& results) {
+    vector<string> paths = expandCatalogPaths(pattern);
+    if (paths.empty()) {
+        results.clear();
+        cout << "  No catalog files match: " << pattern << endl;
+        return false;
+    }
 
-    // Process each prerequisite
-    for (const auto& prereqId : course->prereqs) {
-        Course* prereq = FindCourse(prereqId);
-        if (!prereq) continue;
+    shared_ptr<mutex> tenantMutex = tenantLock(tenant);
+    lock_guard<mutex> tenantGuard(*tenantMutex);
+    if (refusesLoad(tenant)) {
+        results.clear();
+        return false;
+    }
 
-        if (visited.find(prereqId) == visited.end()) {
-            topologicalSortUtil(prereq, visited, Stack);
-        }
+    auto catalog = make_shared<BinarySearchTree>(recordPool);
+    if (!loadCatalogFiles(paths, catalog.get(), results)) {
+        return false;
     }
+    publishLoaded(tenant, pattern, move(catalog));
+    return true;
+}
 
-    // Convert stack to vector and reverse for proper order
-    while (!Stack.empty()) {
-        result.push_back(Stack.top());
-        Stack.pop();
+// Commits a freshly loaded catalog to the tenant's version history and
+// publishes it as the tenant's snapshot. Callers hold the tenant's lock, so
+// versions are committed in the order their snapshots become current
+void CatalogHost::publishLoaded(const string& tenant, const string& label, shared_ptr<const BinarySearchTree> catalog) {
+    {
+        TraceSpan span("Commit version", "load");
+        historyFor(tenant)->CommitCatalog(label, *catalog);
     }
+    publishCatalog(tenant, move(catalog));
+}
 
-    reverse(result.begin(), result.end());
-    return result;
+// Publishes the journal's current catalog as the tenant's snapshot
+void CatalogHost::publishJournal(const string& tenant, TenantJournal& journaled, const string& label) {
+    auto catalog = make_shared<BinarySearchTree>(recordPool);
+    journaled.journal.BuildCatalog(catalog.get());
+    catalog->Freeze();
+    catalog->BuildPrerequisiteGraph();
+    historyFor(tenant)->CommitCatalog(label, *catalog);
+    journaled.published = catalog;
+    publishCatalog(tenant, move(catalog));
 }
 
-// Validates prerequisites for all courses in the catalog
-bool BinarySearchTree::ValidateAllPrerequisites() const {
-    for (const auto& pair : courseMap) {
-        try {
-            validatePrerequisites(pair.second);
+// Publishes edited courses on top of the last snapshot built from the
+// journal. The history commits only the courses that changed and the new
+// snapshot shares every other record with the old one
+void CatalogHost::publishEdits(const string& tenant, TenantJournal& journaled, vector<string> courseIds,
+    const string& label) {
+    TraceSpan span("Publish edits", "load");
+    sort(courseIds.begin(), courseIds.end());
+    courseIds.erase(unique(courseIds.begin(), courseIds.end()), courseIds.end());
+
+    const BinarySearchTree& base = *journaled.published;
+    vector<shared_ptr<const Course>> upserts;
+    vector<string> removals;
+    for (const auto& courseId : courseIds) {
+        shared_ptr<const Course> record = journaled.journal.Find(courseId);
+        const Course* existing = base.FindCourse(courseId);
+        if (record && !(existing && *existing == *record)) {
+            upserts.push_back(move(record));
         }
-        catch (const runtime_error& e) {
-            cerr << "Validation error: " << e.what() << endl;
-            return false;
+        else if (!record && existing) {
+            removals.push_back(courseId);
         }
     }
-    return true;
-}
 
-// Displays complete course catalog in alphabetical order
-void BinarySearchTree::PrintSampleSchedule() const {
-    printSubHeader("Complete Course Catalog");
-    cout << "    COURSE ID  | COURSE TITLE" << endl;
-    cout << "  " << string(73, '-') << endl;
+    auto catalog = make_shared<BinarySearchTree>(recordPool);
+    if (!catalog->LoadChanged(base, upserts, removals)) {
+        cerr << "Warning: Some prerequisites could not be validated" << endl;
+    }
+    catalog->BuildPrerequisiteGraph();
+    historyFor(tenant)->CommitChanges(label, upserts, removals);
+    journaled.published = catalog;
+    publishCatalog(tenant, move(catalog));
+}
 
-    if (!root) {
-        cout << "    No courses available." << endl;
-        return;
+// Serves a tenant from a journal directory, recovering its snapshot and log;
+// later edits made with ApplyEdits are durable in that directory. A catalog
+// loaded from a file under the same name is replaced
+bool CatalogHost::OpenJournal(const string& tenant, const string& directory) {
+    shared_ptr<mutex> tenantMutex = tenantLock(tenant);
+    lock_guard<mutex> tenantGuard(*tenantMutex);
+    filesystem::create_directories(directory);
+    string base = (filesystem::path(directory) / "catalog").string();
+    auto journaled = make_shared<TenantJournal>(base + ".wal", base + ".snapshot");
+    if (!journaled->journal.Open()) {
+        return false;
     }
+    publishJournal(tenant, *journaled, directory);
 
-    // Perform in-order traversal to print courses alphabetically
-    printSampleSchedule(root.get());
-    cout << "\n    End of course catalog.\n" << endl;
-    printLine();
+    unique_lock<shared_mutex> lock(catalogsMutex);
+    journals[tenant] = move(journaled);
+    return true;
 }
 
-// Helper function for recursive in-order traversal
-void BinarySearchTree::printSampleSchedule(const Node* node) const {
-    if (node) {
-        printSampleSchedule(node->left.get());
-        cout << "    " << left << setw(10) << node->course->courseId
-            << " | " << node->course->courseTitle << endl;
-        printSampleSchedule(node->right.get());
+// Applies edits to a journaled tenant and republishes it once they are all
+// durable; returns the sequence number of the last edit. Edits to the same
+// tenant are applied and published one call at a time, so a later snapshot
+// or version can never be replaced by an earlier one
+uint64_t CatalogHost::ApplyEdits(const string& tenant, const vector<CourseMutation>& edits) {
+    shared_ptr<mutex> tenantMutex = tenantLock(tenant);
+    lock_guard<mutex> tenantGuard(*tenantMutex);
+    shared_ptr<TenantJournal> journaled;
+    {
+        shared_lock<shared_mutex> lock(catalogsMutex);
+        auto it = journals.find(tenant);
+        if (it == journals.end()) {
+            throw invalid_argument("Catalog is not journaled: " + tenant);
+        }
+        journaled = it->second;
+    }
+
+    uint64_t sequence = journaled->journal.Apply(edits);
+    if (edits.empty()) return sequence;
+
+    vector<string> courseIds;
+    courseIds.reserve(edits.size());
+    for (const auto& edit : edits) {
+        courseIds.push_back(edit.course.courseId);
     }
+    publishEdits(tenant, *journaled, move(courseIds), "edit " + to_string(sequence));
+    return sequence;
 }
 
-// Public interface for course information display
-void BinarySearchTree::PrintCourseInformation(const string& courseId) const {
-    if (!root) {
-        cout << "No courses available." << endl;
-        return;
+// Returns the version history of a tenant, creating it on first use
+shared_ptr<CatalogHistory> CatalogHost::historyFor(const string& tenant) {
+    unique_lock<shared_mutex> lock(catalogsMutex);
+    shared_ptr<CatalogHistory>& history = histories[tenant];
+    if (!history) {
+        history = make_shared<CatalogHistory>();
     }
-    printCourseInformation(root.get(), courseId);
+    return history;
 }
 
-// Displays detailed information for a specific course
-void BinarySearchTree::printCourseInformation(const Node* node, const string& courseId) const {
-    if (!node) {
-        printError("Course " + courseId + " not found");
-        return;
+// Removes a tenant; returns false if it was not hosted. A load or edit of
+// the tenant still running finishes first; one that starts later sees the
+// tenant gone, so an edit fails and a load hosts the tenant anew
+bool CatalogHost::UnloadCatalog(const string& tenant) {
+    shared_ptr<mutex> tenantMutex = tenantLock(tenant);
+    lock_guard<mutex> tenantGuard(*tenantMutex);
+    shared_ptr<const BinarySearchTree> previous;
+    {
+        unique_lock<shared_mutex> lock(catalogsMutex);
+        auto it = catalogs.find(tenant);
+        if (it == catalogs.end()) return false;
+        previous = move(it->second);
+        catalogs.erase(it);
+        histories.erase(tenant);
+        journals.erase(tenant);
     }
+    previous.reset();
+    recordPool->PurgeExpired();
+    return true;
+}
 
-    if (courseId == node->course->courseId) {
-        // Display course details with consistent formatting
-        printSubHeader("Course Details");
-        cout << "    Course ID:   " << node->course->courseId << endl;
-        cout << "    Title:       " << node->course->courseTitle << endl;
-        cout << "    Prerequisites:" << endl;
+// Returns the current snapshot of a tenant, or null if it is not hosted
+shared_ptr<const BinarySearchTree> CatalogHost::GetCatalog(const string& tenant) const {
+    shared_lock<shared_mutex> lock(catalogsMutex);
+    auto it = catalogs.find(tenant);
+    return (it != catalogs.end()) ? it->second : nullptr;
+}
 
-        // Display prerequisites or "None" if empty
-        if (node->course->prereqs.empty()) {
-            cout << "        None" << endl;
-        }
-        else {
-            for (const auto& prereq : node->course->prereqs) {
-                cout << "        - " << prereq << endl;
-            }
-        }
+// Returns the version history of a tenant, or null if it is not hosted
+shared_ptr<const CatalogHistory> CatalogHost::GetHistory(const string& tenant) const {
+    shared_lock<shared_mutex> lock(catalogsMutex);
+    auto it = histories.find(tenant);
+    return (it != histories.end()) ? it->second : nullptr;
+}
 
-        // Display courses that require this course
-        cout << "    Required by:" << endl;
-        if (node->course->dependentCourses.empty()) {
-            cout << "        None" << endl;
-        }
-        else {
-            for (const auto& dep : node->course->dependentCourses) {
-                cout << "        - " << dep << endl;
-            }
-        }
-        cout << endl;
-        printLine();
-        return;
+// Returns a tenant's catalog as it was at a version, or null if the tenant is
+// not hosted; older versions are rebuilt from the shared history
+shared_ptr<const BinarySearchTree> CatalogHost::GetCatalogAsOf(const string& tenant, size_t version) const {
+    if (version == CatalogHistory::latest) {
+        return GetCatalog(tenant);
     }
+    auto history = GetHistory(tenant);
+    return history ? history->Materialize(version) : nullptr;
+}
 
-    // Continue searching in appropriate subtree
-    if (courseId < node->course->courseId) {
-        printCourseInformation(node->left.get(), courseId);
+// Returns the hosted tenant names in alphabetical order
+vector<string> CatalogHost::GetTenants() const {
+    shared_lock<shared_mutex> lock(catalogsMutex);
+    vector<string> tenants;
+    for (const auto& pair : catalogs) {
+        tenants.push_back(pair.first);
     }
-    else {
-        printCourseInformation(node->right.get(), courseId);
+    return tenants;
+}
+
+// Total courses over all tenants, i.e. records before sharing
+size_t CatalogHost::RecordReferenceCount() const {
+    shared_lock<shared_mutex> lock(catalogsMutex);
+    size_t references = 0;
+    for (const auto& pair : catalogs) {
+        references += pair.second->Size();
     }
+    return references;
 }
 
-//============================================================================
-// File loading function
-// Reads course data from a CSV file and populates the BST
-//============================================================================
+// Displays every hosted tenant and how many records are shared
+void CatalogHost::PrintHostReport() const {
+    printSubHeader("Hosted Catalogs");
+    cout << "    " << setw(30) << left << "CATALOG"
+        << " | " << setw(10) << right << "COURSES"
+        << " | " << setw(10) << right << "VERSIONS" << endl;
+    cout << "  " << string(73, '-') << endl;
 
-bool loadDataStructure(const string& filepath, BinarySearchTree* bst) {
-    // Validate BST pointer
-    if (!bst) {
-        cout << "  Unable to open BST pointer" << endl;
-        return false;
+    vector<string> tenants = GetTenants();
+    if (tenants.empty()) {
+        cout << "    No catalogs loaded." << endl;
+    }
+    HistoryUsage historyTotals = { 0, 0, 0 };
+    for (const auto& tenant : tenants) {
+        auto catalog = GetCatalog(tenant);
+        auto history = GetHistory(tenant);
+        HistoryUsage usage = history ? history->GetUsage() : HistoryUsage{ 0, 0, 0 };
+        historyTotals.versions += usage.versions;
+        historyTotals.storedNodes += usage.storedNodes;
+        historyTotals.fullCopyNodes += usage.fullCopyNodes;
+        cout << "    " << setw(30) << left << tenant
+            << " | " << setw(10) << right << (catalog ? catalog->Size() : 0)
+            << " | " << setw(10) << right << usage.versions << endl;
     }
 
-    // Attempt to open input file
+    size_t references = RecordReferenceCount();
+    size_t shared = SharedRecordCount();
+    cout << "\n    Course records stored: " << shared
+        << " (" << references << " catalog entries, "
+        << (references - min(references, shared)) << " shared)" << endl;
+    cout << "    Version history nodes: " << historyTotals.storedNodes
+        << " (" << historyTotals.fullCopyNodes << " if every version were a full copy)\n" << endl;
+}
+
+// Records that two catalog courses are equivalent for transfer credit
+void CatalogHost::AddEquivalence(const CatalogCourse& a, const CatalogCourse& b) {
+    unique_lock<shared_mutex> lock(equivalenceMutex);
+    equivalences.AddEquivalence(a, b);
+}
+
+// Loads equivalences from a file of tenant,courseId,tenant,courseId lines
+bool CatalogHost::LoadEquivalences(const string& filepath) {
     ifstream inputFile(filepath);
     if (!inputFile.is_open()) {
         cout << "  Unable to open file: " << filepath << endl;
         return false;
     }
+    return LoadEquivalences(inputFile);
+}
 
+// Parses equivalence lines from any input stream; a malformed line rejects
+// the input, but lines before it stay recorded
+bool CatalogHost::LoadEquivalences(istream& input) {
     string line;
-    try {
-        // Process file line by line
-        while (getline(inputFile, line)) {
-            if (line.empty()) continue;
+    vector<string> fields;
+    while (getline(input, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
 
-            // Parse CSV format into vector
-            vector<string> courseInfo;
-            size_t start = 0;
-            size_t end = line.find(',');
+        fields.clear();
+        size_t start = 0;
+        size_t end = line.find(',');
+        while (end != string::npos) {
+            fields.emplace_back(line, start, end - start);
+            start = end + 1;
+            end = line.find(',', start);
+        }
+        fields.emplace_back(line, start, string::npos);
 
-            while (end != string::npos) {
-                courseInfo.push_back(line.substr(start, end - start));
-                start = end + 1;
-                end = line.find(',', start);
-            }
-            courseInfo.push_back(line.substr(start));
+        if (fields.size() != 4) {
+            cerr << "Invalid equivalence: " << line << endl;
+            return false;
+        }
+        AddEquivalence({ fields[0], fields[1] }, { fields[2], fields[3] });
+    }
+    return true;
+}
+
+// Identity of a course for federated queries: its equivalence class if it
+// has one, otherwise the course itself. Called with equivalenceMutex held
+string CatalogHost::courseIdentity(const CatalogCourse& course) const {
+    size_t root = equivalences.ClassOf(course);
+    return (root != TransferEquivalence::noClass) ? "#" + to_string(root) : TransferEquivalence::MakeKey(course);
+}
+
+// A prerequisite is satisfied by any completed course equivalent to it
+bool CatalogHost::IsPrerequisiteSatisfied(const CatalogCourse& prerequisite,
+    const vector<CatalogCourse>& completed) const {
+    shared_lock<shared_mutex> lock(equivalenceMutex);
+    string required = courseIdentity(prerequisite);
+    for (const auto& course : completed) {
+        if (courseIdentity(course) == required) return true;
+    }
+    return false;
+}
+
+// Returns the courses still needed before the target, in the order they
+// should be taken. Prerequisites satisfied by an equivalent completed course
+// are skipped along with everything only they require; prerequisites missing
+// from a catalog are resolved to an equivalent course in another catalog
+vector<CatalogCourse> CatalogHost::GetFederatedPrerequisiteOrder(const CatalogCourse& target,
+    const vector<CatalogCourse>& completed) const {
+    TraceSpan span("GetFederatedPrerequisiteOrder", "query");
+    shared_lock<shared_mutex> lock(equivalenceMutex);
 
-            // Skip invalid lines
-            if (courseInfo.size() < 2) continue;
+    // Snapshots are taken once per catalog so the plan is consistent
+    unordered_map<string, shared_ptr<const BinarySearchTree>> snapshots;
+    auto findCourse = [this, &snapshots](const CatalogCourse& course) -> const Course* {
+        auto it = snapshots.find(course.tenant);
+        if (it == snapshots.end()) {
+            it = snapshots.emplace(course.tenant, GetCatalog(course.tenant)).first;
+        }
+        return it->second ? it->second->FindCourse(course.courseId) : nullptr;
+    };
+
+    const Course* targetCourse = findCourse(target);
+    if (!targetCourse) {
+        throw invalid_argument("Course not found: " + target.tenant + " " + target.courseId);
+    }
 
-            // Create new course object
-            auto course = new Course(courseInfo[0], courseInfo[1]);
+    unordered_set<string> satisfied;
+    for (const auto& course : completed) {
+        satisfied.insert(courseIdentity(course));
+    }
 
-            // Add prerequisites if they exist
-            for (size_t i = 2; i < courseInfo.size(); ++i) {
-                if (!courseInfo[i].empty()) {
-                    course->prereqs.push_back(courseInfo[i]);
+    // Depth-first search over the federated graph; equivalent courses share
+    // an identity, so a class is planned at most once
+    unordered_set<string> visited;
+    unordered_set<string> inProgress;
+    vector<CatalogCourse> order;
+    function<void(const CatalogCourse&, const Course*)> visit =
+        [&](const CatalogCourse& at, const Course* course) {
+        for (const auto& prereqId : course->prereqs) {
+            CatalogCourse prereq{ at.tenant, prereqId };
+            const Course* found = findCourse(prereq);
+            if (!found) {
+                for (const auto& equivalent : equivalences.EquivalentCourses(prereq)) {
+                    found = findCourse(equivalent);
+                    if (found) {
+                        prereq = equivalent;
+                        break;
+                    }
                 }
             }
+            if (!found) continue;
 
-            // Attempt to insert course into BST
-            try {
-                bst->Insert(course);
+            string identity = courseIdentity(prereq);
+            if (satisfied.count(identity)) continue;
+            if (inProgress.count(identity)) {
+                throw runtime_error("Circular prerequisite dependency detected for: " + target.courseId);
             }
-            catch (const invalid_argument& e) {
-                cerr << "Error processing file: " << e.what() << endl;
-                inputFile.close();
-                return false;
-            }
-        }
-
-        // Build prerequisite relationships after all courses are loaded
-        bst->BuildDependencyGraph();
+            if (!visited.insert(identity).second) continue;
 
-        // Validate all prerequisites
-        if (!bst->ValidateAllPrerequisites()) {
-            cerr << "Warning: Some prerequisites could not be validated" << endl;
+            inProgress.insert(identity);
+            visit(prereq, found);
+            inProgress.erase(identity);
+            order.push_back(prereq);
         }
+    };
 
-        inputFile.close();
-        return true;
-    }
-    catch (const exception& e) {
-        cerr << "Error processing file: " << e.what() << endl;
-        inputFile.close();
-        return false;
-    }
+    inProgress.insert(courseIdentity(target));
+    visit(target, targetCourse);
+    return order;
 }
 
 //============================================================================
@@ -569,13 +6357,109 @@ bool loadDataStructure(const string& filepath, BinarySearchTree* bst) {
 // Implements the user interface and program flow control
 //============================================================================
 
+// Harnesses that compile this file as a library define ENHANCEMENT_TWO_NO_MAIN
+#ifndef ENHANCEMENT_TWO_NO_MAIN
+
 int main(int argc, char* argv[]) {
+    // Diff mode: compare two catalog files and exit with 0 when they match,
+    // 1 when they differ and 2 when either cannot be loaded
+    if (argc == 4 && string(argv[1]) == "--diff") {
+        BinarySearchTree before;
+        BinarySearchTree after;
+        if (!loadDataStructure(argv[2], &before) || !loadDataStructure(argv[3], &after)) {
+            printError("Failed to load course data");
+            return 2;
+        }
+        CatalogChangeset changeset = diffCatalogs(before, after);
+        printChangeset(changeset);
+        return (changeset.Empty() && changeset.newCycles.empty()) ? 0 : 1;
+    }
+
     // Initialize program variables
     string filepath = (argc == 2) ? argv[1] : "infile.txt";
-    auto bst = make_unique<BinarySearchTree>();
+    CatalogHost host;
+    string currentTenant = "default";
+    const auto emptyCatalog = make_shared<const BinarySearchTree>();
+    shared_ptr<const BinarySearchTree> pinnedCatalog;  // Older version chosen in option 7
     string userCourse;
     int choice = 0;
 
+    // Catalogs given as name=path arguments are loaded in parallel, and the
+    // first one becomes the current catalog
+    vector<thread> loaders;
+    const string equivalencesOption = "--equivalences=";
+    const string traceOption = "--trace=";
+    const string latencyOption = "--latency=";
+    const string graphOrderOption = "--graph-order=";
+    const map<string, GraphOrder> graphOrders = {
+        { "id", GraphOrder::CourseId }, { "level", GraphOrder::TopologicalLevel },
+        { "bfs", GraphOrder::BreadthFirst }, { "rcm", GraphOrder::ReverseCuthillMcKee }
+    };
+    string tracePath;
+    string latencyPath;
+    for (int i = 1; i < argc; ++i) {
+        string argument = argv[i];
+        if (argument.compare(0, traceOption.size(), traceOption) == 0) {
+            tracePath = argument.substr(traceOption.size());
+            Tracer::Enable();
+            continue;
+        }
+        if (argument.compare(0, latencyOption.size(), latencyOption) == 0) {
+            latencyPath = argument.substr(latencyOption.size());
+            continue;
+        }
+        if (argument.compare(0, graphOrderOption.size(), graphOrderOption) == 0) {
+            auto order = graphOrders.find(argument.substr(graphOrderOption.size()));
+            if (order != graphOrders.end()) {
+                PrerequisiteGraph::SetLoadOrder(order->second);
+            }
+            else {
+                cerr << "Unknown graph order; use id, level, bfs or rcm" << endl;
+            }
+            continue;
+        }
+        if (argument.compare(0, equivalencesOption.size(), equivalencesOption) == 0) {
+            if (!host.LoadEquivalences(argument.substr(equivalencesOption.size()))) {
+                cerr << "Unable to load transfer equivalences" << endl;
+            }
+            continue;
+        }
+
+        size_t separator = argument.find('=');
+        if (separator == string::npos) continue;
+
+        string tenant = argument.substr(0, separator);
+        string path = argument.substr(separator + 1);
+        if (loaders.empty()) {
+            currentTenant = tenant;
+            filepath = path;
+        }
+        loaders.emplace_back([&host, tenant, path]() {
+            // A directory holds a journaled catalog, and a wildcard names
+            // several catalog files; anything else is a single catalog file
+            bool loaded = false;
+            if (filesystem::is_directory(path)) {
+                loaded = host.OpenJournal(tenant, path);
+            }
+            else if (hasWildcard(path)) {
+                vector<CatalogFileResult> results;
+                loaded = host.LoadCatalogFiles(tenant, path, results);
+                for (const auto& result : results) {
+                    if (!result.error.empty()) cerr << result.path << ": " << result.error << endl;
+                }
+            }
+            else {
+                loaded = host.LoadCatalog(tenant, path);
+            }
+            if (!loaded) {
+                cerr << "Unable to load catalog " << tenant << " from " << path << endl;
+            }
+        });
+    }
+    for (auto& loader : loaders) {
+        loader.join();
+    }
+
     // Display initial program header
     printLine();
 
@@ -593,11 +6477,17 @@ int main(int argc, char* argv[]) {
 
         cout << endl;
 
+        // Queries run against the current snapshot of the selected catalog
+        shared_ptr<const BinarySearchTree> bst = pinnedCatalog ? pinnedCatalog : host.GetCatalog(currentTenant);
+        if (!bst) {
+            bst = emptyCatalog;
+        }
+
         try {
             switch (choice) {
             case 1: {  // Load course data
                 printSubHeader("Load Course Data");
-                printInputPrompt("Enter file path (or press Enter for default 'infile.txt'): ");
+                printInputPrompt("Enter file, directory or pattern (or press Enter for default 'infile.txt'): ");
 
                 string input;
                 cin.ignore();
@@ -612,9 +6502,23 @@ int main(int argc, char* argv[]) {
                     filepath = input;
                 }
 
-                cout << "\n    Loading...\n" << endl;
+                cout << "\n    Loading into catalog '" << currentTenant << "'...\n" << endl;
+
+                // A directory or wildcard imports every matching file
+                bool loaded = false;
+                if (filesystem::is_directory(filepath) || hasWildcard(filepath)) {
+                    vector<CatalogFileResult> results;
+                    loaded = host.LoadCatalogFiles(currentTenant, filepath, results);
+                    if (!results.empty()) {
+                        printImportReport(results);
+                    }
+                }
+                else {
+                    loaded = host.LoadCatalog(currentTenant, filepath);
+                }
 
-                if (loadDataStructure(filepath, bst.get())) {
+                if (loaded) {
+                    pinnedCatalog.reset();
                     printSuccess("Course data successfully loaded");
                 }
                 else {
@@ -643,7 +6547,7 @@ int main(int argc, char* argv[]) {
                 transform(userCourse.begin(), userCourse.end(), userCourse.begin(), ::toupper);
 
                 try {
-                    vector<Course*> prereqOrder = bst->GetPrerequisiteOrder(userCourse);
+                    vector<const Course*> prereqOrder = bst->GetPrerequisiteOrder(userCourse);
                     cout << "\n    Prerequisite Sequence for " << userCourse << ":" << endl;
                     cout << "    " << string(50, '-') << endl;
 
@@ -674,7 +6578,7 @@ int main(int argc, char* argv[]) {
                 transform(userCourse.begin(), userCourse.end(), userCourse.begin(), ::toupper);
 
                 try {
-                    Course* course = bst->FindCourse(userCourse);
+                    const Course* course = bst->FindCourse(userCourse);
                     if (!course) {
                         printError("Course not found: " + userCourse);
                         break;
@@ -709,13 +6613,111 @@ int main(int argc, char* argv[]) {
                 break;
             }
 
+            case 6:  // Display memory usage and query latency
+                bst->PrintMemoryReport();
+                printLatencyReport();
+                break;
+
+            case 7: {  // Select hosted catalog
+                host.PrintHostReport();
+                printInputPrompt("Enter catalog name, or name@version (Enter keeps '" + currentTenant + "'): ");
+
+                string input;
+                cin.ignore();
+                getline(cin, input);
+
+                // A trailing @version selects the catalog as of that version
+                size_t version = CatalogHistory::latest;
+                size_t separator = input.rfind('@');
+                if (separator != string::npos && separator + 1 < input.size() &&
+                    all_of(input.begin() + separator + 1, input.end(), ::isdigit)) {
+                    version = stoul(input.substr(separator + 1));
+                    input.erase(separator);
+                }
+
+                if (!input.empty()) {
+                    currentTenant = input;
+                }
+                pinnedCatalog.reset();
+                if (version != CatalogHistory::latest) {
+                    auto history = host.GetHistory(currentTenant);
+                    if (!history || version >= history->VersionCount()) {
+                        printError("Version " + to_string(version) + " not found; using the latest version");
+                    }
+                    else {
+                        pinnedCatalog = host.GetCatalogAsOf(currentTenant, version);
+                        cout << "    Using version " << version << " (" << history->VersionLabel(version) << ")" << endl;
+                    }
+                }
+                if (!host.GetCatalog(currentTenant)) {
+                    cout << "    Catalog '" << currentTenant << "' is empty; use option 1 to load it." << endl;
+                }
+                printSuccess("Current catalog: " + currentTenant);
+                printLine();
+                break;
+            }
+
+            case 8: {  // Plan a course using transfer credit
+                printSubHeader("Transfer Plan");
+                printInputPrompt("Enter Course ID: ");
+                cin >> userCourse;
+                transform(userCourse.begin(), userCourse.end(), userCourse.begin(), ::toupper);
+
+                printInputPrompt("Enter completed courses as catalog:ID, separated by commas: ");
+                string input;
+                cin.ignore();
+                getline(cin, input);
+
+                // Courses given without a catalog belong to the current one
+                vector<CatalogCourse> completed;
+                size_t start = 0;
+                while (start <= input.size()) {
+                    size_t end = input.find(',', start);
+                    if (end == string::npos) end = input.size();
+                    string entry = input.substr(start, end - start);
+                    entry.erase(0, entry.find_first_not_of(' '));
+                    entry.erase(entry.find_last_not_of(' ') + 1);
+                    if (!entry.empty()) {
+                        size_t separator = entry.find(':');
+                        CatalogCourse course = (separator == string::npos)
+                            ? CatalogCourse{ currentTenant, entry }
+                            : CatalogCourse{ entry.substr(0, separator), entry.substr(separator + 1) };
+                        transform(course.courseId.begin(), course.courseId.end(), course.courseId.begin(), ::toupper);
+                        completed.push_back(course);
+                    }
+                    start = end + 1;
+                }
+
+                try {
+                    vector<CatalogCourse> plan = host.GetFederatedPrerequisiteOrder({ currentTenant, userCourse }, completed);
+                    cout << "\n    Remaining Prerequisites for " << userCourse << ":" << endl;
+                    cout << "    " << string(50, '-') << endl;
+
+                    if (plan.empty()) {
+                        cout << "    All prerequisites satisfied" << endl;
+                    }
+                    for (size_t i = 0; i < plan.size(); ++i) {
+                        auto catalog = host.GetCatalog(plan[i].tenant);
+                        const Course* course = catalog ? catalog->FindCourse(plan[i].courseId) : nullptr;
+                        cout << "        " << i + 1 << ". " << setw(9) << left << plan[i].courseId << "| "
+                            << (course ? course->courseTitle.view() : string_view()) << " (" << plan[i].tenant << ")" << endl;
+                    }
+                    cout << endl;
+                }
+                catch (const exception& e) {
+                    printError(e.what());
+                }
+                printLine();
+                break;
+            }
+
             case 9:  // Exit program
                 cout << "\n    Thank you for using the Course Management System!\n" << endl;
                 printLine();
                 break;
 
             default:
-                printError("Invalid selection - Please choose 1-5, or 9 to exit");
+                printError("Invalid selection - Please choose 1-8, or 9 to exit");
                 break;
             }
 
@@ -725,5 +6727,15 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    // The timeline covers the whole session: startup loads, reloads and queries
+    if (!tracePath.empty() && !Tracer::Instance().WriteChromeTrace(tracePath)) {
+        cerr << "Unable to write trace to " << tracePath << endl;
+    }
+    if (!latencyPath.empty() && !writeLatencyCsv(latencyPath)) {
+        cerr << "Unable to write query latencies to " << latencyPath << endl;
+    }
+
     return 0;
-}
\ No newline at end of file
+}
+
+#endif // ENHANCEMENT_TWO_NO_MAIN
\ No newline at end of file
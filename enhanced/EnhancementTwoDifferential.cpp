@@ -0,0 +1,1268 @@
+//============================================================================
+// Name        : EnhancementTwoDifferential.cpp
+// Author      : Joey Grippi
+// Version     : 1.0
+// Copyright   : Copyright © 2025
+// Description : Differential test harness for the course engines
+//               Loads generated catalogs of increasing size into the original
+//               and enhanced engines, checks that their listings and course
+//               lookups agree, and records load/query performance side by side
+//============================================================================
+
+// Every standard header used by the engines must be included here, before the
+// engines are pulled into their namespaces, so that the engines' own includes
+// become no-ops instead of being declared inside those namespaces
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <unordered_map>
+#include <unordered_set>
+#include <stack>
+#include <deque>
+#include <stdexcept>
+#include <memory>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <random>
+#include <filesystem>
+#include <atomic>
+#include <array>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <functional>
+#include <bitset>
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <new>
+#include <cstring>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
+
+#define PROJECT_TWO_NO_MAIN
+#define ENHANCEMENT_TWO_NO_MAIN
+
+namespace original {
+#include "../original/ProjectTwo.cpp"
+}
+
+namespace enhanced {
+#include "EnhancementTwo.cpp"
+}
+
+using namespace std;
+using namespace std::chrono;
+
+//============================================================================
+// Allocation-counting hook
+// Replaces the global allocation functions for this program so that the heap
+// allocations made while an engine loads a catalog can be counted
+//============================================================================
+
+static atomic<size_t> allocationCount(0);
+
+// GCC cannot see that this operator delete pairs with the operator new below
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    if (void* memory = malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    free(memory);
+}
+
+// Upper bound on heap allocations per loaded course, per engine; engines
+// without an entry are measured but not checked
+const vector<pair<string, double>> allocationBudgets = {
+    { "enhanced", 3.0 }
+};
+
+// Upper bound on an engine's time for each operation as a multiple of the
+// reference engine's, for catalogs of at least minCourses up to the next
+// entry's size. Smaller catalogs finish too quickly to time reliably and are
+// not checked. The README lists the targets and why each is what it is
+struct SpeedBudget {
+    string engine;
+    size_t minCourses;
+    double load;
+    double listing;
+    double query;             // Steady-state lookups, after the first
+    double firstQuery;        // First lookup after a load, including lazy setup
+};
+
+const vector<SpeedBudget> speedBudgets = {
+    { "enhanced", 10000, 1.1, 1.0, 1.1, 2.0 },
+    { "enhanced", 50000, 1.0, 1.0, 1.1, 2.0 }
+};
+
+// Loads, listings, first lookups and steady-state query passes are each
+// timed this many times and the fastest kept, so one slow pass cannot break
+// a budget
+const int timingRepeats = 5;
+
+//============================================================================
+// Hardware counters
+// Reads Linux perf_event_open counters around each measured operation so a
+// change can be judged by its cache misses and mispredicts, not only by its
+// wall-clock time. Counters that cannot be opened (another OS, no PMU in a
+// virtual machine, perf_event_paranoid too high) are reported as unavailable
+// and the benchmarks still run
+//============================================================================
+
+enum CounterEvent { Cycles, Instructions, LlcMisses, BranchMisses, DtlbMisses, CounterEventCount };
+
+const array<const char*, CounterEventCount> counterNames = {
+    "CYCLES", "INSTR", "LLC MISS", "BR MISS", "DTLB MISS"
+};
+
+struct CounterReading {
+    array<double, CounterEventCount> values{};
+    array<bool, CounterEventCount> valid{};
+};
+
+// One measured operation; values are totals over all of its repetitions
+struct CounterMeasurement {
+    string benchmark;
+    string operation;
+    size_t operations;
+    CounterReading reading;
+};
+
+class HardwareCounters {
+private:
+    array<int, CounterEventCount> descriptors;
+    string unavailableReason;
+    bool running = false;
+    vector<CounterMeasurement> measurements;
+
+public:
+    HardwareCounters() { descriptors.fill(-1); }
+    ~HardwareCounters() { Close(); }
+
+    HardwareCounters(const HardwareCounters&) = delete;
+    HardwareCounters& operator=(const HardwareCounters&) = delete;
+
+    // Opens every counter it can for this process and the threads it starts
+    // afterwards; returns false if none could be opened
+    bool Open() {
+#ifdef __linux__
+        const array<pair<uint32_t, uint64_t>, CounterEventCount> events = { {
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+            { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB |
+                (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) }
+        } };
+        int lastError = 0;
+        for (size_t i = 0; i < events.size(); ++i) {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = events[i].first;
+            attr.config = events[i].second;
+            attr.disabled = 1;
+            attr.inherit = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            // More counters than the PMU has are time-multiplexed and scaled
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            descriptors[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if (descriptors[i] < 0) lastError = errno;
+        }
+        if (!Available()) {
+            unavailableReason = string("perf_event_open failed: ") + strerror(lastError);
+        }
+#else
+        unavailableReason = "perf_event_open is only available on Linux";
+#endif
+        return Available();
+    }
+
+    void Close() {
+#ifdef __linux__
+        for (int& descriptor : descriptors) {
+            if (descriptor >= 0) close(descriptor);
+            descriptor = -1;
+        }
+#endif
+    }
+
+    bool Available() const {
+        return any_of(descriptors.begin(), descriptors.end(), [](int descriptor) { return descriptor >= 0; });
+    }
+
+    const string& UnavailableReason() const { return unavailableReason; }
+
+    const vector<CounterMeasurement>& Measurements() const { return measurements; }
+
+    // Resets and starts every open counter
+    void Start() {
+#ifdef __linux__
+        for (int descriptor : descriptors) {
+            if (descriptor < 0) continue;
+            ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+            ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+        running = true;
+    }
+
+    // Stops the counters and records what they counted for an operation that
+    // was repeated the given number of times. Does nothing after a failed Open
+    void Stop(const string& benchmark, const string& operation, size_t operations) {
+        if (!running) return;
+        running = false;
+        if (!Available()) return;
+
+        CounterMeasurement measurement = { benchmark, operation, operations, {} };
+#ifdef __linux__
+        for (int descriptor : descriptors) {
+            if (descriptor >= 0) ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+        }
+        for (size_t i = 0; i < descriptors.size(); ++i) {
+            // value, time enabled, time running
+            uint64_t values[3] = { 0, 0, 0 };
+            if (descriptors[i] < 0 ||
+                read(descriptors[i], values, sizeof(values)) != static_cast<ssize_t>(sizeof(values)) ||
+                values[2] == 0) {
+                continue;
+            }
+            measurement.reading.values[i] = static_cast<double>(values[0]) *
+                static_cast<double>(values[1]) / static_cast<double>(values[2]);
+            measurement.reading.valid[i] = true;
+        }
+#endif
+        measurements.push_back(measurement);
+    }
+};
+
+static HardwareCounters hardwareCounters;
+
+//============================================================================
+// Course records and engine adapters
+// Each engine is driven through its public interface and its printed output
+// is parsed back into records so that engines can be compared directly
+//============================================================================
+
+struct CourseRecord {
+    string courseId;
+    string courseTitle;
+    vector<string> prereqs;
+
+    bool operator==(const CourseRecord& other) const {
+        return courseId == other.courseId && courseTitle == other.courseTitle && prereqs == other.prereqs;
+    }
+    bool operator!=(const CourseRecord& other) const { return !(*this == other); }
+};
+
+// Redirects cout (and silences cerr) for the lifetime of the object
+class OutputCapture {
+private:
+    ostringstream buffer;
+    ostringstream discarded;
+    streambuf* previousOut;
+    streambuf* previousErr;
+
+public:
+    OutputCapture() :
+        previousOut(cout.rdbuf(buffer.rdbuf())),
+        previousErr(cerr.rdbuf(discarded.rdbuf())) {}
+
+    ~OutputCapture() {
+        cout.rdbuf(previousOut);
+        cerr.rdbuf(previousErr);
+    }
+
+    // Returns and clears everything captured so far
+    string Take() {
+        string text = buffer.str();
+        buffer.str("");
+        return text;
+    }
+};
+
+// Removes leading and trailing whitespace
+string trim(const string& text) {
+    size_t start = text.find_first_not_of(" \t\r\n");
+    if (start == string::npos) return "";
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(start, end - start + 1);
+}
+
+// Splits text into lines
+vector<string> splitLines(const string& text) {
+    vector<string> lines;
+    istringstream stream(text);
+    string line;
+    while (getline(stream, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+// Common interface for every engine taking part in the comparison
+class CatalogEngine {
+public:
+    virtual ~CatalogEngine() = default;
+
+    virtual string Name() const = 0;
+
+    // Loads a catalog file into a fresh instance of the engine
+    virtual bool Load(const string& filepath) = 0;
+
+    // Prints the full catalog listing and returns the captured text
+    virtual string PrintListing() = 0;
+
+    // Prints the information for one course and returns the captured text
+    virtual string PrintCourse(const string& courseId) = 0;
+
+    // Parses captured listing output into records holding ID and title
+    virtual vector<CourseRecord> ParseListing(const string& output) const = 0;
+
+    // Parses captured course output; returns false if the course was not found
+    virtual bool ParseCourse(const string& output, CourseRecord& record) const = 0;
+};
+
+// Adapter for original/ProjectTwo.cpp (value-copy Course BST)
+class OriginalEngine : public CatalogEngine {
+private:
+    unique_ptr<original::BinarySearchTree> bst;
+
+public:
+    string Name() const override { return "original"; }
+
+    bool Load(const string& filepath) override {
+        bst = make_unique<original::BinarySearchTree>();
+        return original::loadDataStructure(filepath, bst.get());
+    }
+
+    string PrintListing() override {
+        OutputCapture capture;
+        bst->PrintSampleSchedule();
+        return capture.Take();
+    }
+
+    string PrintCourse(const string& courseId) override {
+        OutputCapture capture;
+        bst->PrintCourseInformation(courseId);
+        return capture.Take();
+    }
+
+    // Listing lines have the form "ID, Title"
+    vector<CourseRecord> ParseListing(const string& output) const override {
+        vector<CourseRecord> records;
+        for (const auto& line : splitLines(output)) {
+            size_t separator = line.find(", ");
+            if (separator == string::npos) continue;
+            records.push_back({ line.substr(0, separator), line.substr(separator + 2), {} });
+        }
+        return records;
+    }
+
+    // Course output is "ID, Title" followed by "Prerequisite(s): A, B"
+    bool ParseCourse(const string& output, CourseRecord& record) const override {
+        vector<string> lines = splitLines(output);
+        if (lines.size() < 2 || lines[0].find(" not found.") != string::npos) {
+            return false;
+        }
+
+        size_t separator = lines[0].find(", ");
+        if (separator == string::npos) return false;
+        record = { lines[0].substr(0, separator), lines[0].substr(separator + 2), {} };
+
+        const string prefix = "Prerequisite(s): ";
+        if (lines[1].compare(0, prefix.size(), prefix) != 0) return false;
+        string prereqList = lines[1].substr(prefix.size());
+        size_t start = 0;
+        while (start < prereqList.size()) {
+            size_t end = prereqList.find(", ", start);
+            if (end == string::npos) end = prereqList.size();
+            record.prereqs.push_back(prereqList.substr(start, end - start));
+            start = end + 2;
+        }
+        return true;
+    }
+};
+
+// Adapter for enhanced/EnhancementTwo.cpp (pointer BST + hash map)
+class EnhancedEngine : public CatalogEngine {
+private:
+    unique_ptr<enhanced::BinarySearchTree> bst;
+
+public:
+    string Name() const override { return "enhanced"; }
+
+    bool Load(const string& filepath) override {
+        bst = make_unique<enhanced::BinarySearchTree>();
+        OutputCapture capture;
+        return enhanced::loadDataStructure(filepath, bst.get());
+    }
+
+    string PrintListing() override {
+        OutputCapture capture;
+        bst->PrintSampleSchedule();
+        return capture.Take();
+    }
+
+    string PrintCourse(const string& courseId) override {
+        OutputCapture capture;
+        bst->PrintCourseInformation(courseId);
+        return capture.Take();
+    }
+
+    // Listing rows have the form "    ID         | Title" below the header row
+    vector<CourseRecord> ParseListing(const string& output) const override {
+        vector<CourseRecord> records;
+        for (const auto& line : splitLines(output)) {
+            size_t separator = line.find(" | ");
+            if (separator == string::npos) continue;
+            string courseId = trim(line.substr(0, separator));
+            if (courseId == "COURSE ID") continue;
+            records.push_back({ courseId, line.substr(separator + 3), {} });
+        }
+        return records;
+    }
+
+    // Course details are labelled lines followed by a "- ID" prerequisite list
+    bool ParseCourse(const string& output, CourseRecord& record) const override {
+        const string idLabel = "    Course ID:   ";
+        const string titleLabel = "    Title:       ";
+        bool found = false;
+        bool inPrereqs = false;
+        record = {};
+
+        for (const auto& line : splitLines(output)) {
+            if (line.compare(0, idLabel.size(), idLabel) == 0) {
+                record.courseId = line.substr(idLabel.size());
+                found = true;
+            }
+            else if (line.compare(0, titleLabel.size(), titleLabel) == 0) {
+                record.courseTitle = line.substr(titleLabel.size());
+            }
+            else if (line == "    Prerequisites:") {
+                inPrereqs = true;
+            }
+            else if (line == "    Required by:") {
+                inPrereqs = false;
+            }
+            else if (inPrereqs && trim(line).compare(0, 2, "- ") == 0) {
+                record.prereqs.push_back(trim(line).substr(2));
+            }
+        }
+        return found;
+    }
+};
+
+// Every engine that takes part in the comparison; the first is the reference
+vector<unique_ptr<CatalogEngine>> createEngines() {
+    vector<unique_ptr<CatalogEngine>> engines;
+    engines.push_back(make_unique<OriginalEngine>());
+    engines.push_back(make_unique<EnhancedEngine>());
+    return engines;
+}
+
+//============================================================================
+// Catalog generation
+// Produces an acyclic catalog with valid course IDs in shuffled file order
+//============================================================================
+
+struct GeneratedCatalog {
+    string filepath;
+    vector<string> courseIds;
+};
+
+GeneratedCatalog generateCatalog(size_t courseCount, unsigned int seed) {
+    static const vector<string> departments = { "CS", "MAT", "DAT", "IT", "PHY", "ENG", "BIO", "CHEM" };
+    mt19937 rng(seed);
+
+    GeneratedCatalog catalog;
+    vector<string> lines;
+    for (size_t i = 0; i < courseCount; ++i) {
+        string courseId = departments[i % departments.size()] + to_string(100 + i / departments.size());
+        string line = courseId + ",Generated Course Title Number " + to_string(i);
+
+        // Prerequisites are drawn only from earlier courses to keep the graph acyclic
+        if (i > 0) {
+            size_t prereqCount = rng() % 4;
+            unordered_set<size_t> chosen;
+            for (size_t p = 0; p < prereqCount; ++p) {
+                size_t prereq = rng() % i;
+                if (chosen.insert(prereq).second) {
+                    line += "," + catalog.courseIds[prereq];
+                }
+            }
+        }
+
+        catalog.courseIds.push_back(courseId);
+        lines.push_back(line);
+    }
+
+    // Shuffle so neither tree degenerates into a list
+    shuffle(lines.begin(), lines.end(), rng);
+
+    catalog.filepath = (filesystem::temp_directory_path() /
+        ("differential_catalog_" + to_string(courseCount) + ".txt")).string();
+    ofstream output(catalog.filepath, ios::binary);
+    for (size_t i = 0; i < lines.size(); ++i) {
+        // The original loader cannot handle a trailing blank line
+        output << lines[i] << (i + 1 < lines.size() ? "\n" : "");
+    }
+    return catalog;
+}
+
+//============================================================================
+// Differential run
+// Loads, lists and queries every engine and compares against the reference
+//============================================================================
+
+struct EngineMeasurement {
+    string engine;
+    size_t courseCount;
+    double loadMillis;
+    double allocationsPerCourse;  // Heap allocations during load / courses
+    bool overAllocationBudget;
+    string overSpeedBudget;   // Operations slower than the budget allows
+    double listingMillis;
+    double firstQueryMicros;  // First lookup after the load, including lazy setup
+    double queryMicros;       // Average per lookup after the first
+    size_t listingMismatches;
+    size_t lookupMismatches;
+};
+
+// Compares two listings and returns the number of differing rows
+size_t compareListings(const vector<CourseRecord>& expected, const vector<CourseRecord>& actual) {
+    size_t mismatches = (expected.size() > actual.size()) ?
+        expected.size() - actual.size() : actual.size() - expected.size();
+    for (size_t i = 0; i < min(expected.size(), actual.size()); ++i) {
+        if (expected[i].courseId != actual[i].courseId || expected[i].courseTitle != actual[i].courseTitle) {
+            if (mismatches < 5) {
+                cout << "      listing row " << i << ": expected " << expected[i].courseId
+                    << " got " << actual[i].courseId << endl;
+            }
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+// The budget covering an engine at a catalog size: the entry with the
+// largest minimum size not above it, or none
+const SpeedBudget* findSpeedBudget(const string& engine, size_t courseCount) {
+    const SpeedBudget* found = nullptr;
+    for (const auto& budget : speedBudgets) {
+        if (budget.engine == engine && budget.minCourses <= courseCount &&
+            (!found || budget.minCourses > found->minCourses)) {
+            found = &budget;
+        }
+    }
+    return found;
+}
+
+// Names each operation of each engine that is slower than its budget allows
+// relative to the reference engine, the first measurement
+void checkSpeedBudgets(vector<EngineMeasurement>& measurements) {
+    const EngineMeasurement& reference = measurements.front();
+    auto over = [](double time, double referenceTime, double budget) {
+        return referenceTime > 0.0 && time > referenceTime * budget;
+    };
+    for (auto& m : measurements) {
+        const SpeedBudget* budget = findSpeedBudget(m.engine, m.courseCount);
+        if (!budget) continue;
+        vector<string> slow;
+        if (over(m.loadMillis, reference.loadMillis, budget->load)) slow.push_back("load");
+        if (over(m.listingMillis, reference.listingMillis, budget->listing)) slow.push_back("listing");
+        if (over(m.firstQueryMicros, reference.firstQueryMicros, budget->firstQuery)) slow.push_back("first query");
+        if (over(m.queryMicros, reference.queryMicros, budget->query)) slow.push_back("query");
+        for (const auto& operation : slow) {
+            m.overSpeedBudget += (m.overSpeedBudget.empty() ? "" : ",") + operation;
+        }
+    }
+}
+
+// Times one more load, listing, first lookup and steady-state query pass of
+// an engine, keeping the fastest of each
+void timeRepeat(CatalogEngine& engine, const string& filepath, const vector<string>& queries,
+    EngineMeasurement& measurement) {
+    auto start = steady_clock::now();
+    engine.Load(filepath);
+    measurement.loadMillis = min(measurement.loadMillis,
+        duration<double, milli>(steady_clock::now() - start).count());
+
+    start = steady_clock::now();
+    engine.PrintListing();
+    measurement.listingMillis = min(measurement.listingMillis,
+        duration<double, milli>(steady_clock::now() - start).count());
+
+    if (queries.empty()) return;
+    start = steady_clock::now();
+    engine.PrintCourse(queries.front());
+    measurement.firstQueryMicros = min(measurement.firstQueryMicros,
+        duration<double, micro>(steady_clock::now() - start).count());
+
+    start = steady_clock::now();
+    for (size_t q = 1; q < queries.size(); ++q) {
+        engine.PrintCourse(queries[q]);
+    }
+    size_t steadyQueries = max<size_t>(queries.size() - 1, 1);
+    measurement.queryMicros = min(measurement.queryMicros,
+        duration<double, micro>(steady_clock::now() - start).count() / steadyQueries);
+}
+
+vector<EngineMeasurement> runDifferential(size_t courseCount, size_t queryCount, unsigned int seed) {
+    GeneratedCatalog catalog = generateCatalog(courseCount, seed);
+    auto engines = createEngines();
+
+    // Queries mix present courses with IDs that cannot exist in the catalog
+    mt19937 rng(seed + 1);
+    vector<string> queries;
+    for (size_t i = 0; i < queryCount; ++i) {
+        if (i % 10 == 9) {
+            queries.push_back("ZZZ" + to_string(100 + i));
+        }
+        else {
+            queries.push_back(catalog.courseIds[rng() % catalog.courseIds.size()]);
+        }
+    }
+
+    vector<EngineMeasurement> measurements;
+    vector<CourseRecord> referenceListing;
+    vector<pair<bool, CourseRecord>> referenceLookups;
+    vector<bool> loadedEngines(engines.size(), false);
+
+    for (size_t e = 0; e < engines.size(); ++e) {
+        CatalogEngine& engine = *engines[e];
+        EngineMeasurement measurement = { engine.Name(), courseCount, 0.0, 0.0, false, "", 0.0, 0.0, 0.0, 0, 0 };
+
+        string benchmark = "generated " + to_string(courseCount) + " " + engine.Name();
+        size_t allocationsBefore = allocationCount.load();
+        hardwareCounters.Start();
+        auto start = steady_clock::now();
+        bool loaded = engine.Load(catalog.filepath);
+        measurement.loadMillis = duration<double, milli>(steady_clock::now() - start).count();
+        hardwareCounters.Stop(benchmark, "load", courseCount);
+        measurement.allocationsPerCourse =
+            static_cast<double>(allocationCount.load() - allocationsBefore) / courseCount;
+        for (const auto& budget : allocationBudgets) {
+            if (budget.first == engine.Name() && measurement.allocationsPerCourse > budget.second) {
+                measurement.overAllocationBudget = true;
+            }
+        }
+        if (!loaded) {
+            cout << "    [ERROR] " << engine.Name() << " failed to load " << catalog.filepath << endl;
+            measurement.listingMismatches = courseCount;
+            measurements.push_back(measurement);
+            continue;
+        }
+
+        loadedEngines[e] = true;
+
+        hardwareCounters.Start();
+        start = steady_clock::now();
+        string listingOutput = engine.PrintListing();
+        measurement.listingMillis = duration<double, milli>(steady_clock::now() - start).count();
+        hardwareCounters.Stop(benchmark, "listing", courseCount);
+        vector<CourseRecord> listing = engine.ParseListing(listingOutput);
+
+        // Only the engine call is timed; parsing happens afterwards. The first
+        // lookup pays for anything an engine builds lazily, so it is reported
+        // apart from the steady-state average
+        vector<string> lookupOutputs;
+        lookupOutputs.reserve(queries.size());
+        if (!queries.empty()) {
+            start = steady_clock::now();
+            lookupOutputs.push_back(engine.PrintCourse(queries.front()));
+            measurement.firstQueryMicros = duration<double, micro>(steady_clock::now() - start).count();
+        }
+        hardwareCounters.Start();
+        start = steady_clock::now();
+        for (size_t q = 1; q < queries.size(); ++q) {
+            lookupOutputs.push_back(engine.PrintCourse(queries[q]));
+        }
+        size_t steadyQueries = max<size_t>(queries.size() - min<size_t>(queries.size(), 1), 1);
+        measurement.queryMicros = duration<double, micro>(steady_clock::now() - start).count() / steadyQueries;
+        hardwareCounters.Stop(benchmark, "query", queries.size() - min<size_t>(queries.size(), 1));
+
+        vector<pair<bool, CourseRecord>> lookups;
+        for (const auto& output : lookupOutputs) {
+            CourseRecord record;
+            bool found = engine.ParseCourse(output, record);
+            lookups.push_back({ found, record });
+        }
+
+        if (e == 0) {
+            referenceListing = listing;
+            referenceLookups = lookups;
+            measurement.listingMismatches = (listing.size() == courseCount) ? 0 : 1;
+        }
+        else {
+            measurement.listingMismatches = compareListings(referenceListing, listing);
+            for (size_t q = 0; q < lookups.size(); ++q) {
+                if (lookups[q].first != referenceLookups[q].first ||
+                    (lookups[q].first && lookups[q].second != referenceLookups[q].second)) {
+                    if (measurement.lookupMismatches < 5) {
+                        cout << "      lookup " << queries[q] << " differs from "
+                            << engines[0]->Name() << endl;
+                    }
+                    measurement.lookupMismatches++;
+                }
+            }
+        }
+        measurements.push_back(measurement);
+    }
+
+    // Counters, allocations and outputs cover the first pass; repeats only
+    // time. They alternate between the engines, so a slow stretch of the
+    // machine slows every engine's best time rather than one engine's
+    for (int repeat = 1; repeat < timingRepeats; ++repeat) {
+        for (size_t e = 0; e < engines.size(); ++e) {
+            if (loadedEngines[e]) timeRepeat(*engines[e], catalog.filepath, queries, measurements[e]);
+        }
+    }
+
+    checkSpeedBudgets(measurements);
+    filesystem::remove(catalog.filepath);
+    return measurements;
+}
+
+//============================================================================
+// Index benchmark
+// Compares the enhanced engine's ordered indexes and its hash index on point
+// lookups, full ordered iteration and prefix scans over the same catalog.
+// The BST and hash map have no prefix entry point, so they scan and filter
+//============================================================================
+
+struct IndexMeasurement {
+    string catalog;
+    string index;
+    size_t courseCount;
+    double lookupNanos;       // Average per lookup
+    double iterateMillis;     // One full ordered pass
+    double prefixMicros;      // Average per prefix scan
+    size_t found;             // Lookups that hit
+    size_t scanned;           // Records returned by all prefix scans
+};
+
+typedef unordered_map<string, const enhanced::Course*> CourseHashIndex;
+
+vector<IndexMeasurement> runIndexBenchmark(const string& label, const string& filepath,
+    size_t queryCount, unsigned int seed) {
+    enhanced::BinarySearchTree bst;
+    {
+        OutputCapture capture;
+        if (!enhanced::loadDataStructure(filepath, &bst)) return {};
+    }
+    enhanced::CourseRadixTree tree(bst);
+    CourseHashIndex hashIndex;
+    vector<string> courseIds;
+    bst.ForEachRecord([&](const shared_ptr<const enhanced::Course>& record) {
+        hashIndex[record->courseId] = record.get();
+        courseIds.push_back(record->courseId);
+    });
+    if (courseIds.empty()) return {};
+
+    // Lookups mix present and absent IDs; prefixes are department codes and
+    // department codes with leading digits taken from real IDs
+    mt19937 rng(seed + 2);
+    vector<string> queries;
+    vector<string> prefixes;
+    for (size_t i = 0; i < queryCount; ++i) {
+        const string& courseId = courseIds[rng() % courseIds.size()];
+        queries.push_back(i % 10 == 9 ? "ZZZ" + to_string(100 + i) : courseId);
+        if (i % 20 == 0) prefixes.push_back(courseId.substr(0, 2 + rng() % 3));
+    }
+
+    vector<IndexMeasurement> measurements;
+    auto measure = [&](const string& index,
+        const function<const enhanced::Course* (const string&)>& lookup,
+        const function<size_t()>& iterate,
+        const function<size_t(const string&)>& prefixScan) {
+        IndexMeasurement m = { label, index, courseIds.size(), 0.0, 0.0, 0.0, 0, 0 };
+        string benchmark = label + " " + index;
+
+        hardwareCounters.Start();
+        auto start = steady_clock::now();
+        for (const auto& courseId : queries) {
+            if (lookup(courseId)) m.found++;
+        }
+        m.lookupNanos = duration<double, nano>(steady_clock::now() - start).count() / queries.size();
+        hardwareCounters.Stop(benchmark, "lookup", queries.size());
+
+        hardwareCounters.Start();
+        start = steady_clock::now();
+        size_t visited = iterate();
+        m.iterateMillis = duration<double, milli>(steady_clock::now() - start).count();
+        hardwareCounters.Stop(benchmark, "iterate", courseIds.size());
+        if (visited != courseIds.size()) m.found = 0;
+
+        hardwareCounters.Start();
+        start = steady_clock::now();
+        for (const auto& prefix : prefixes) {
+            m.scanned += prefixScan(prefix);
+        }
+        m.prefixMicros = duration<double, micro>(steady_clock::now() - start).count() / prefixes.size();
+        hardwareCounters.Stop(benchmark, "prefix", prefixes.size());
+        measurements.push_back(m);
+    };
+
+    auto startsWith = [](const string& courseId, const string& prefix) {
+        return courseId.compare(0, prefix.size(), prefix) == 0;
+    };
+
+    measure("bst",
+        [&](const string& courseId) { return bst.FindInTree(courseId); },
+        [&]() {
+            size_t visited = 0;
+            bst.ForEachRecord([&visited](const shared_ptr<const enhanced::Course>&) { visited++; });
+            return visited;
+        },
+        [&](const string& prefix) {
+            size_t matches = 0;
+            bst.ForEachRecord([&](const shared_ptr<const enhanced::Course>& record) {
+                if (startsWith(record->courseId, prefix)) matches++;
+            });
+            return matches;
+        });
+
+    // Ordered results from the hash map need a sort after collecting them
+    measure("hash map",
+        [&](const string& courseId) {
+            auto it = hashIndex.find(courseId);
+            return it != hashIndex.end() ? it->second : nullptr;
+        },
+        [&]() {
+            vector<const enhanced::Course*> ordered;
+            ordered.reserve(hashIndex.size());
+            for (const auto& pair : hashIndex) ordered.push_back(pair.second);
+            sort(ordered.begin(), ordered.end(), [](const enhanced::Course* a, const enhanced::Course* b) {
+                return a->courseId < b->courseId;
+            });
+            return ordered.size();
+        },
+        [&](const string& prefix) {
+            vector<const enhanced::Course*> matches;
+            for (const auto& pair : hashIndex) {
+                if (startsWith(pair.first, prefix)) matches.push_back(pair.second);
+            }
+            sort(matches.begin(), matches.end(), [](const enhanced::Course* a, const enhanced::Course* b) {
+                return a->courseId < b->courseId;
+            });
+            return matches.size();
+        });
+
+    measure("radix tree",
+        [&](const string& courseId) { return tree.Find(courseId); },
+        [&]() {
+            size_t visited = 0;
+            tree.ForEachRecord([&visited](const shared_ptr<const enhanced::Course>&) { visited++; });
+            return visited;
+        },
+        [&](const string& prefix) {
+            size_t matches = 0;
+            tree.ForEachWithPrefix(prefix, [&matches](const shared_ptr<const enhanced::Course>&) { matches++; });
+            return matches;
+        });
+
+    return measurements;
+}
+
+// Every index must find and scan the same courses as the first
+bool indexesAgree(const vector<IndexMeasurement>& measurements) {
+    for (const auto& m : measurements) {
+        if (m.found == 0 || m.found != measurements.front().found || m.scanned != measurements.front().scanned) {
+            return false;
+        }
+    }
+    return !measurements.empty();
+}
+
+void printIndexMeasurements(const vector<IndexMeasurement>& measurements) {
+    bool agree = indexesAgree(measurements);
+    for (const auto& m : measurements) {
+        cout << "    " << setw(16) << left << m.catalog
+            << " | " << setw(10) << left << m.index
+            << " | " << setw(9) << right << m.courseCount
+            << " | " << setw(11) << right << fixed << setprecision(1) << m.lookupNanos
+            << " | " << setw(11) << right << setprecision(3) << m.iterateMillis
+            << " | " << setw(11) << right << setprecision(2) << m.prefixMicros
+            << " | " << (agree ? "MATCH" : "DIFFER") << endl;
+    }
+}
+
+//============================================================================
+// Traversal benchmark
+// Builds prerequisite closures for a sample of courses with the graph's
+// handles as built (course ID order) and after each relabeling pass, then
+// walks the same sample through the BST's own prerequisite traversal. Build
+// with -DENHANCEMENT_TWO_NO_PREFETCH to time the kernels without prefetching
+//============================================================================
+
+struct TraversalMeasurement {
+    string catalog;
+    string order;
+    size_t courseCount;
+    double relabelMillis;
+    double edgeDistance;      // Mean handle distance along prerequisite edges
+    double closureMillis;     // All sampled closures
+    size_t closureSize;       // Courses reached over all sampled closures
+};
+
+vector<TraversalMeasurement> runTraversalBenchmark(const string& label, const string& filepath,
+    size_t queryCount, unsigned int seed) {
+    enhanced::BinarySearchTree bst;
+    {
+        OutputCapture capture;
+        if (!enhanced::loadDataStructure(filepath, &bst)) return {};
+    }
+    enhanced::PrerequisiteGraph graph(bst);
+    if (graph.Size() == 0) return {};
+
+    mt19937 rng(seed + 3);
+    vector<string> sample;
+    for (size_t i = 0; i < queryCount; ++i) {
+        sample.push_back(graph.CourseOf(static_cast<uint32_t>(rng() % graph.Size()))->courseId);
+    }
+
+    const vector<pair<string, enhanced::GraphOrder>> orders = {
+        { "course ID", enhanced::GraphOrder::CourseId },
+        { "topo level", enhanced::GraphOrder::TopologicalLevel },
+        { "BFS", enhanced::GraphOrder::BreadthFirst },
+        { "RCM", enhanced::GraphOrder::ReverseCuthillMcKee }
+    };
+
+    vector<TraversalMeasurement> measurements;
+    for (const auto& order : orders) {
+        TraversalMeasurement m = { label, order.first, graph.Size(), 0.0, 0.0, 0.0, 0 };
+        auto start = steady_clock::now();
+        graph.Relabel(order.second);
+        m.relabelMillis = duration<double, milli>(steady_clock::now() - start).count();
+        m.edgeDistance = graph.MeanEdgeDistance();
+
+        // Handles are looked up first so only the traversals are timed
+        vector<uint32_t> handles;
+        for (const auto& courseId : sample) handles.push_back(graph.HandleOf(courseId));
+        hardwareCounters.Start();
+        start = steady_clock::now();
+        for (uint32_t handle : handles) {
+            m.closureSize += graph.PrerequisiteClosure(handle).size();
+        }
+        m.closureMillis = duration<double, milli>(steady_clock::now() - start).count();
+        hardwareCounters.Stop(label + " " + order.first, "closure", handles.size());
+        measurements.push_back(m);
+    }
+
+    // The engine runs its prerequisite orders through the graph built by the
+    // load; a tree without one resolves each prerequisite by ID instead
+    enhanced::BinarySearchTree walked;
+    bst.ForEachRecord([&walked](const shared_ptr<const enhanced::Course>& record) { walked.Insert(record); });
+    walked.BuildDependencyGraph();
+    const vector<pair<string, const enhanced::BinarySearchTree*>> engines = {
+        { "engine", &bst },
+        { "hash walk", &walked }
+    };
+    for (const auto& engine : engines) {
+        TraversalMeasurement walk = { label, engine.first, bst.Size(), 0.0, 0.0, 0.0, 0 };
+        hardwareCounters.Start();
+        auto start = steady_clock::now();
+        for (const auto& courseId : sample) {
+            walk.closureSize += engine.second->GetPrerequisiteOrder(courseId).size();
+        }
+        walk.closureMillis = duration<double, milli>(steady_clock::now() - start).count();
+        hardwareCounters.Stop(label + " " + walk.order, "closure", sample.size());
+        measurements.push_back(walk);
+    }
+    return measurements;
+}
+
+// Every order must reach the same courses
+bool traversalsAgree(const vector<TraversalMeasurement>& measurements) {
+    for (const auto& m : measurements) {
+        if (m.closureSize != measurements.front().closureSize) return false;
+    }
+    return !measurements.empty();
+}
+
+void printTraversalMeasurements(const vector<TraversalMeasurement>& measurements) {
+    bool agree = traversalsAgree(measurements);
+    const TraversalMeasurement& reference = measurements.front();
+    for (const auto& m : measurements) {
+        cout << "    " << setw(16) << left << m.catalog
+            << " | " << setw(10) << left << m.order
+            << " | " << setw(11) << right << fixed << setprecision(2) << m.relabelMillis
+            << " | " << setw(10) << right << setprecision(1) << m.edgeDistance
+            << " | " << setw(11) << right << setprecision(2) << m.closureMillis
+            << " | " << setw(7) << right
+            << (m.closureMillis > 0.0 ? reference.closureMillis / m.closureMillis : 0.0) << "x"
+            << " | " << (agree ? "MATCH" : "DIFFER") << endl;
+    }
+}
+
+//============================================================================
+// Reporting
+//============================================================================
+
+void printMeasurements(const vector<EngineMeasurement>& measurements) {
+    const EngineMeasurement& reference = measurements.front();
+    for (const auto& m : measurements) {
+        cout << "    " << setw(9) << right << m.courseCount
+            << " | " << setw(10) << left << m.engine
+            << " | " << setw(10) << right << fixed << setprecision(2) << m.loadMillis
+            << " | " << setw(7) << right << setprecision(2)
+            << (m.loadMillis > 0.0 ? reference.loadMillis / m.loadMillis : 0.0) << "x"
+            << " | " << setw(7) << right << m.allocationsPerCourse
+            << " | " << setw(10) << right << m.listingMillis
+            << " | " << setw(9) << right << m.firstQueryMicros
+            << " | " << setw(9) << right << m.queryMicros
+            << " | " << setw(7) << right
+            << (m.queryMicros > 0.0 ? reference.queryMicros / m.queryMicros : 0.0) << "x"
+            << " | " << ((m.listingMismatches != 0 || m.lookupMismatches != 0) ? "DIFFER" :
+                m.overAllocationBudget ? "OVER ALLOC BUDGET" :
+                !m.overSpeedBudget.empty() ? "OVER SPEED BUDGET (" + m.overSpeedBudget + ")" : "MATCH")
+            << endl;
+    }
+}
+
+// Prints counters per operation; counters that could not be read show "-"
+void printCounterMeasurements(const vector<CounterMeasurement>& measurements) {
+    for (const auto& m : measurements) {
+        double operations = static_cast<double>(max<size_t>(m.operations, 1));
+        cout << "    " << setw(28) << left << m.benchmark
+            << " | " << setw(8) << left << m.operation
+            << " | " << setw(8) << right << m.operations;
+        for (size_t i = 0; i < CounterEventCount; ++i) {
+            cout << " | " << setw(10) << right;
+            if (m.reading.valid[i]) cout << fixed << setprecision(1) << m.reading.values[i] / operations;
+            else cout << "-";
+        }
+        bool ipcValid = m.reading.valid[Cycles] && m.reading.valid[Instructions] && m.reading.values[Cycles] > 0.0;
+        cout << " | " << setw(5) << right;
+        if (ipcValid) cout << setprecision(2) << m.reading.values[Instructions] / m.reading.values[Cycles];
+        else cout << "-";
+        cout << endl;
+    }
+}
+
+bool writeCounterCsv(const string& path, const vector<CounterMeasurement>& measurements) {
+    ofstream csv(path);
+    if (!csv.is_open()) return false;
+    csv << "benchmark,operation,operations";
+    for (const char* name : { "cycles", "instructions", "llc_misses", "branch_misses", "dtlb_misses" }) {
+        csv << "," << name << "_per_op";
+    }
+    csv << "\n";
+    for (const auto& m : measurements) {
+        csv << m.benchmark << "," << m.operation << "," << m.operations;
+        for (size_t i = 0; i < CounterEventCount; ++i) {
+            csv << ",";
+            if (m.reading.valid[i]) csv << m.reading.values[i] / max<size_t>(m.operations, 1);
+        }
+        csv << "\n";
+    }
+    return csv.good();
+}
+
+bool writeCsv(const string& path, const vector<EngineMeasurement>& measurements) {
+    ofstream csv(path);
+    if (!csv.is_open()) return false;
+    csv << "courses,engine,load_ms,allocs_per_course,listing_ms,first_query_us,query_us,"
+        "listing_mismatches,lookup_mismatches\n";
+    for (const auto& m : measurements) {
+        csv << m.courseCount << "," << m.engine << "," << m.loadMillis << ","
+            << m.allocationsPerCourse << "," << m.listingMillis
+            << "," << m.firstQueryMicros << "," << m.queryMicros << "," << m.listingMismatches << "," << m.lookupMismatches << "\n";
+    }
+    return csv.good();
+}
+
+// Parses a comma separated list of catalog sizes
+vector<size_t> parseSizes(const string& text) {
+    vector<size_t> sizes;
+    stringstream stream(text);
+    string item;
+    while (getline(stream, item, ',')) {
+        if (!item.empty()) sizes.push_back(stoul(item));
+    }
+    return sizes;
+}
+
+//============================================================================
+// Main function
+// Usage: EnhancementTwoDifferential [--sizes 100,1000,...] [--queries N]
+//                                   [--seed N] [--csv path]
+//                                   [--counters on|off] [--counters-csv path]
+//============================================================================
+
+int main(int argc, char* argv[]) {
+    vector<size_t> sizes = { 100, 1000, 10000, 50000 };
+    size_t queryCount = 2000;
+    unsigned int seed = 2025;
+    string csvPath = "differential_results.csv";
+    string countersCsvPath = "differential_counters.csv";
+    bool useCounters = true;
+
+    for (int i = 1; i < argc; i += 2) {
+        string option = argv[i];
+        if (i + 1 == argc) {
+            cerr << "Missing value for option: " << option << endl;
+            return 2;
+        }
+        try {
+            if (option == "--sizes") sizes = parseSizes(argv[i + 1]);
+            else if (option == "--queries") queryCount = stoul(argv[i + 1]);
+            else if (option == "--seed") seed = static_cast<unsigned int>(stoul(argv[i + 1]));
+            else if (option == "--csv") csvPath = argv[i + 1];
+            else if (option == "--counters") useCounters = string(argv[i + 1]) != "off";
+            else if (option == "--counters-csv") countersCsvPath = argv[i + 1];
+            else {
+                cerr << "Unknown option: " << option << endl;
+                return 2;
+            }
+        }
+        catch (const logic_error&) {
+            cerr << "Invalid value for option " << option << ": " << argv[i + 1] << endl;
+            return 2;
+        }
+    }
+    if (sizes.empty()) {
+        cerr << "--sizes needs at least one catalog size" << endl;
+        return 2;
+    }
+
+    if (useCounters && !hardwareCounters.Open()) {
+        cout << "\n  Hardware counters unavailable (" << hardwareCounters.UnavailableReason()
+            << "); reporting wall-clock time only" << endl;
+    }
+
+    cout << "\n  Differential Engine Comparison" << endl;
+    cout << "  " << string(120, '-') << endl;
+    cout << "    " << setw(9) << right << "COURSES"
+        << " | " << setw(10) << left << "ENGINE"
+        << " | " << setw(10) << right << "LOAD (ms)"
+        << " | " << setw(8) << right << "LOAD x"
+        << " | " << setw(7) << right << "ALLOC/C"
+        << " | " << setw(10) << right << "LIST (ms)"
+        << " | " << setw(9) << right << "FIRST(us)"
+        << " | " << setw(9) << right << "QUERY(us)"
+        << " | " << setw(8) << right << "QUERY x"
+        << " | RESULT" << endl;
+    cout << "  " << string(120, '-') << endl;
+
+    vector<EngineMeasurement> allMeasurements;
+    bool allMatch = true;
+    for (size_t size : sizes) {
+        vector<EngineMeasurement> measurements = runDifferential(size, queryCount, seed);
+        printMeasurements(measurements);
+        for (const auto& m : measurements) {
+            if (m.listingMismatches != 0 || m.lookupMismatches != 0 || m.overAllocationBudget ||
+                !m.overSpeedBudget.empty()) {
+                allMatch = false;
+            }
+        }
+        allMeasurements.insert(allMeasurements.end(), measurements.begin(), measurements.end());
+    }
+
+    cout << "  " << string(120, '-') << endl;
+    if (writeCsv(csvPath, allMeasurements)) {
+        cout << "    Results written to: " << csvPath << endl;
+    }
+    cout << "    Speedups are relative to the " << allMeasurements.front().engine << " engine" << endl;
+
+    // Index comparison on the bundled catalog (when present) and each size
+    cout << "\n  Ordered Index Comparison" << endl;
+    cout << "  " << string(96, '-') << endl;
+    cout << "    " << setw(16) << left << "CATALOG"
+        << " | " << setw(10) << left << "INDEX"
+        << " | " << setw(9) << right << "COURSES"
+        << " | " << setw(11) << right << "LOOKUP (ns)"
+        << " | " << setw(11) << right << "ITERATE(ms)"
+        << " | " << setw(11) << right << "PREFIX (us)"
+        << " | RESULT" << endl;
+    cout << "  " << string(96, '-') << endl;
+    vector<pair<string, string>> indexCatalogs;
+    if (filesystem::exists("infile.txt")) indexCatalogs.push_back({ "infile.txt", "infile.txt" });
+    for (size_t size : sizes) {
+        indexCatalogs.push_back({ "generated " + to_string(size), generateCatalog(size, seed).filepath });
+    }
+    for (const auto& catalog : indexCatalogs) {
+        vector<IndexMeasurement> measurements = runIndexBenchmark(catalog.first, catalog.second, queryCount, seed);
+        printIndexMeasurements(measurements);
+        if (!indexesAgree(measurements)) allMatch = false;
+        if (catalog.first != "infile.txt") filesystem::remove(catalog.second);
+    }
+    cout << "  " << string(96, '-') << endl;
+
+    // Prerequisite closures before and after each relabeling pass
+    cout << "\n  Traversal Locality" << endl;
+    cout << "  " << string(96, '-') << endl;
+    cout << "    " << setw(16) << left << "CATALOG"
+        << " | " << setw(10) << left << "ORDER"
+        << " | " << setw(11) << right << "RELABEL(ms)"
+        << " | " << setw(10) << right << "EDGE DIST"
+        << " | " << setw(11) << right << "CLOSURE(ms)"
+        << " | " << setw(8) << right << "SPEEDUP"
+        << " | RESULT" << endl;
+    cout << "  " << string(96, '-') << endl;
+    for (size_t size : sizes) {
+        string filepath = generateCatalog(size, seed).filepath;
+        vector<TraversalMeasurement> measurements =
+            runTraversalBenchmark("generated " + to_string(size), filepath, queryCount, seed);
+        printTraversalMeasurements(measurements);
+        if (!traversalsAgree(measurements)) allMatch = false;
+        filesystem::remove(filepath);
+    }
+    cout << "  " << string(96, '-') << endl;
+
+    // Counters for every timed operation above, per repetition
+    if (hardwareCounters.Available()) {
+        cout << "\n  Hardware Counters (per operation)" << endl;
+        cout << "  " << string(126, '-') << endl;
+        cout << "    " << setw(28) << left << "BENCHMARK"
+            << " | " << setw(8) << left << "OP"
+            << " | " << setw(8) << right << "OPS";
+        for (const char* name : counterNames) cout << " | " << setw(10) << right << name;
+        cout << " | " << setw(5) << right << "IPC" << endl;
+        cout << "  " << string(126, '-') << endl;
+        printCounterMeasurements(hardwareCounters.Measurements());
+        cout << "  " << string(126, '-') << endl;
+        if (writeCounterCsv(countersCsvPath, hardwareCounters.Measurements())) {
+            cout << "    Results written to: " << countersCsvPath << endl;
+        }
+    }
+    cout << "    Overall: " << (allMatch ? "ALL ENGINES AGREE WITHIN BUDGET" : "CHECKS FAILED") << "\n" << endl;
+
+    return allMatch ? 0 : 1;
+}
@@ -0,0 +1,155 @@
+//============================================================================
+// Name        : EnhancementTwoFuzz.cpp
+// Author      : Joey Grippi
+// Version     : 1.0
+// Copyright   : Copyright © 2025
+// Description : Fuzz target for the enhanced course engine
+//               Feeds arbitrary bytes to the CSV loader and course ID
+//               validation, then runs the graph algorithms on whatever was
+//               loaded. Builds either as a libFuzzer target or as a
+//               standalone driver that mutates the bundled catalog files
+//============================================================================
+
+#define ENHANCEMENT_TWO_NO_MAIN
+#include "EnhancementTwo.cpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+
+// Mirrors the documented course ID grammar: 2-4 letters then 3+ digits,
+// at most 20 characters
+static bool referenceValidCourseId(const string& courseId) {
+    if (courseId.empty() || courseId.length() > 20) return false;
+    size_t i = 0;
+    while (i < courseId.length() &&
+        ((courseId[i] >= 'A' && courseId[i] <= 'Z') || (courseId[i] >= 'a' && courseId[i] <= 'z'))) {
+        i++;
+    }
+    if (i < 2 || i > 4) return false;
+    size_t digits = 0;
+    for (; i < courseId.length(); ++i, ++digits) {
+        if (courseId[i] < '0' || courseId[i] > '9') return false;
+    }
+    return digits >= 3;
+}
+
+// Fuzzer entry point: the input is treated both as a catalog file and,
+// line by line, as candidate course IDs
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    string text(reinterpret_cast<const char*>(data), size);
+
+    ostringstream discarded;
+    streambuf* previousOut = cout.rdbuf(discarded.rdbuf());
+    streambuf* previousErr = cerr.rdbuf(discarded.rdbuf());
+
+    // Loader: any input must either load or be rejected without crashing,
+    // and every course that was loaded must have a valid ID
+    BinarySearchTree bst;
+    istringstream input(text);
+    bool loaded = loadDataStructure(input, &bst);
+
+    istringstream lines(text);
+    string line;
+    while (getline(lines, line)) {
+        string courseId = line.substr(0, line.find(','));
+        if (loaded && bst.FindCourse(courseId) && !referenceValidCourseId(courseId)) {
+            abort();
+        }
+
+        // Graph algorithms must terminate on arbitrary (possibly cyclic) data
+        if (bst.FindCourse(courseId)) {
+            bool hasCycle = bst.HasPrerequisiteCycle(courseId);
+            try {
+                bst.GetPrerequisiteOrder(courseId);
+                if (hasCycle) abort();
+            }
+            catch (const runtime_error&) {
+                if (!hasCycle) abort();
+            }
+        }
+
+        // ID validation: Insert must agree with the reference grammar
+        BinarySearchTree single;
+        Course* course = new Course(line, "Fuzz");
+        bool accepted = true;
+        try {
+            single.Insert(course);
+        }
+        catch (const invalid_argument&) {
+            delete course;
+            accepted = false;
+        }
+        if (accepted != referenceValidCourseId(line)) {
+            abort();
+        }
+    }
+
+    cout.rdbuf(previousOut);
+    cerr.rdbuf(previousErr);
+    return 0;
+}
+
+//============================================================================
+// Standalone driver
+// Used when the target is not linked against libFuzzer: replays the files
+// given on the command line, or mutates the bundled catalogs at random
+//============================================================================
+
+#ifndef ENHANCEMENT_TWO_LIBFUZZER
+
+static string readFile(const string& filepath) {
+    ifstream file(filepath, ios::binary);
+    ostringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+// Applies a handful of random byte-level mutations to a seed input
+static string mutate(string input, mt19937& rng) {
+    static const string interesting(",\n\r #\0\xff" "ABZaz09", 14);
+    size_t mutations = 1 + rng() % 8;
+    for (size_t m = 0; m < mutations; ++m) {
+        size_t position = input.empty() ? 0 : rng() % input.size();
+        switch (rng() % 4) {
+        case 0:  // Overwrite a byte
+            if (!input.empty()) input[position] = static_cast<char>(rng() % 256);
+            break;
+        case 1:  // Insert an interesting byte
+            input.insert(input.begin() + position, interesting[rng() % interesting.size()]);
+            break;
+        case 2:  // Delete a range
+            if (!input.empty()) input.erase(position, 1 + rng() % 16);
+            break;
+        default: // Duplicate a range
+            input.insert(position, input.substr(position, 1 + rng() % 32));
+            break;
+        }
+    }
+    return input;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 2 && string(argv[1]) != "--iterations") {
+        // Replay mode: run each file once
+        for (int i = 1; i < argc; ++i) {
+            string contents = readFile(argv[i]);
+            LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(contents.data()), contents.size());
+        }
+        cout << "Replayed " << (argc - 1) << " input(s)" << endl;
+        return 0;
+    }
+
+    int iterations = (argc >= 3) ? stoi(argv[2]) : 2000;
+    vector<string> seeds = { readFile("infile.txt"), readFile("test_cases.txt"), "CS100,Title\n" };
+    mt19937 rng(2025);
+    for (int i = 0; i < iterations; ++i) {
+        string input = mutate(seeds[i % seeds.size()], rng);
+        LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(input.data()), input.size());
+    }
+    cout << "Completed " << iterations << " fuzz iterations" << endl;
+    return 0;
+}
+
+#endif // ENHANCEMENT_TWO_LIBFUZZER
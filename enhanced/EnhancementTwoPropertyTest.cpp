@@ -0,0 +1,1866 @@
+//============================================================================
+// Name        : EnhancementTwoPropertyTest.cpp
+// Author      : Joey Grippi
+// Version     : 1.0
+// Copyright   : Copyright © 2025
+// Description : Property-based tests for the enhanced course engine
+//               Generates random acyclic and cyclic prerequisite graphs and
+//               random course IDs, then checks the engine's answers against
+//               simple reference implementations
+//============================================================================
+
+#define ENHANCEMENT_TWO_NO_MAIN
+#include "EnhancementTwo.cpp"
+
+#include <random>
+#include <sstream>
+#include <functional>
+#include <set>
+
+//============================================================================
+// Generated catalogs
+// A catalog is a list of courses whose prerequisites are indices of other
+// courses; it can be rendered as CSV and loaded through the real loader
+//============================================================================
+
+struct GeneratedCourse {
+    string courseId;
+    string courseTitle;
+    vector<size_t> prereqs;
+};
+
+typedef vector<GeneratedCourse> GeneratedCatalog;
+
+// Renders a generated catalog in the CSV format read by loadDataStructure
+string renderCatalog(const GeneratedCatalog& catalog, mt19937& rng) {
+    vector<size_t> order(catalog.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    shuffle(order.begin(), order.end(), rng);
+
+    ostringstream text;
+    for (size_t index : order) {
+        const GeneratedCourse& course = catalog[index];
+        text << course.courseId << "," << course.courseTitle;
+        for (size_t prereq : course.prereqs) {
+            text << "," << catalog[prereq].courseId;
+        }
+        text << "\n";
+    }
+    return text.str();
+}
+
+// Creates courses with unique valid IDs and no prerequisites
+GeneratedCatalog generateCourses(size_t courseCount) {
+    static const vector<string> departments = { "CS", "MAT", "DAT", "IT", "PHY" };
+    GeneratedCatalog catalog(courseCount);
+    for (size_t i = 0; i < courseCount; ++i) {
+        catalog[i].courseId = departments[i % departments.size()] + to_string(100 + i);
+        catalog[i].courseTitle = "Generated Course " + to_string(i);
+    }
+    return catalog;
+}
+
+// Random DAG: every prerequisite points at a course with a smaller index
+GeneratedCatalog generateDag(size_t courseCount, mt19937& rng) {
+    GeneratedCatalog catalog = generateCourses(courseCount);
+    for (size_t i = 1; i < courseCount; ++i) {
+        size_t prereqCount = rng() % 4;
+        for (size_t p = 0; p < prereqCount; ++p) {
+            catalog[i].prereqs.push_back(rng() % i);
+        }
+    }
+    return catalog;
+}
+
+// Random graph that usually contains cycles: a DAG plus a few back edges,
+// occasionally including self-references
+GeneratedCatalog generateCyclicGraph(size_t courseCount, mt19937& rng) {
+    GeneratedCatalog catalog = generateDag(courseCount, rng);
+    size_t backEdges = 1 + rng() % 3;
+    for (size_t e = 0; e < backEdges; ++e) {
+        size_t from = rng() % courseCount;
+        size_t to = from + rng() % (courseCount - from);
+        catalog[from].prereqs.push_back(to);
+    }
+    return catalog;
+}
+
+//============================================================================
+// Reference implementations
+//============================================================================
+
+// Indices of every course reachable from start through prerequisites
+unordered_set<size_t> referenceReachable(const GeneratedCatalog& catalog, size_t start) {
+    unordered_set<size_t> reached;
+    vector<size_t> pending = catalog[start].prereqs;
+    while (!pending.empty()) {
+        size_t current = pending.back();
+        pending.pop_back();
+        if (reached.insert(current).second) {
+            pending.insert(pending.end(), catalog[current].prereqs.begin(), catalog[current].prereqs.end());
+        }
+    }
+    return reached;
+}
+
+// Tarjan's strongly connected components; marks courses that lie on a cycle
+vector<bool> referenceOnCycle(const GeneratedCatalog& catalog) {
+    size_t count = catalog.size();
+    vector<int> index(count, -1);
+    vector<int> lowLink(count, 0);
+    vector<bool> onStack(count, false);
+    vector<size_t> sccStack;
+    vector<bool> onCycle(count, false);
+    int nextIndex = 0;
+
+    function<void(size_t)> strongConnect = [&](size_t v) {
+        index[v] = lowLink[v] = nextIndex++;
+        sccStack.push_back(v);
+        onStack[v] = true;
+
+        for (size_t w : catalog[v].prereqs) {
+            if (w == v) onCycle[v] = true;  // Self-reference
+            if (index[w] < 0) {
+                strongConnect(w);
+                lowLink[v] = min(lowLink[v], lowLink[w]);
+            }
+            else if (onStack[w]) {
+                lowLink[v] = min(lowLink[v], index[w]);
+            }
+        }
+
+        if (lowLink[v] == index[v]) {
+            vector<size_t> component;
+            size_t w;
+            do {
+                w = sccStack.back();
+                sccStack.pop_back();
+                onStack[w] = false;
+                component.push_back(w);
+            } while (w != v);
+            if (component.size() > 1) {
+                for (size_t member : component) onCycle[member] = true;
+            }
+        }
+    };
+
+    for (size_t v = 0; v < count; ++v) {
+        if (index[v] < 0) strongConnect(v);
+    }
+    return onCycle;
+}
+
+// Reference grammar for course IDs: 2-4 letters then 3+ digits, at most 20 characters
+bool referenceValidCourseId(const string& courseId) {
+    if (courseId.empty() || courseId.length() > 20) return false;
+    size_t i = 0;
+    while (i < courseId.length() &&
+        ((courseId[i] >= 'A' && courseId[i] <= 'Z') || (courseId[i] >= 'a' && courseId[i] <= 'z'))) {
+        i++;
+    }
+    if (i < 2 || i > 4) return false;
+    size_t digits = 0;
+    for (; i < courseId.length(); ++i, ++digits) {
+        if (courseId[i] < '0' || courseId[i] > '9') return false;
+    }
+    return digits >= 3;
+}
+
+//============================================================================
+// Property checks
+// Each check returns an empty string on success or a failure description
+//============================================================================
+
+// Loads generated catalog text through the real loader with output silenced
+bool loadCatalog(const string& text, BinarySearchTree* bst) {
+    ostringstream discarded;
+    streambuf* previousOut = cout.rdbuf(discarded.rdbuf());
+    streambuf* previousErr = cerr.rdbuf(discarded.rdbuf());
+    istringstream input(text);
+    bool loaded = loadDataStructure(input, bst);
+    cout.rdbuf(previousOut);
+    cerr.rdbuf(previousErr);
+    return loaded;
+}
+
+// Every generated course is found with its title and prerequisites intact
+string checkLoaderRoundTrip(const GeneratedCatalog& catalog, BinarySearchTree& bst) {
+    for (const auto& expected : catalog) {
+        const Course* course = bst.FindCourse(expected.courseId);
+        if (!course) return "course " + expected.courseId + " was not loaded";
+        if (course->courseTitle != expected.courseTitle) return "title mismatch for " + expected.courseId;
+        if (course->prereqs.size() != expected.prereqs.size()) return "prerequisite count mismatch for " + expected.courseId;
+        for (size_t p = 0; p < expected.prereqs.size(); ++p) {
+            if (course->prereqs[p] != catalog[expected.prereqs[p]].courseId) {
+                return "prerequisite mismatch for " + expected.courseId;
+            }
+        }
+    }
+    return "";
+}
+
+// Topological order contains exactly the transitive prerequisites, each once,
+// and every course appears after all of its own prerequisites
+string checkTopologicalOrders(const GeneratedCatalog& catalog, BinarySearchTree& bst) {
+    for (size_t c = 0; c < catalog.size(); ++c) {
+        vector<const Course*> order = bst.GetPrerequisiteOrder(catalog[c].courseId);
+        unordered_set<size_t> expected = referenceReachable(catalog, c);
+        if (order.size() != expected.size()) {
+            return "order for " + catalog[c].courseId + " has " + to_string(order.size()) +
+                " courses, expected " + to_string(expected.size());
+        }
+
+        unordered_map<string, size_t> position;
+        for (size_t i = 0; i < order.size(); ++i) {
+            if (!position.emplace(order[i]->courseId, i).second) {
+                return "order for " + catalog[c].courseId + " repeats " + order[i]->courseId;
+            }
+        }
+        for (size_t reached : expected) {
+            if (!position.count(catalog[reached].courseId)) {
+                return "order for " + catalog[c].courseId + " is missing " + catalog[reached].courseId;
+            }
+        }
+        for (size_t i = 0; i < order.size(); ++i) {
+            for (const auto& prereqId : order[i]->prereqs) {
+                auto it = position.find(prereqId);
+                if (it == position.end() || it->second >= i) {
+                    return "order for " + catalog[c].courseId + " places " + order[i]->courseId +
+                        " before its prerequisite " + prereqId;
+                }
+            }
+        }
+    }
+    return "";
+}
+
+// Cycle detection agrees with SCC analysis: a course has a cycle exactly when
+// some course reachable from it (or it itself) lies on a cycle
+string checkCycleDetection(const GeneratedCatalog& catalog, BinarySearchTree& bst) {
+    vector<bool> onCycle = referenceOnCycle(catalog);
+    for (size_t c = 0; c < catalog.size(); ++c) {
+        bool expected = onCycle[c];
+        for (size_t reached : referenceReachable(catalog, c)) {
+            expected = expected || onCycle[reached];
+        }
+
+        bool actual = bst.HasPrerequisiteCycle(catalog[c].courseId);
+        if (actual != expected) {
+            return "cycle detection for " + catalog[c].courseId + " returned " +
+                (actual ? "true" : "false") + ", reference says " + (expected ? "true" : "false");
+        }
+
+        bool threw = false;
+        try {
+            bst.GetPrerequisiteOrder(catalog[c].courseId);
+        }
+        catch (const runtime_error&) {
+            threw = true;
+        }
+        if (threw != expected) {
+            return "prerequisite order for " + catalog[c].courseId +
+                (threw ? " rejected an acyclic course" : " accepted a cyclic course");
+        }
+    }
+    return "";
+}
+
+// Memory accounting counts every loaded course and prerequisite, and query
+// scratch memory is fully released once each query returns
+string checkMemoryAccounting(const GeneratedCatalog& catalog, BinarySearchTree& bst) {
+    size_t prereqCount = 0;
+    for (const auto& course : catalog) {
+        prereqCount += course.prereqs.size();
+    }
+
+    vector<MemoryUsage> usage = bst.GetMemoryUsage();
+    if (usage[0].objects != catalog.size()) return "BST node count " + to_string(usage[0].objects);
+    if (usage[1].objects != catalog.size()) return "course record count " + to_string(usage[1].objects);
+    if (usage[2].objects != catalog.size()) return "index entry count " + to_string(usage[2].objects);
+    if (usage[4].objects != prereqCount) return "prerequisite count " + to_string(usage[4].objects);
+
+    for (const auto& course : catalog) {
+        bst.HasPrerequisiteCycle(course.courseId);
+        try {
+            bst.GetPrerequisiteOrder(course.courseId);
+        }
+        catch (const runtime_error&) {
+        }
+    }
+
+    vector<QueryMemoryUsage> queries = bst.GetQueryMemoryUsage();
+    for (const auto& query : queries) {
+        if (query.liveBytes != 0) return query.queryType + " scratch memory was not released";
+    }
+    if (queries[1].calls != catalog.size() || queries[2].calls != catalog.size()) {
+        return "query calls were not counted";
+    }
+    return "";
+}
+
+// The missing-ID filter never hides a loaded course, and every absent ID it
+// lets through is counted as a false positive
+string checkMissingIdFilter(const GeneratedCatalog& catalog, BinarySearchTree& bst) {
+    FilterStats before = bst.GetFilterStats();
+    if (before.keys != catalog.size()) return "filter holds " + to_string(before.keys) + " IDs";
+
+    for (const auto& course : catalog) {
+        if (!bst.FindCourse(course.courseId)) return "filter rejected loaded course " + course.courseId;
+    }
+    size_t absentCount = 500;
+    for (size_t n = 0; n < absentCount; ++n) {
+        string absent = "FAKE" + to_string(100 + n);
+        if (bst.FindCourse(absent)) return "absent course " + absent + " was found";
+    }
+
+    FilterStats after = bst.GetFilterStats();
+    if (after.lookups - before.lookups != catalog.size() + absentCount) return "filter lookups were not counted";
+    size_t absentOutcomes = (after.rejected - before.rejected) + (after.falsePositives - before.falsePositives);
+    if (absentOutcomes != absentCount) return "absent lookups were not all counted";
+    if (after.expectedFalsePositiveRate > 0.05) return "expected false-positive rate is too high";
+
+    // Lookups from concurrent readers are all counted, and prerequisite walks
+    // do not consult the filter
+    vector<thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&catalog, &bst]() {
+            for (const auto& course : catalog) bst.FindCourse(course.courseId);
+        });
+    }
+    for (auto& reader : readers) reader.join();
+    for (const auto& course : catalog) {
+        try {
+            bst.GetPrerequisiteOrder(course.courseId);
+        }
+        catch (const runtime_error&) {
+        }
+    }
+    FilterStats concurrent = bst.GetFilterStats();
+    if (concurrent.lookups - after.lookups != 5 * catalog.size()) return "concurrent filter lookups were not counted";
+    return "";
+}
+
+// Relabeling the prerequisite graph must not change what any traversal
+// returns: closures match the reference, and prerequisite orders (or cycle
+// errors) and dependents match the hash walks of a tree without a graph in
+// every handle order
+string checkGraphRelabeling(const GeneratedCatalog& catalog, BinarySearchTree& bst) {
+    if (!bst.HasPrerequisiteGraph()) return "the load did not build a prerequisite graph";
+    PrerequisiteGraph graph(bst);
+    if (graph.Size() != catalog.size()) return "graph holds " + to_string(graph.Size()) + " courses";
+
+    BinarySearchTree walked;
+    bst.ForEachRecord([&walked](const shared_ptr<const Course>& record) { walked.Insert(record); });
+    walked.BuildDependencyGraph();
+
+    const GraphOrder orders[] = { GraphOrder::TopologicalLevel, GraphOrder::BreadthFirst,
+        GraphOrder::ReverseCuthillMcKee, GraphOrder::CourseId };
+    vector<uint32_t> builtHandles;
+    for (const auto& course : catalog) builtHandles.push_back(graph.HandleOf(course.courseId));
+
+    for (GraphOrder order : orders) {
+        graph.Relabel(order);
+        for (size_t c = 0; c < catalog.size(); ++c) {
+            const string& courseId = catalog[c].courseId;
+            uint32_t handle = graph.HandleOf(courseId);
+            if (graph.CourseOf(handle) != bst.FindCourse(courseId)) return "handle of " + courseId + " maps to another course";
+            if (graph.OriginalHandle(handle) != builtHandles[c]) return "original handle of " + courseId + " was lost";
+
+            unordered_set<size_t> expected = referenceReachable(catalog, c);
+            expected.erase(c);
+            vector<uint32_t> closure = graph.PrerequisiteClosure(handle);
+            if (closure.size() != expected.size()) return "closure size differs for " + courseId;
+            for (uint32_t reached : closure) {
+                const Course* course = graph.CourseOf(reached);
+                bool found = false;
+                for (size_t index : expected) found = found || catalog[index].courseId == course->courseId;
+                if (!found) return "closure of " + courseId + " holds unexpected " + course->courseId;
+            }
+
+            string treeResult;
+            string graphResult;
+            string engineResult;
+            try {
+                for (const Course* course : walked.GetPrerequisiteOrder(courseId)) treeResult += course->courseId + " ";
+            }
+            catch (const runtime_error&) {
+                treeResult = "cycle";
+            }
+            try {
+                for (const Course* course : graph.GetPrerequisiteOrder(courseId)) graphResult += course->courseId + " ";
+            }
+            catch (const runtime_error&) {
+                graphResult = "cycle";
+            }
+            try {
+                for (const Course* course : bst.GetPrerequisiteOrder(courseId)) engineResult += course->courseId + " ";
+            }
+            catch (const runtime_error&) {
+                engineResult = "cycle";
+            }
+            if (treeResult != graphResult) return "prerequisite order of " + courseId + " differs from the BST";
+            if (treeResult != engineResult) return "engine's prerequisite order of " + courseId + " differs from the BST";
+        }
+    }
+
+    for (const auto& course : catalog) {
+        if (walked.HasPrerequisiteCycle(course.courseId) != bst.HasPrerequisiteCycle(course.courseId)) {
+            return "cycle check of " + course.courseId + " differs from the BST";
+        }
+        multiset<string> expected;
+        multiset<string> actual;
+        for (const Course* dependent : walked.GetDependents(course.courseId)) expected.insert(dependent->courseId);
+        for (const Course* dependent : bst.GetDependents(course.courseId)) actual.insert(dependent->courseId);
+        if (actual != expected) return "dependents of " + course.courseId + " differ from the BST";
+    }
+    return "";
+}
+
+// Catalogs hosted together share identical records, never share differing
+// ones, and a reload leaves snapshots already handed out unchanged
+string checkCatalogSharing(const GeneratedCatalog& catalog, BinarySearchTree& bst) {
+    mt19937 rng(static_cast<unsigned int>(catalog.size()));
+    GeneratedCatalog renamed = catalog;
+    renamed[0].courseTitle += " (Revised)";
+    string original = renderCatalog(catalog, rng);
+    string revised = renderCatalog(renamed, rng);
+
+    CatalogHost host;
+    istringstream firstInput(original), secondInput(revised);
+    if (!host.LoadCatalog("first", firstInput) || !host.LoadCatalog("second", secondInput)) {
+        return "hosted catalog failed to load";
+    }
+
+    auto first = host.GetCatalog("first");
+    auto second = host.GetCatalog("second");
+    for (size_t c = 0; c < catalog.size(); ++c) {
+        const string& courseId = catalog[c].courseId;
+        bool sharedRecord = first->FindCourse(courseId) == second->FindCourse(courseId);
+        if (sharedRecord != (c != 0)) {
+            return courseId + (sharedRecord ? " shared a differing record" : " was not shared");
+        }
+        if (first->GetPrerequisiteOrder(courseId).size() != bst.GetPrerequisiteOrder(courseId).size()) {
+            return "hosted catalog answered differently for " + courseId;
+        }
+    }
+    if (host.SharedRecordCount() != catalog.size() + 1 || host.RecordReferenceCount() != 2 * catalog.size()) {
+        return "record pool holds " + to_string(host.SharedRecordCount()) + " records";
+    }
+
+    // Reload the second tenant with the original data while holding its old snapshot
+    istringstream reloadInput(original);
+    host.LoadCatalog("second", reloadInput);
+    if (second->FindCourse(catalog[0].courseId)->courseTitle != renamed[0].courseTitle) {
+        return "reload changed a snapshot already in use";
+    }
+    if (host.GetCatalog("second")->FindCourse(catalog[0].courseId) != first->FindCourse(catalog[0].courseId)) {
+        return "reloaded catalog does not share the original record";
+    }
+    // The revised record stays in the second tenant's version history
+    second.reset();
+    if (host.SharedRecordCount() != catalog.size() + 1) {
+        return "version history did not keep the revised record";
+    }
+
+    first.reset();
+    host.UnloadCatalog("first");
+    if (!host.GetCatalog("second") || host.GetCatalog("second")->Size() != catalog.size()) {
+        return "unloading one catalog disturbed another";
+    }
+    host.UnloadCatalog("second");
+    if (host.SharedRecordCount() != 0) {
+        return "released records were not freed";
+    }
+    return "";
+}
+
+// Every version of a history answers exactly as a catalog loaded with that
+// version's courses, and versions share the nodes they did not change
+string checkVersionHistory(const GeneratedCatalog& catalog, BinarySearchTree& bst) {
+    mt19937 rng(static_cast<unsigned int>(catalog.size()) * 104729u);
+    CatalogHistory history;
+    history.CommitCatalog("initial", bst);
+
+    // Reference state of every version: course ID to its record
+    vector<map<string, shared_ptr<const Course>>> expected(1);
+    bst.ForEachRecord([&](const shared_ptr<const Course>& record) { expected[0][record->courseId] = record; });
+
+    for (int v = 1; v < 12; ++v) {
+        map<string, shared_ptr<const Course>> state = expected.back();
+        vector<shared_ptr<const Course>> upserts;
+        vector<string> removals;
+        size_t changes = 1 + rng() % 3;
+        for (size_t n = 0; n < changes; ++n) {
+            size_t index = rng() % catalog.size();
+            if (rng() % 3 == 0) {
+                removals.push_back(catalog[index].courseId);
+                state.erase(catalog[index].courseId);
+            }
+            else {
+                auto record = make_shared<Course>(catalog[index].courseId, "Revision " + to_string(v));
+                for (size_t prereq : catalog[index].prereqs) record->prereqs.push_back(catalog[prereq].courseId);
+                upserts.push_back(record);
+                state[record->courseId] = record;
+            }
+        }
+        // Removals are applied after upserts, so a course changed both ways is gone
+        for (const auto& courseId : removals) state.erase(courseId);
+        history.CommitChanges("", upserts, removals);
+        expected.push_back(state);
+    }
+
+    for (size_t v = 0; v < expected.size(); ++v) {
+        vector<const Course*> courses = history.GetCourses(v);
+        if (courses.size() != expected[v].size() || history.CourseCount(v) != expected[v].size()) {
+            return "version " + to_string(v) + " has " + to_string(courses.size()) + " courses";
+        }
+        size_t i = 0;
+        for (const auto& pair : expected[v]) {
+            if (courses[i++] != pair.second.get() || history.FindCourse(pair.first, v) != pair.second.get()) {
+                return "version " + to_string(v) + " has the wrong record for " + pair.first;
+            }
+        }
+
+        // Prerequisite plans match a catalog materialized from the version
+        auto materialized = history.Materialize(v);
+        for (const auto& pair : expected[v]) {
+            if (history.GetPrerequisiteOrder(pair.first, v).size() !=
+                materialized->GetPrerequisiteOrder(pair.first).size()) {
+                return "version " + to_string(v) + " plans " + pair.first + " differently";
+            }
+        }
+    }
+
+    HistoryUsage usage = history.GetUsage();
+    if (usage.storedNodes > usage.fullCopyNodes || (catalog.size() >= 32 && usage.storedNodes * 2 > usage.fullCopyNodes)) {
+        return "history stores " + to_string(usage.storedNodes) + " nodes for " +
+            to_string(usage.fullCopyNodes) + " course entries";
+    }
+
+    // Catalogs committed concurrently each become a whole version: every
+    // version holds exactly the records of one of them
+    CatalogHistory raced;
+    BinarySearchTree half;
+    map<string, shared_ptr<const Course>> halfRecords;
+    for (size_t i = 0; i < catalog.size(); i += 2) {
+        auto record = make_shared<const Course>(catalog[i].courseId, "Half");
+        halfRecords[record->courseId] = record;
+        half.Insert(record);
+    }
+    vector<thread> committers;
+    for (int t = 0; t < 2; ++t) {
+        committers.emplace_back([&raced, &bst, &half, t]() {
+            for (int n = 0; n < 20; ++n) {
+                raced.CommitCatalog("", (n + t) % 2 ? half : bst);
+            }
+        });
+    }
+    for (auto& committer : committers) committer.join();
+    for (size_t v = 0; v < raced.VersionCount(); ++v) {
+        vector<const Course*> courses = raced.GetCourses(v);
+        bool matchesFull = courses.size() == expected[0].size();
+        bool matchesHalf = courses.size() == halfRecords.size();
+        size_t i = 0;
+        for (const auto& pair : expected[0]) {
+            matchesFull = matchesFull && courses[i++] == pair.second.get();
+        }
+        i = 0;
+        for (const auto& pair : halfRecords) {
+            matchesHalf = matchesHalf && courses[i++] == pair.second.get();
+        }
+        if (!matchesFull && !matchesHalf) {
+            return "concurrent commits mixed two catalogs in version " + to_string(v);
+        }
+    }
+    return "";
+}
+
+// Loads catalog text into a hosted tenant with output silenced
+bool loadHostedCatalog(CatalogHost& host, const string& tenant, const string& text) {
+    ostringstream discarded;
+    streambuf* previousOut = cout.rdbuf(discarded.rdbuf());
+    streambuf* previousErr = cerr.rdbuf(discarded.rdbuf());
+    istringstream input(text);
+    bool loaded = host.LoadCatalog(tenant, input);
+    cout.rdbuf(previousOut);
+    cerr.rdbuf(previousErr);
+    return loaded;
+}
+
+// A federated plan over a partial home catalog and a renamed copy of the
+// whole catalog contains exactly the courses reachable without passing
+// through a completed course, each once and after its prerequisites
+string checkFederatedResolution(const GeneratedCatalog& catalog, BinarySearchTree&) {
+    mt19937 rng(static_cast<unsigned int>(catalog.size()) * 7919u);
+
+    // The home catalog keeps a random subset; the partner catalog has every
+    // course under a different ID, each declared equivalent to its original
+    GeneratedCatalog partner = catalog;
+    unordered_map<string, size_t> indexOf;
+    vector<bool> inHome(catalog.size());
+    GeneratedCatalog home;
+    for (size_t i = 0; i < catalog.size(); ++i) {
+        partner[i].courseId = "TRN" + to_string(100 + i);
+        indexOf["home\n" + catalog[i].courseId] = i;
+        indexOf["partner\n" + partner[i].courseId] = i;
+        inHome[i] = (i == catalog.size() - 1) || rng() % 2 == 0;
+    }
+
+    // Home courses keep their prerequisite IDs even when those courses are
+    // not in the home catalog
+    ostringstream homeText;
+    for (size_t i = 0; i < catalog.size(); ++i) {
+        if (!inHome[i]) continue;
+        homeText << catalog[i].courseId << "," << catalog[i].courseTitle;
+        for (size_t prereq : catalog[i].prereqs) homeText << "," << catalog[prereq].courseId;
+        homeText << "\n";
+    }
+
+    CatalogHost host;
+    if (!loadHostedCatalog(host, "home", homeText.str()) ||
+        !loadHostedCatalog(host, "partner", renderCatalog(partner, rng))) {
+        return "hosted catalog failed to load";
+    }
+    for (size_t i = 0; i < catalog.size(); ++i) {
+        host.AddEquivalence({ "home", catalog[i].courseId }, { "partner", partner[i].courseId });
+    }
+
+    size_t target = catalog.size() - 1;
+    vector<CatalogCourse> completed;
+    vector<bool> isCompleted(catalog.size(), false);
+    for (size_t i = 0; i < catalog.size(); ++i) {
+        if (rng() % 4 == 0) {
+            completed.push_back({ "partner", partner[i].courseId });
+            isCompleted[i] = true;
+        }
+    }
+
+    // Reference: search that stops at completed courses
+    unordered_set<size_t> expected;
+    vector<size_t> pending = catalog[target].prereqs;
+    while (!pending.empty()) {
+        size_t current = pending.back();
+        pending.pop_back();
+        if (isCompleted[current] || !expected.insert(current).second) continue;
+        pending.insert(pending.end(), catalog[current].prereqs.begin(), catalog[current].prereqs.end());
+    }
+
+    vector<CatalogCourse> plan = host.GetFederatedPrerequisiteOrder({ "home", catalog[target].courseId }, completed);
+    if (plan.size() != expected.size()) {
+        return "plan has " + to_string(plan.size()) + " courses, expected " + to_string(expected.size());
+    }
+    unordered_map<size_t, size_t> position;
+    for (size_t p = 0; p < plan.size(); ++p) {
+        auto it = indexOf.find(TransferEquivalence::MakeKey(plan[p]));
+        if (it == indexOf.end() || !expected.count(it->second) || !position.emplace(it->second, p).second) {
+            return "plan contains unexpected course " + plan[p].tenant + " " + plan[p].courseId;
+        }
+    }
+    for (const auto& planned : position) {
+        for (size_t prereq : catalog[planned.first].prereqs) {
+            if (expected.count(prereq) && position[prereq] >= planned.second) {
+                return "plan places " + catalog[planned.first].courseId + " before a prerequisite";
+            }
+        }
+    }
+
+    for (size_t i = 0; i < catalog.size(); ++i) {
+        if (host.IsPrerequisiteSatisfied({ "home", catalog[i].courseId }, completed) != isCompleted[i]) {
+            return "satisfaction of " + catalog[i].courseId + " does not follow its equivalence";
+        }
+    }
+    return "";
+}
+
+// Checks that a catalog holds exactly the expected courses
+string compareCatalog(const BinarySearchTree& bst, const map<string, Course>& expected) {
+    if (bst.Size() != expected.size()) {
+        return "catalog has " + to_string(bst.Size()) + " courses, expected " + to_string(expected.size());
+    }
+    for (const auto& pair : expected) {
+        const Course* course = bst.FindCourse(pair.first);
+        if (!course || !(*course == pair.second)) return "course " + pair.first + " differs";
+    }
+    return "";
+}
+
+// Edits survive a restart: the journal recovers the same catalog after
+// compactions and after a torn final record, concurrent edits share group
+// commits, and a batch that cannot apply leaves no trace
+string checkJournalRecovery(const GeneratedCatalog& catalog, BinarySearchTree&) {
+    mt19937 rng(static_cast<unsigned int>(catalog.size()) * 15485863u);
+    filesystem::path directory = filesystem::temp_directory_path() / ("journal_property_" + to_string(rng()));
+    filesystem::remove_all(directory);
+    filesystem::create_directories(directory);
+    string logPath = (directory / "catalog.wal").string();
+    string snapshotPath = (directory / "catalog.snapshot").string();
+
+    ostringstream discarded;
+    streambuf* previousErr = cerr.rdbuf(discarded.rdbuf());
+    string failure;
+    map<string, Course> expected;
+    {
+        CatalogJournal journal(logPath, snapshotPath, 7);
+        if (!journal.Open()) failure = "journal failed to open";
+        for (int n = 0; failure.empty() && n < 40; ++n) {
+            const GeneratedCourse& generated = catalog[rng() % catalog.size()];
+            auto existing = expected.find(generated.courseId);
+            switch (existing == expected.end() ? 0 : rng() % 4) {
+            case 0: {
+                Course course(generated.courseId, generated.courseTitle + " v" + to_string(n));
+                for (size_t prereq : generated.prereqs) course.prereqs.push_back(catalog[prereq].courseId);
+                journal.Apply(CourseMutation::Upsert(course));
+                expected[course.courseId] = course;
+                break;
+            }
+            case 1:
+                journal.Apply(CourseMutation::Remove(generated.courseId));
+                expected.erase(existing);
+                break;
+            case 2: {
+                string prereqId = catalog[rng() % catalog.size()].courseId;
+                journal.Apply(CourseMutation::AddPrerequisite(generated.courseId, prereqId));
+                CourseIdList& prereqs = existing->second.prereqs;
+                if (find(prereqs.begin(), prereqs.end(), prereqId) == prereqs.end()) prereqs.push_back(prereqId);
+                break;
+            }
+            default: {
+                CourseIdList& prereqs = existing->second.prereqs;
+                if (prereqs.empty()) break;
+                string prereqId = prereqs[rng() % prereqs.size()];
+                journal.Apply(CourseMutation::RemovePrerequisite(generated.courseId, prereqId));
+                prereqs.erase(remove(prereqs.begin(), prereqs.end(), prereqId), prereqs.end());
+                break;
+            }
+            }
+        }
+    }
+
+    // Simulate a crash part way through writing one more record
+    {
+        ofstream log(logPath, ios::binary | ios::app);
+        log.write("\x20\x00\x00\x00\x01\x02", 6);
+    }
+
+    if (failure.empty()) {
+        CatalogJournal recovered(logPath, snapshotPath, 7);
+        BinarySearchTree rebuilt;
+        if (!recovered.Open() || !recovered.BuildCatalog(&rebuilt)) {
+            failure = "journal failed to recover";
+        }
+        else {
+            failure = compareCatalog(rebuilt, expected);
+            if (failure.empty()) {
+                // The torn tail was cut off, so new edits replay too
+                recovered.Apply(CourseMutation::Upsert(Course("ZZZ999", "Appended")));
+                expected["ZZZ999"] = Course("ZZZ999", "Appended");
+            }
+        }
+    }
+    if (failure.empty()) {
+        CatalogJournal reopened(logPath, snapshotPath, 7);
+        BinarySearchTree rebuilt;
+        reopened.Open();
+        reopened.BuildCatalog(&rebuilt);
+        failure = compareCatalog(rebuilt, expected);
+    }
+
+    // Concurrent edits from several threads are all durable
+    if (failure.empty()) {
+        string concurrentLog = (directory / "concurrent.wal").string();
+        string concurrentSnapshot = (directory / "concurrent.snapshot").string();
+        const size_t threadCount = 4;
+        const size_t editsPerThread = 10;
+        size_t groupCommits = 0;
+        {
+            CatalogJournal journal(concurrentLog, concurrentSnapshot);
+            journal.Open();
+            vector<thread> writers;
+            for (size_t t = 0; t < threadCount; ++t) {
+                writers.emplace_back([&journal, t, editsPerThread]() {
+                    for (size_t i = 0; i < editsPerThread; ++i) {
+                        journal.Apply(CourseMutation::Upsert(Course("GRP" + to_string(1000 + t * 100 + i), "Concurrent")));
+                    }
+                });
+            }
+            for (auto& writer : writers) writer.join();
+            groupCommits = journal.GroupCommits();
+        }
+        CatalogJournal reopened(concurrentLog, concurrentSnapshot);
+        reopened.Open();
+        if (reopened.Size() != threadCount * editsPerThread || groupCommits > threadCount * editsPerThread) {
+            failure = "concurrent edits were lost";
+        }
+    }
+
+    // Concurrent edits survive compactions that run between group commits
+    if (failure.empty()) {
+        string compactedLog = (directory / "compacted.wal").string();
+        string compactedSnapshot = (directory / "compacted.snapshot").string();
+        const size_t threadCount = 4;
+        const size_t editsPerThread = 25;
+        {
+            CatalogJournal journal(compactedLog, compactedSnapshot, 3);
+            journal.Open();
+            vector<thread> writers;
+            for (size_t t = 0; t < threadCount; ++t) {
+                writers.emplace_back([&journal, t, editsPerThread]() {
+                    for (size_t i = 0; i < editsPerThread; ++i) {
+                        journal.Apply(CourseMutation::Upsert(Course("CMP" + to_string(1000 + t * 100 + i), "Compacted")));
+                    }
+                });
+            }
+            for (auto& writer : writers) writer.join();
+        }
+        CatalogJournal reopened(compactedLog, compactedSnapshot, 3);
+        reopened.Open();
+        for (size_t t = 0; failure.empty() && t < threadCount; ++t) {
+            for (size_t i = 0; i < editsPerThread; ++i) {
+                if (!reopened.Find("CMP" + to_string(1000 + t * 100 + i))) {
+                    failure = "an edit was lost across a compaction";
+                    break;
+                }
+            }
+        }
+    }
+
+    // Edits in a batch see the ones before them; a rejected batch is not logged
+    if (failure.empty()) {
+        string batchLog = (directory / "batch.wal").string();
+        string batchSnapshot = (directory / "batch.snapshot").string();
+        {
+            CatalogJournal journal(batchLog, batchSnapshot);
+            journal.Open();
+            journal.Apply(vector<CourseMutation>{ CourseMutation::Upsert(Course("BAT100", "Batch")),
+                CourseMutation::AddPrerequisite("BAT100", "BAT200") });
+            try {
+                journal.Apply(vector<CourseMutation>{ CourseMutation::Remove("BAT100"),
+                    CourseMutation::AddPrerequisite("BAT100", "BAT300") });
+                failure = "an edit to a removed course was accepted";
+            }
+            catch (const invalid_argument&) {
+            }
+            shared_ptr<const Course> course = journal.Find("BAT100");
+            if (failure.empty() && (!course || course->prereqs.size() != 1)) {
+                failure = "a rejected batch changed the catalog";
+            }
+        }
+        CatalogJournal reopened(batchLog, batchSnapshot);
+        reopened.Open();
+        shared_ptr<const Course> course = reopened.Find("BAT100");
+        if (failure.empty() && (!course || course->prereqs.size() != 1 || reopened.LogRecords() != 2)) {
+            failure = "a rejected batch was logged";
+        }
+    }
+
+    cerr.rdbuf(previousErr);
+    filesystem::remove_all(directory);
+    return failure;
+}
+
+// Concurrent edits to a journaled tenant publish in sequence order, and the
+// incrementally published snapshot and version match the journal's catalog.
+// File loads into the tenant are refused, and an unload is never undone by an
+// edit racing it
+string checkJournaledHost(const GeneratedCatalog& catalog, BinarySearchTree&) {
+    mt19937 rng(static_cast<unsigned int>(catalog.size()) * 32452843u);
+    filesystem::path directory = filesystem::temp_directory_path() / ("journaled_host_" + to_string(rng()));
+    filesystem::remove_all(directory);
+
+    ostringstream discarded;
+    streambuf* previousErr = cerr.rdbuf(discarded.rdbuf());
+    string failure;
+    CatalogHost host;
+    if (!host.OpenJournal("live", directory.string())) failure = "journal failed to open";
+
+    // Each writer edits its own courses, so the expected catalog is the
+    // union of what every writer last wrote
+    const size_t threadCount = 3;
+    vector<map<string, Course>> written(threadCount);
+    if (failure.empty()) {
+        vector<thread> writers;
+        for (size_t t = 0; t < threadCount; ++t) {
+            unsigned int writerSeed = static_cast<unsigned int>(rng());
+            writers.emplace_back([&catalog, &host, &written, t, writerSeed]() {
+                mt19937 writerRng(writerSeed);
+                map<string, Course>& state = written[t];
+                for (int call = 0; call < 6; ++call) {
+                    vector<CourseMutation> edits;
+                    map<string, Course> next = state;
+                    for (size_t n = 1 + writerRng() % 3; n > 0; --n) {
+                        size_t index = writerRng() % catalog.size();
+                        if (index % threadCount != t) continue;
+                        const GeneratedCourse& generated = catalog[index];
+                        if (next.count(generated.courseId) && writerRng() % 3 == 0) {
+                            edits.push_back(CourseMutation::Remove(generated.courseId));
+                            next.erase(generated.courseId);
+                        }
+                        else {
+                            Course course(generated.courseId, generated.courseTitle + " " + to_string(call));
+                            for (size_t prereq : generated.prereqs) course.prereqs.push_back(catalog[prereq].courseId);
+                            edits.push_back(CourseMutation::Upsert(course));
+                            next[course.courseId] = course;
+                        }
+                    }
+                    host.ApplyEdits("live", edits);
+                    state = next;
+                }
+            });
+        }
+        for (auto& writer : writers) writer.join();
+    }
+
+    map<string, Course> expected;
+    for (const auto& state : written) expected.insert(state.begin(), state.end());
+    shared_ptr<const BinarySearchTree> published = host.GetCatalog("live");
+    shared_ptr<const CatalogHistory> history = host.GetHistory("live");
+    if (failure.empty() && (!published || !history)) failure = "the journaled tenant is not hosted";
+    if (failure.empty()) failure = compareCatalog(*published, expected);
+    if (failure.empty()) failure = compareCatalog(*history->Materialize(), expected);
+
+    // Snapshots stay in course ID order, and versions in sequence order
+    string previousId;
+    if (failure.empty()) {
+        published->ForEachRecord([&](const shared_ptr<const Course>& record) {
+            if (!previousId.empty() && record->courseId <= previousId) failure = "snapshot is out of order";
+            previousId = record->courseId;
+        });
+    }
+    for (size_t v = 2; failure.empty() && v < history->VersionCount(); ++v) {
+        if (stoull(history->VersionLabel(v).substr(5)) <= stoull(history->VersionLabel(v - 1).substr(5))) {
+            failure = "version " + to_string(v) + " was committed out of sequence";
+        }
+    }
+
+    // A file load cannot replace the journal's catalog
+    if (failure.empty()) {
+        istringstream input("ZZZ999,Loaded\n");
+        if (host.LoadCatalog("live", input) || host.GetCatalog("live") != published) {
+            failure = "a file load replaced a journaled catalog";
+        }
+    }
+
+    // An unload racing an edit leaves the tenant unloaded
+    if (failure.empty()) {
+        atomic<bool> unloaded(false);
+        thread writer([&host, &unloaded, &catalog]() {
+            for (size_t i = 0; !unloaded.load(); i = (i + 1) % catalog.size()) {
+                try {
+                    host.ApplyEdits("live", { CourseMutation::Upsert(Course(catalog[i].courseId, "Racing")) });
+                }
+                catch (const invalid_argument&) {
+                }
+            }
+            try {
+                host.ApplyEdits("live", { CourseMutation::Upsert(Course(catalog[0].courseId, "Late")) });
+            }
+            catch (const invalid_argument&) {
+            }
+        });
+        this_thread::sleep_for(chrono::milliseconds(1));
+        host.UnloadCatalog("live");
+        unloaded = true;
+        writer.join();
+        if (host.GetCatalog("live") || host.GetHistory("live")) {
+            failure = "an edit brought an unloaded tenant back";
+        }
+    }
+
+    cerr.rdbuf(previousErr);
+    filesystem::remove_all(directory);
+    return failure;
+}
+
+// The diff of two catalogs lists exactly the added, removed and changed
+// courses, applying it to the old catalog yields the new one, and the cycles
+// it reports are real and complete
+string checkCatalogDiff(const GeneratedCatalog& catalog, BinarySearchTree& bst) {
+    mt19937 rng(static_cast<unsigned int>(catalog.size()) * 2654435761u);
+    map<string, Course> after;
+    bst.ForEachRecord([&after](const shared_ptr<const Course>& record) { after[record->courseId] = *record; });
+    map<string, Course> before = after;
+
+    size_t edits = 1 + rng() % 6;
+    for (size_t n = 0; n < edits; ++n) {
+        auto it = after.begin();
+        advance(it, rng() % after.size());
+        switch (rng() % 5) {
+        case 0:
+            if (after.size() > 1) after.erase(it);
+            break;
+        case 1:
+            it->second.courseTitle = CourseTitle(it->second.courseTitle.str() + " (Revised)");
+            break;
+        case 2: {  // May close a cycle
+            auto target = after.begin();
+            advance(target, rng() % after.size());
+            it->second.prereqs.push_back(target->first);
+            break;
+        }
+        case 3:
+            if (!it->second.prereqs.empty()) it->second.prereqs.erase(it->second.prereqs.begin());
+            break;
+        default: {
+            Course added("NEW" + to_string(100 + n), "Added Course");
+            added.prereqs.push_back(it->first);
+            after[added.courseId] = added;
+            break;
+        }
+        }
+    }
+
+    ostringstream text;
+    for (const auto& pair : after) {
+        text << pair.first << "," << pair.second.courseTitle;
+        for (const auto& prereq : pair.second.prereqs) text << "," << prereq;
+        text << "\n";
+    }
+    BinarySearchTree updated;
+    if (!loadCatalog(text.str(), &updated)) return "updated catalog failed to load";
+
+    CatalogChangeset changeset = diffCatalogs(bst, updated);
+    size_t expectedAdded = 0, expectedRemoved = 0, expectedChanged = 0;
+    for (const auto& pair : after) {
+        auto old = before.find(pair.first);
+        if (old == before.end()) expectedAdded++;
+        else if (!(old->second == pair.second)) expectedChanged++;
+    }
+    for (const auto& pair : before) {
+        if (!after.count(pair.first)) expectedRemoved++;
+    }
+    if (changeset.added.size() != expectedAdded || changeset.removed.size() != expectedRemoved ||
+        changeset.changed.size() != expectedChanged) {
+        return "changeset has " + to_string(changeset.added.size()) + " added, " +
+            to_string(changeset.removed.size()) + " removed, " + to_string(changeset.changed.size()) + " changed";
+    }
+
+    // Applying the changeset to the old catalog gives the new one
+    CatalogHistory history;
+    history.CommitCatalog("before", bst);
+    size_t version = changeset.CommitTo(history, "after");
+    vector<const Course*> courses = history.GetCourses(version);
+    if (courses.size() != after.size()) return "applied changeset has " + to_string(courses.size()) + " courses";
+    for (const Course* course : courses) {
+        auto expected = after.find(course->courseId);
+        if (expected == after.end() || !(expected->second == *course)) {
+            return "applied changeset differs at " + course->courseId;
+        }
+    }
+
+    // The old catalog is acyclic, so every cycle in the new one is new
+    unordered_set<string> reported;
+    for (const auto& cycle : changeset.newCycles) {
+        for (const auto& courseId : cycle) {
+            reported.insert(courseId);
+            if (!updated.HasPrerequisiteCycle(courseId)) return courseId + " was reported on a cycle";
+        }
+    }
+    for (const auto& pair : after) {
+        // Reference: a course is on a cycle when it can reach itself
+        unordered_set<string> reached;
+        vector<string> pending(pair.second.prereqs.begin(), pair.second.prereqs.end());
+        while (!pending.empty()) {
+            string current = pending.back();
+            pending.pop_back();
+            auto course = after.find(current);
+            if (course == after.end() || !reached.insert(current).second) continue;
+            pending.insert(pending.end(), course->second.prereqs.begin(), course->second.prereqs.end());
+        }
+        if (reached.count(pair.first) != reported.count(pair.first)) {
+            return pair.first + (reported.count(pair.first) ? " is not on a cycle" : " is on a cycle that was not reported");
+        }
+    }
+    return "";
+}
+
+// Tracing records each load phase once, one Insert per course inside the
+// load span, and queries from other threads under their own thread IDs; the
+// Chrome trace holds one event per recorded span. Spans copied while their
+// buffer wraps are never torn between two writes
+string checkTracing(const GeneratedCatalog& catalog, BinarySearchTree&) {
+    mt19937 rng(static_cast<unsigned int>(catalog.size()));
+    string text = renderCatalog(catalog, rng);
+
+    Tracer& tracer = Tracer::Instance();
+    tracer.Clear();
+    Tracer::Enable();
+    BinarySearchTree traced;
+    bool loaded = loadCatalog(text, &traced);
+    vector<thread> readers;
+    for (int t = 0; t < 2; ++t) {
+        readers.emplace_back([&catalog, &traced]() {
+            for (const auto& course : catalog) traced.HasPrerequisiteCycle(course.courseId);
+        });
+    }
+    for (auto& reader : readers) reader.join();
+    Tracer::Disable();
+    if (!loaded) return "catalog failed to load with tracing on";
+
+    vector<TraceRecord> records = tracer.Snapshot();
+    map<string, size_t> counts;
+    set<uint32_t> queryThreads;
+    const TraceRecord* load = nullptr;
+    for (const auto& record : records) {
+        counts[record.name]++;
+        if (string(record.name) == "Load catalog") load = &record;
+        if (string(record.name) == "HasPrerequisiteCycle") queryThreads.insert(record.threadId);
+    }
+    if (!load || counts["Load catalog"] != 1) return "load span missing or repeated";
+    if (counts["BuildDependencyGraph"] != 1 || counts["ValidateAllPrerequisites"] != 1 || counts["Freeze"] != 1) {
+        return "load phase span missing or repeated";
+    }
+    if (counts["Insert"] != catalog.size()) return to_string(counts["Insert"]) + " Insert spans recorded";
+    if (counts["Tokenize"] != catalog.size()) return to_string(counts["Tokenize"]) + " Tokenize spans recorded";
+    if (counts["Read block"] != 1) return "the catalog was not read as one block";
+    if (counts["HasPrerequisiteCycle"] != 2 * catalog.size()) return "query spans were not all recorded";
+    if (queryThreads.size() != 2 || queryThreads.count(load->threadId)) return "query threads share a thread ID";
+
+    for (const auto& record : records) {
+        if (string(record.category) == "load" && (record.startNanos < load->startNanos ||
+            record.startNanos + record.durationNanos > load->startNanos + load->durationNanos)) {
+            return string(record.name) + " span lies outside the load span";
+        }
+    }
+
+    ostringstream output;
+    tracer.WriteChromeTrace(output);
+    const string json = output.str();
+    const string event = "\"ph\":\"X\"";
+    size_t events = 0;
+    for (size_t position = json.find(event); position != string::npos; position = json.find(event, position + 1)) {
+        events++;
+    }
+    if (events != records.size()) return "trace JSON holds " + to_string(events) + " of " + to_string(records.size()) + " spans";
+
+    // Every field of span n is derived from n, so a torn copy shows
+    TraceBuffer buffer;
+    atomic<bool> writing{ true };
+    thread writer([&buffer, &writing]() {
+        for (uint64_t n = 1; n <= 3 * TraceBuffer::capacity; ++n) {
+            buffer.Record("Wrap", "query", static_cast<uint32_t>(n), n, 3 * n);
+        }
+        writing = false;
+    });
+    string torn;
+    while (writing.load() && torn.empty()) {
+        vector<TraceRecord> copied;
+        buffer.CopyTo(copied);
+        for (size_t i = 0; i < copied.size() && torn.empty(); ++i) {
+            if (copied[i].threadId != copied[i].startNanos || copied[i].durationNanos != 2 * copied[i].startNanos) {
+                torn = "a span copied during a wrap mixes two writes";
+            }
+            else if (i > 0 && copied[i].startNanos <= copied[i - 1].startNanos) {
+                torn = "spans copied during a wrap are out of order";
+            }
+        }
+    }
+    writer.join();
+    return torn;
+}
+
+// Loads catalog text cut into blocks of the given size, so that any text
+// longer than one block goes through the import pipeline
+bool loadCatalogInBlocks(const string& text, BinarySearchTree* bst, size_t blockBytes) {
+    ostringstream discarded;
+    streambuf* previousOut = cout.rdbuf(discarded.rdbuf());
+    streambuf* previousErr = cerr.rdbuf(discarded.rdbuf());
+    istringstream input(text);
+    bool loaded = loadDataStructure(input, bst, blockBytes);
+    cout.rdbuf(previousOut);
+    cerr.rdbuf(previousErr);
+    return loaded;
+}
+
+// Every record of a catalog in course ID order, as ID, title and prerequisites
+vector<string> catalogRecords(const BinarySearchTree& bst) {
+    vector<string> records;
+    bst.ForEachRecord([&records](const shared_ptr<const Course>& record) {
+        string text = record->courseId + "," + record->courseTitle.str();
+        for (const auto& prereq : record->prereqs) text += "," + prereq;
+        records.push_back(text);
+    });
+    return records;
+}
+
+// The import pipeline loads exactly what the single-block loader does for
+// any block size, including blocks shorter than a line; an invalid course ID
+// fails both loads and keeps the same courses before it
+string checkPipelinedLoader(const GeneratedCatalog& catalog, BinarySearchTree&) {
+    mt19937 rng(static_cast<unsigned int>(catalog.size()) * 7919);
+    string text = renderCatalog(catalog, rng);
+    if (rng() % 2) text.pop_back();             // Last line without a newline
+    if (rng() % 2) text.insert(0, "\n\n");      // Blank lines are skipped
+
+    for (int pass = 0; pass < 2; ++pass) {
+        if (pass == 1) {
+            // An invalid ID at the start of a random line
+            size_t lineStart = text.find('\n', rng() % text.size());
+            text.insert(lineStart == string::npos ? 0 : lineStart + 1, "1BAD101,Invalid Course\n");
+        }
+
+        BinarySearchTree single;
+        BinarySearchTree pipelined;
+        bool singleLoaded = loadCatalog(text, &single);
+        bool pipelinedLoaded = loadCatalogInBlocks(text, &pipelined, 1 + rng() % 64);
+        if (singleLoaded != pipelinedLoaded) return "pipelined load result differs (pass " + to_string(pass) + ")";
+        if (singleLoaded == (pass == 1)) return "invalid course ID was not rejected";
+        if (pipelined.Size() != single.Size()) {
+            return "pipelined load holds " + to_string(pipelined.Size()) + " courses, expected " + to_string(single.Size());
+        }
+        if (catalogRecords(pipelined) != catalogRecords(single)) return "pipelined records differ (pass " + to_string(pass) + ")";
+        if (pipelined.IsFrozen() != single.IsFrozen()) return "pipelined catalog frozen state differs";
+    }
+    return "";
+}
+
+// A catalog loaded from a file matches the same text loaded from a stream for
+// any block size; its titles point into the mapped file, which stays
+// readable after the file is deleted and is not counted as heap memory.
+// Records interned in a shared pool own their titles instead
+string checkMappedTitles(const GeneratedCatalog& catalog, BinarySearchTree& bst) {
+    mt19937 rng(static_cast<unsigned int>(catalog.size()) * 104729u);
+    string text = renderCatalog(catalog, rng);
+    filesystem::path path = filesystem::temp_directory_path() / ("titles_property_" + to_string(rng()) + ".csv");
+    {
+        ofstream file(path, ios::binary);
+        file << text;
+    }
+
+    BinarySearchTree mapped;
+    BinarySearchTree pooled(make_shared<CourseRecordPool>());
+    ostringstream discarded;
+    streambuf* previousErr = cerr.rdbuf(discarded.rdbuf());
+    bool loaded = loadDataStructure(path.string(), &mapped, 1 + rng() % 256);
+    bool pooledLoaded = loadDataStructure(path.string(), &pooled, 1 + rng() % 256);
+    cerr.rdbuf(previousErr);
+    filesystem::remove(path);
+    if (!loaded || !pooledLoaded) return "mapped catalog failed to load";
+    if (catalogRecords(mapped) != catalogRecords(bst)) return "mapped records differ from the stream load";
+    if (catalogRecords(pooled) != catalogRecords(bst)) return "pooled records differ from the stream load";
+
+    bool anyPooledMapped = false;
+    pooled.ForEachRecord([&anyPooledMapped](const shared_ptr<const Course>& record) {
+        const SourceText* source = record->courseTitle.owner();
+        anyPooledMapped = anyPooledMapped || (source && source->IsMapped());
+    });
+    if (anyPooledMapped) return "a pooled record's title points into the mapped file";
+
+#ifndef _WIN32
+    bool allMapped = true;
+    mapped.ForEachRecord([&allMapped](const shared_ptr<const Course>& record) {
+        const SourceText* source = record->courseTitle.owner();
+        allMapped = allMapped && source && source->IsMapped();
+    });
+    if (!allMapped) return "a title was copied out of the mapped file";
+
+    vector<MemoryUsage> usage = mapped.GetMemoryUsage();
+    if (!catalog.empty() && (usage[7].objects != 1 || usage[7].bytes != 0)) {
+        return "mapped source counted as " + to_string(usage[7].objects) + " sources, " + to_string(usage[7].bytes) + " bytes";
+    }
+#endif
+
+    // Stream-loaded titles share their block's buffer rather than owning one
+    size_t titles = 0;
+    bst.ForEachRecord([&titles](const shared_ptr<const Course>& record) {
+        if (!record->courseTitle.empty()) titles++;
+    });
+    if (titles > 1 && bst.GetMemoryUsage()[7].objects >= titles) return "stream titles were not shared";
+    return "";
+}
+
+// Compresses catalog text in a format this build can read; empty when the
+// build has no decoder for it
+string compressCatalog(const string& text, CatalogCompression compression) {
+#ifdef ENHANCEMENT_TWO_GZIP
+    if (compression == CatalogCompression::Gzip) {
+        z_stream stream{};
+        deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+        string compressed(deflateBound(&stream, static_cast<uLong>(text.size())), '\0');
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(text.data()));
+        stream.avail_in = static_cast<uInt>(text.size());
+        stream.next_out = reinterpret_cast<Bytef*>(&compressed[0]);
+        stream.avail_out = static_cast<uInt>(compressed.size());
+        deflate(&stream, Z_FINISH);
+        compressed.resize(stream.total_out);
+        deflateEnd(&stream);
+        return compressed;
+    }
+#endif
+#ifdef ENHANCEMENT_TWO_ZSTD
+    if (compression == CatalogCompression::Zstd) {
+        string compressed(ZSTD_compressBound(text.size()), '\0');
+        compressed.resize(ZSTD_compress(&compressed[0], compressed.size(), text.data(), text.size(), 3));
+        return compressed;
+    }
+#endif
+    (void)text;
+    (void)compression;
+    return string();
+}
+
+// Compressed catalogs load exactly like their plain text from a stream or a
+// file, for any block size; truncated input and formats this build cannot
+// decode are rejected
+string checkCompressedInput(const GeneratedCatalog& catalog, BinarySearchTree& bst) {
+    mt19937 rng(static_cast<unsigned int>(catalog.size()) * 2246822519u);
+    string text = renderCatalog(catalog, rng);
+    ostringstream discarded;
+    streambuf* previousOut = cout.rdbuf(discarded.rdbuf());
+    streambuf* previousErr = cerr.rdbuf(discarded.rdbuf());
+    string failure;
+
+    for (CatalogCompression compression : { CatalogCompression::Gzip, CatalogCompression::Zstd }) {
+        string compressed = compressCatalog(text, compression);
+        string name = compressionName(compression);
+        if (compressed.empty()) {
+            // Without a decoder, the magic bytes alone reject the input
+            istringstream input(compression == CatalogCompression::Gzip ? string("\x1f\x8b\x08\x00", 4) :
+                string("\x28\xb5\x2f\xfd", 4));
+            BinarySearchTree rejected;
+            if (loadDataStructure(input, &rejected) || rejected.Size() != 0) failure = name + " input was not rejected";
+            continue;
+        }
+
+        BinarySearchTree streamed;
+        istringstream input(compressed);
+        if (!loadDataStructure(input, &streamed, 1 + rng() % 256)) failure = name + " stream failed to load";
+        else if (catalogRecords(streamed) != catalogRecords(bst)) failure = name + " stream records differ";
+
+        filesystem::path path = filesystem::temp_directory_path() / ("compressed_property_" + to_string(rng()));
+        {
+            ofstream file(path, ios::binary);
+            file << compressed;
+        }
+        BinarySearchTree fromFile;
+        if (!loadDataStructure(path.string(), &fromFile, 1 + rng() % 256)) failure = name + " file failed to load";
+        else if (catalogRecords(fromFile) != catalogRecords(bst)) failure = name + " file records differ";
+        filesystem::remove(path);
+
+        istringstream truncated(compressed.substr(0, compressed.size() - 1 - rng() % min<size_t>(compressed.size() - 4, 8)));
+        BinarySearchTree partial;
+        if (loadDataStructure(truncated, &partial, 1 + rng() % 256)) failure = name + " truncated input was accepted";
+        if (!failure.empty()) break;
+    }
+
+    cout.rdbuf(previousOut);
+    cerr.rdbuf(previousErr);
+    return failure;
+}
+
+// A catalog split across files in a directory, with prerequisites crossing
+// files, imports to the same records by directory or wildcard; hidden files
+// and subdirectories are skipped, and a bad file fails the import and is the
+// only file reporting an error
+string checkMultiFileImport(const GeneratedCatalog& catalog, BinarySearchTree& bst) {
+    mt19937 rng(static_cast<unsigned int>(catalog.size()) * 40503u);
+    filesystem::path directory = filesystem::temp_directory_path() / ("import_property_" + to_string(rng()));
+    filesystem::remove_all(directory);
+    filesystem::create_directories(directory / "nested");
+
+    size_t fileCount = 1 + rng() % 6;
+    vector<ostringstream> parts(fileCount);
+    for (const auto& course : catalog) {
+        ostringstream& part = parts[rng() % fileCount];
+        part << course.courseId << "," << course.courseTitle;
+        for (size_t prereq : course.prereqs) part << "," << catalog[prereq].courseId;
+        part << "\n";
+    }
+    for (size_t i = 0; i < fileCount; ++i) {
+        ofstream file(directory / ("dept" + to_string(i) + ".csv"), ios::binary);
+        file << parts[i].str();
+    }
+    {
+        ofstream hidden(directory / ".hidden.csv");
+        hidden << "not a course\n";
+        ofstream nested(directory / "nested" / "dept.csv");
+        nested << "not a course\n";
+    }
+
+    ostringstream discarded;
+    streambuf* previousOut = cout.rdbuf(discarded.rdbuf());
+    streambuf* previousErr = cerr.rdbuf(discarded.rdbuf());
+    string failure;
+    for (const string& pattern : vector<string>{ directory.string(), (directory / "dept*.c?v").string() }) {
+        vector<string> paths = expandCatalogPaths(pattern);
+        if (paths.size() != fileCount) {
+            failure = pattern + " matched " + to_string(paths.size()) + " files";
+            break;
+        }
+        BinarySearchTree imported;
+        vector<CatalogFileResult> results;
+        if (!loadCatalogFiles(paths, &imported, results, 1 + rng() % 128)) failure = "import of " + pattern + " failed";
+        else if (catalogRecords(imported) != catalogRecords(bst)) failure = "imported records differ";
+        else if (!imported.ValidateAllPrerequisites()) failure = "cross-file prerequisites were not resolved";
+        size_t courses = 0;
+        for (const auto& result : results) courses += result.courses;
+        if (failure.empty() && courses != catalog.size()) failure = "results count " + to_string(courses) + " courses";
+        if (!failure.empty()) break;
+    }
+
+    if (failure.empty()) {
+        size_t bad = rng() % fileCount;
+        ofstream file(directory / ("dept" + to_string(bad) + ".csv"), ios::binary | ios::app);
+        file << "1BAD101,Invalid Course\n";
+        file.close();
+
+        BinarySearchTree imported;
+        vector<CatalogFileResult> results;
+        if (loadCatalogFiles(expandCatalogPaths(directory.string()), &imported, results)) {
+            failure = "import with an invalid course ID succeeded";
+        }
+        for (size_t i = 0; failure.empty() && i < results.size(); ++i) {
+            if (results[i].error.empty() == (i == bad)) failure = "file " + to_string(i) + " reported the wrong status";
+        }
+    }
+
+    cout.rdbuf(previousOut);
+    cerr.rdbuf(previousErr);
+    filesystem::remove_all(directory);
+    return failure;
+}
+
+// Reference wildcard match by plain recursion: * tries every split
+bool referenceWildcard(const string& name, size_t n, const string& pattern, size_t p) {
+    if (p == pattern.size()) return n == name.size();
+    if (pattern[p] == '*') {
+        for (size_t k = n; k <= name.size(); ++k) {
+            if (referenceWildcard(name, k, pattern, p + 1)) return true;
+        }
+        return false;
+    }
+    return n < name.size() && (pattern[p] == '?' || pattern[p] == name[n]) && referenceWildcard(name, n + 1, pattern, p + 1);
+}
+
+// Wildcards match like shell patterns on a single name
+string checkWildcardMatching(mt19937& rng) {
+    static const string alphabet = "ab.";
+    for (int n = 0; n < 300; ++n) {
+        string name;
+        string pattern;
+        for (size_t i = rng() % 8; i > 0; --i) name += alphabet[rng() % alphabet.size()];
+        for (size_t i = rng() % 6; i > 0; --i) pattern += (alphabet + "*?")[rng() % (alphabet.size() + 2)];
+
+        if (matchesWildcard(name, pattern) != referenceWildcard(name, 0, pattern, 0)) {
+            return "'" + name + "' against '" + pattern + "'";
+        }
+    }
+    return "";
+}
+
+// A load builds the reverse edges with its prerequisite graph. A catalog
+// without a graph leaves them to the first queries to need them, which build
+// them once even when several ask at once. Either way every course's
+// dependents are exactly the courses that list it as a prerequisite
+string checkLazyDependents(const GeneratedCatalog& catalog, BinarySearchTree& bst) {
+    if (!catalog.empty() && !bst.HasDependentIndex()) return "the load did not build the dependents with its graph";
+
+    BinarySearchTree walked;
+    bst.ForEachRecord([&walked](const shared_ptr<const Course>& record) { walked.Insert(record); });
+    walked.BuildDependencyGraph();
+    if (walked.HasDependentIndex()) return "dependents were built before a query asked";
+    if (walked.GetMemoryUsage()[5].objects != 0) return "unbuilt dependents were counted";
+
+    vector<vector<const Course*>> found(catalog.size());
+    vector<thread> readers;
+    for (size_t t = 0; t < 3; ++t) {
+        readers.emplace_back([&catalog, &walked, &found, t]() {
+            for (size_t i = t; i < catalog.size(); i += 3) found[i] = walked.GetDependents(catalog[i].courseId);
+        });
+    }
+    for (auto& reader : readers) reader.join();
+    if (!catalog.empty() && !walked.HasDependentIndex()) return "dependents were not built by the query";
+
+    size_t edgeCount = 0;
+    for (size_t i = 0; i < catalog.size(); ++i) {
+        multiset<string> expected;
+        for (const auto& course : catalog) {
+            for (size_t prereq : course.prereqs) {
+                if (prereq == i) expected.insert(course.courseId);
+            }
+        }
+        multiset<string> actual;
+        for (const Course* dependent : found[i]) actual.insert(dependent->courseId);
+        if (actual != expected) return "dependents of " + catalog[i].courseId + " differ from reference";
+        multiset<string> loaded;
+        for (const Course* dependent : bst.GetDependents(catalog[i].courseId)) loaded.insert(dependent->courseId);
+        if (loaded != expected) return "loaded dependents of " + catalog[i].courseId + " differ from reference";
+        edgeCount += expected.size();
+    }
+    if (walked.GetMemoryUsage()[5].objects != edgeCount) return "dependent edges were not all counted";
+    if (bst.GetMemoryUsage()[5].objects != edgeCount) return "the graph's dependent edges were not all counted";
+    return "";
+}
+
+// Insert accepts a course ID exactly when the reference grammar does
+string checkCourseIdValidation(mt19937& rng) {
+    static const string alphabet = "ABCXYZabcz0123456789 -_#\xC3\xA9";
+    for (int n = 0; n < 200; ++n) {
+        string courseId;
+        size_t length = rng() % 24;
+        for (size_t i = 0; i < length; ++i) {
+            // Bias towards letters first and digits afterwards so that valid
+            // IDs are generated often enough to exercise both outcomes
+            if (rng() % 4 != 0) {
+                courseId += (i < 2 + rng() % 3) ? alphabet[rng() % 6] : alphabet[10 + rng() % 10];
+            }
+            else {
+                courseId += alphabet[rng() % alphabet.size()];
+            }
+        }
+
+        BinarySearchTree bst;
+        Course* course = new Course(courseId, "Generated");
+        bool accepted = true;
+        try {
+            bst.Insert(course);
+        }
+        catch (const invalid_argument&) {
+            delete course;
+            accepted = false;
+        }
+
+        if (accepted != referenceValidCourseId(courseId)) {
+            return "course ID \"" + courseId + "\" was " + (accepted ? "accepted" : "rejected") +
+                " contrary to the reference grammar";
+        }
+    }
+    return "";
+}
+
+// Packed keys must order and identify IDs exactly as their strings do, and a
+// catalog mixing packable and over-long IDs must still list and find them all
+string checkPackedKeys(mt19937& rng) {
+    static const string letters = "ABCXYZabcz";
+    set<string> ids;
+    while (ids.size() < 60) {
+        string courseId;
+        size_t letterCount = 2 + rng() % 3;
+        size_t digitCount = 3 + ((rng() % 3 == 0) ? rng() % 14 : rng() % 4);
+        for (size_t i = 0; i < letterCount; ++i) courseId += letters[rng() % letters.size()];
+        for (size_t i = 0; i < digitCount; ++i) courseId += static_cast<char>('0' + rng() % 10);
+        ids.insert(courseId);
+    }
+
+    for (const auto& a : ids) {
+        for (const auto& b : ids) {
+            uint64_t keyA = packCourseId(a);
+            uint64_t keyB = packCourseId(b);
+            if ((keyA == unpackedKey) != (a.size() > packedKeyLength)) {
+                return "course ID \"" + a + "\" was " + (keyA == unpackedKey ? "not packed" : "packed");
+            }
+            if (keyA == unpackedKey || keyB == unpackedKey) continue;
+            if ((keyA < keyB) != (a < b) || (keyA == keyB) != (a == b)) {
+                return "packed keys of " + a + " and " + b + " disagree with string order";
+            }
+        }
+    }
+
+    BinarySearchTree bst;
+    vector<string> shuffled(ids.begin(), ids.end());
+    shuffle(shuffled.begin(), shuffled.end(), rng);
+    for (const auto& courseId : shuffled) bst.Insert(new Course(courseId, "Generated"));
+
+    // The same answers are expected from the pointer tree, the frozen layout
+    // and the tree rebuilt when a course is added after freezing
+    for (int stage = 0; stage < 3; ++stage) {
+        if (stage == 1) bst.Freeze();
+        if (stage == 2) {
+            string added = "AAA100";
+            while (ids.count(added)) added += "0";
+            bst.Insert(new Course(added, "Added"));
+            ids.insert(added);
+        }
+        if (bst.IsFrozen() != (stage == 1)) return "catalog frozen state is wrong at stage " + to_string(stage);
+
+        vector<string> listed;
+        bst.ForEachRecord([&listed](const shared_ptr<const Course>& record) { listed.push_back(record->courseId); });
+        if (listed != vector<string>(ids.begin(), ids.end())) return "mixed-key catalog is not listed in ID order";
+        if (bst.Size() != ids.size()) return "mixed-key catalog reports the wrong size";
+        for (const auto& courseId : ids) {
+            const Course* found = bst.FindCourse(courseId);
+            if (!found || found->courseId != courseId) return "course " + courseId + " not found by key";
+            if (bst.FindInTree(courseId) != found) return "course " + courseId + " not found in ordered index";
+        }
+        for (const char* absent : { "ZZZ999", "ZZZZ99999999999999", "AA000", "" }) {
+            if (bst.FindCourse(absent) || bst.FindInTree(absent)) return "absent course was found";
+        }
+    }
+    return "";
+}
+
+// Course ID lists must behave like vectors through inline storage, spilling,
+// copies and moves
+string checkCourseIdList(mt19937& rng) {
+    CourseIdList list;
+    vector<string> reference;
+    for (int step = 0; step < 200; ++step) {
+        // Long strings make sure element moves and destruction are exercised
+        string item = (rng() % 4 == 0) ? string(40, 'a' + rng() % 26) : "CS" + to_string(rng() % 1000);
+        switch (rng() % 7) {
+        case 0:
+        case 1:
+            list.push_back(item);
+            reference.push_back(item);
+            break;
+        case 2:
+            if (!reference.empty()) {
+                size_t index = rng() % reference.size();
+                list.push_back(list[index]);
+                reference.push_back(reference[index]);
+            }
+            break;
+        case 3:
+            if (!reference.empty()) {
+                size_t first = rng() % reference.size();
+                size_t last = first + rng() % (reference.size() - first + 1);
+                list.erase(list.begin() + first, list.begin() + last);
+                reference.erase(reference.begin() + first, reference.begin() + last);
+            }
+            break;
+        case 4: {
+            CourseIdList copy = list;
+            CourseIdList moved = move(copy);
+            list = moved;
+            if (!copy.empty() && copy.size() > 2) return "moved-from list kept spilled elements";
+            break;
+        }
+        case 5: {
+            CourseIdList moved = move(list);
+            list = move(moved);
+            break;
+        }
+        default:
+            if (rng() % 8 == 0) {
+                list.clear();
+                reference.clear();
+            }
+            list.reserve(rng() % 8);
+            break;
+        }
+
+        if (list.size() != reference.size() || !equal(list.begin(), list.end(), reference.begin())) {
+            return "list differs from vector after step " + to_string(step);
+        }
+        if ((list.heapBytes() == 0) != (list.capacity() <= 2)) return "inline storage reported as heap memory";
+    }
+    return "";
+}
+
+// The radix tree must answer point lookups, ordered listings and prefix
+// scans exactly as an ordered map of the same IDs does
+string checkRadixTree(mt19937& rng) {
+    static const string letters = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+    map<string, shared_ptr<const Course>> reference;
+    CourseRadixTree tree;
+    size_t count = 1 + rng() % 400;
+    for (size_t n = 0; n < count; ++n) {
+        // Few letters and short digit runs give long shared prefixes and
+        // IDs that are prefixes of other IDs
+        string courseId;
+        size_t letterCount = 2 + rng() % 3;
+        for (size_t i = 0; i < letterCount; ++i) courseId += letters[(i == 0) ? rng() % letters.size() : rng() % 3];
+        size_t digitCount = 3 + rng() % 3;
+        for (size_t i = 0; i < digitCount; ++i) courseId += static_cast<char>('0' + rng() % 10);
+
+        auto record = make_shared<const Course>(courseId, "Title " + to_string(n));
+        bool isNew = reference.find(courseId) == reference.end();
+        reference[courseId] = record;
+        if (tree.Insert(record) != isNew) return "insert of " + courseId + " misreported whether it was new";
+    }
+    if (tree.Size() != reference.size()) return "tree size differs from reference";
+
+    for (const auto& pair : reference) {
+        if (tree.Find(pair.first) != pair.second.get()) return "course " + pair.first + " not found";
+        string shorter = pair.first.substr(0, pair.first.size() - 1);
+        if (tree.Find(shorter) != (reference.count(shorter) ? reference[shorter].get() : nullptr)) {
+            return "lookup of " + shorter + " disagrees with reference";
+        }
+        if (tree.Find(pair.first + "0") != (reference.count(pair.first + "0") ? reference[pair.first + "0"].get() : nullptr)) {
+            return "lookup of " + pair.first + "0 disagrees with reference";
+        }
+    }
+
+    vector<string> listed;
+    tree.ForEachRecord([&listed](const shared_ptr<const Course>& record) { listed.push_back(record->courseId); });
+    vector<string> expected;
+    for (const auto& pair : reference) expected.push_back(pair.first);
+    if (listed != expected) return "ordered listing differs from reference";
+
+    for (int scan = 0; scan < 20; ++scan) {
+        auto it = reference.begin();
+        advance(it, rng() % reference.size());
+        string prefix = it->first.substr(0, rng() % (it->first.size() + 2));
+        if (scan % 5 == 4) prefix += 'z';
+
+        vector<string> scanned;
+        tree.ForEachWithPrefix(prefix, [&scanned](const shared_ptr<const Course>& record) {
+            scanned.push_back(record->courseId);
+        });
+        vector<string> matching;
+        for (auto match = reference.lower_bound(prefix);
+            match != reference.end() && match->first.compare(0, prefix.size(), prefix) == 0; ++match) {
+            matching.push_back(match->first);
+        }
+        if (scanned != matching) return "prefix scan of \"" + prefix + "\" differs from reference";
+    }
+    return "";
+}
+
+// Latency percentiles merged from several threads match the exact
+// percentiles of the recorded values to within one bucket (1/64 above)
+string checkLatencyHistogram(mt19937& rng) {
+    QueryLatency& latency = QueryLatency::Instance();
+    latency.Reset();
+
+    // Log-uniform latencies from 1 ns to about 17 minutes, recorded as
+    // validation queries by three threads
+    size_t perThread = 1 + rng() % 2000;
+    vector<vector<uint64_t>> recorded(3);
+    for (auto& values : recorded) {
+        for (size_t i = 0; i < perThread; ++i) values.push_back(uint64_t(1) << (rng() % 40) | rng() % 1024);
+    }
+    vector<thread> writers;
+    for (const auto& values : recorded) {
+        writers.emplace_back([&latency, &values]() {
+            for (uint64_t nanos : values) latency.Record(QueryType::Validate, nanos);
+        });
+    }
+    for (auto& writer : writers) writer.join();
+
+    vector<uint64_t> sorted;
+    for (const auto& values : recorded) sorted.insert(sorted.end(), values.begin(), values.end());
+    sort(sorted.begin(), sorted.end());
+
+    LatencySummary summary = latency.Summaries()[static_cast<size_t>(QueryType::Validate)];
+    if (summary.count != sorted.size()) return to_string(summary.count) + " latencies counted of " + to_string(sorted.size());
+    if (summary.maxNanos != sorted.back()) return "maximum latency differs";
+
+    const vector<pair<double, uint64_t>> percentiles = {
+        { 0.5, summary.p50Nanos }, { 0.99, summary.p99Nanos }, { 0.999, summary.p999Nanos }
+    };
+    for (const auto& percentile : percentiles) {
+        size_t rank = max<size_t>(1, static_cast<size_t>(ceil(percentile.first * sorted.size())));
+        uint64_t exact = sorted[rank - 1];
+        if (percentile.second < exact || percentile.second - exact > exact / 64) {
+            return "p" + to_string(percentile.first * 100) + " is " + to_string(percentile.second) +
+                " ns, exact value " + to_string(exact) + " ns";
+        }
+    }
+    return "";
+}
+
+//============================================================================
+// Property runner
+//============================================================================
+
+struct PropertyResult {
+    string name;
+    int casesRun;
+    string failure;   // Empty when every case passed
+    unsigned int failingSeed;
+};
+
+// Runs a property over generated catalogs, stopping at the first failure
+PropertyResult runCatalogProperty(const string& name, int cases, unsigned int baseSeed,
+    const function<GeneratedCatalog(mt19937&)>& generate,
+    const function<string(const GeneratedCatalog&, BinarySearchTree&)>& check) {
+    PropertyResult result = { name, 0, "", 0 };
+    for (int n = 0; n < cases; ++n) {
+        unsigned int seed = baseSeed + n;
+        mt19937 rng(seed);
+        GeneratedCatalog catalog = generate(rng);
+
+        BinarySearchTree bst;
+        result.casesRun++;
+        if (!loadCatalog(renderCatalog(catalog, rng), &bst)) {
+            result.failure = "generated catalog failed to load";
+        }
+        else {
+            try {
+                result.failure = check(catalog, bst);
+            }
+            catch (const exception& e) {
+                result.failure = string("unexpected exception: ") + e.what();
+            }
+        }
+
+        if (!result.failure.empty()) {
+            result.failingSeed = seed;
+            break;
+        }
+    }
+    return result;
+}
+
+// Runs a property that draws its own inputs from a seeded generator,
+// stopping at the first failure
+PropertyResult runProperty(const string& name, int cases, unsigned int baseSeed,
+    const function<string(mt19937&)>& check) {
+    PropertyResult result = { name, 0, "", 0 };
+    for (int n = 0; n < cases; ++n) {
+        unsigned int seed = baseSeed + n;
+        mt19937 rng(seed);
+        result.casesRun++;
+        try {
+            result.failure = check(rng);
+        }
+        catch (const exception& e) {
+            result.failure = string("unexpected exception: ") + e.what();
+        }
+        if (!result.failure.empty()) {
+            result.failingSeed = seed;
+            break;
+        }
+    }
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    int cases = (argc >= 2) ? stoi(argv[1]) : 200;
+    unsigned int baseSeed = (argc >= 3) ? static_cast<unsigned int>(stoul(argv[2])) : 1;
+
+    auto smallDag = [](mt19937& rng) { return generateDag(1 + rng() % 40, rng); };
+    auto smallCyclic = [](mt19937& rng) { return generateCyclicGraph(1 + rng() % 40, rng); };
+
+    vector<PropertyResult> results;
+    results.push_back(runCatalogProperty("Loader round trip", cases, baseSeed, smallCyclic, checkLoaderRoundTrip));
+    results.push_back(runCatalogProperty("Topological order respects every edge", cases, baseSeed, smallDag, checkTopologicalOrders));
+    results.push_back(runCatalogProperty("Cycle detection matches SCC reference (DAG)", cases, baseSeed, smallDag, checkCycleDetection));
+    results.push_back(runCatalogProperty("Cycle detection matches SCC reference (cyclic)", cases, baseSeed, smallCyclic, checkCycleDetection));
+    results.push_back(runCatalogProperty("Memory accounting matches catalog", cases, baseSeed, smallCyclic, checkMemoryAccounting));
+    results.push_back(runCatalogProperty("Missing-ID filter has no false negatives", cases, baseSeed, smallCyclic, checkMissingIdFilter));
+    results.push_back(runCatalogProperty("Graph relabeling preserves traversals (DAG)", cases, baseSeed, smallDag, checkGraphRelabeling));
+    results.push_back(runCatalogProperty("Graph relabeling preserves traversals (cyclic)", cases, baseSeed, smallCyclic, checkGraphRelabeling));
+    results.push_back(runCatalogProperty("Hosted catalogs share identical records", cases, baseSeed, smallDag, checkCatalogSharing));
+    results.push_back(runCatalogProperty("Federated plans resolve through equivalences", cases, baseSeed, smallDag, checkFederatedResolution));
+    results.push_back(runCatalogProperty("Catalog versions answer as of their version", cases, baseSeed, smallDag, checkVersionHistory));
+    results.push_back(runCatalogProperty("Journal recovers every durable edit", cases, baseSeed, smallDag, checkJournalRecovery));
+    results.push_back(runCatalogProperty("Journaled edits publish in sequence", cases, baseSeed, smallDag, checkJournaledHost));
+    results.push_back(runCatalogProperty("Catalog diff is exact and applicable", cases, baseSeed, smallDag, checkCatalogDiff));
+    results.push_back(runCatalogProperty("Trace records load and query spans", cases, baseSeed, smallCyclic, checkTracing));
+    results.push_back(runCatalogProperty("Pipelined loader matches single-block loader", cases, baseSeed, smallCyclic, checkPipelinedLoader));
+    results.push_back(runCatalogProperty("Mapped titles match stream-loaded titles", cases, baseSeed, smallCyclic, checkMappedTitles));
+    results.push_back(runCatalogProperty("Compressed input matches plain text", cases, baseSeed, smallCyclic, checkCompressedInput));
+    results.push_back(runCatalogProperty("Multi-file import matches single load", cases, baseSeed, smallCyclic, checkMultiFileImport));
+    results.push_back(runCatalogProperty("Dependents are built lazily and exactly", cases, baseSeed, smallCyclic, checkLazyDependents));
+
+    results.push_back(runProperty("Course ID validation matches grammar", cases, baseSeed, checkCourseIdValidation));
+    results.push_back(runProperty("Packed keys and frozen layout keep ID order", cases, baseSeed, checkPackedKeys));
+    results.push_back(runProperty("Course ID lists behave like vectors", cases, baseSeed, checkCourseIdList));
+    results.push_back(runProperty("Radix tree matches ordered map", cases, baseSeed, checkRadixTree));
+    results.push_back(runProperty("Latency percentiles within one bucket", cases, baseSeed, checkLatencyHistogram));
+    results.push_back(runProperty("Wildcards match the recursive reference", cases, baseSeed, checkWildcardMatching));
+
+    printSubHeader("Property-Based Tests");
+    bool allPassed = true;
+    for (const auto& result : results) {
+        cout << "    " << setw(48) << left << result.name << " | " << setw(4) << right << result.casesRun
+            << " cases | " << (result.failure.empty() ? "PASSED" : "FAILED") << endl;
+        if (!result.failure.empty()) {
+            cout << "        seed " << result.failingSeed << ": " << result.failure << endl;
+            allPassed = false;
+        }
+    }
+    cout << "\n    Property Suite Status: " << (allPassed ? "PASSED" : "FAILED") << "\n" << endl;
+    return allPassed ? 0 : 1;
+}
@@ -23,6 +23,7 @@
 #include <thread>
 #include <map>
 #include <functional>
+#include <sstream>
 
 using namespace std;
 using namespace std::chrono;
@@ -645,7 +646,7 @@ void BinarySearchTree::printCourseInformation(const Node* node, const string& co
 // Reads course data from a CSV file and populates the BST
 //============================================================================
 
-bool loadDataStructure(const string& filepath, BinarySearchTree* bst) {
+bool loadDataStructure(const string& filepath, BinarySearchTree* bst, bool reportErrors = true) {
     if (!bst) {
         cout << "  Unable to open BST pointer" << endl;
         return false;
@@ -712,6 +713,10 @@ bool loadDataStructure(const string& filepath, BinarySearchTree* bst) {
         }
 
         if (!hasValidCourses) {
+            if (!reportErrors) {
+                inputFile.close();
+                return false;
+            }
             cout << "  No valid courses were loaded" << endl;
             for (const auto& error : errors) {
                 cout << "  Error: " << error << endl;
@@ -723,7 +728,7 @@ bool loadDataStructure(const string& filepath, BinarySearchTree* bst) {
         bst->BuildDependencyGraph();
         inputFile.close();
 
-        if (!errors.empty()) {
+        if (!errors.empty() && reportErrors) {
             cout << "\n  Warning: Some courses had errors but file was loaded:" << endl;
             for (const auto& error : errors) {
                 cout << "  - " << error << endl;
@@ -794,128 +799,353 @@ string BinarySearchTree::getTestCaseType(const string& courseId) const {
 //============================================================================
 
 struct TestResult {
-    string id;          
-    string category;   
-    bool passed;      
-    string message;     
+    string id;
+    string category;
+    bool passed;
+    string message;
+    double durationMicros;   // Wall-clock time spent in the test body
 };
 
 //============================================================================
-// Test Suite Implementation
-// Main test execution and results reporting functionality
+// Test Categories and Performance Budgets
+// Each category runs against its own catalog instance so that categories can
+// execute concurrently without sharing traversal state
 //============================================================================
 
-/**
- * Executes a test suite to validate the course management system.
- * Tests include input validation, prerequisite handling, and various edge cases.
- *
- * Results provide:
- * - Individual test outcomes with detailed messages
- * - Per-category success rates
- * - Overall test suite summary
- *
- * @param bst Pointer to the Binary Search Tree containing course data
- */
+struct TestCategory {
+    string name;
+    function<void(BinarySearchTree*, vector<TestResult>&)> run;
+};
 
-void runAllTests(BinarySearchTree* bst) {
-    printSubHeader("Running Complete Test Suite");
-    vector<TestResult> testResults;
+struct PerformanceBudget {
+    string testId;
+    double maxMicros;
+};
+
+// Latency budgets checked after correctness; a test that returns the right
+// answer but exceeds its budget is still reported as failed
+const vector<PerformanceBudget> performanceBudgets = {
+    { "MAX110", 2000.0 },   // Ten-level prerequisite chain resolution
+    { "CPX106", 1000.0 },   // Diamond-shaped prerequisite resolution
+    { "SELF101", 500.0 }    // Self-reference cycle detection
+};
+
+// Runs a single test body, recording its outcome and how long it took
+void runTimedTest(vector<TestResult>& results, const string& id, const string& category,
+    const function<pair<bool, string>()>& body) {
+    pair<bool, string> outcome;
+    auto start = steady_clock::now();
+    try {
+        outcome = body();
+    }
+    catch (const exception& e) {
+        outcome = { false, string("Unexpected exception: ") + e.what() };
+    }
+    catch (...) {
+        outcome = { false, "Unexpected exception" };
+    }
+    double elapsed = duration<double, micro>(steady_clock::now() - start).count();
+    results.push_back({ id, category, outcome.first, outcome.second, elapsed });
+}
+
+// Adds one test per course ID that passes when the course was loaded
+void addPresenceTests(BinarySearchTree* bst, vector<TestResult>& results,
+    const vector<string>& ids, const string& category,
+    const string& successMessage, const string& failureMessage) {
+    for (const auto& id : ids) {
+        runTimedTest(results, id, category, [&]() -> pair<bool, string> {
+            bool passed = (bst->FindCourse(id) != nullptr);
+            return { passed, passed ? successMessage : failureMessage };
+        });
+    }
+}
+
+// Builds the full list of test categories in the suite
+vector<TestCategory> buildTestCategories() {
+    vector<TestCategory> categories;
 
     // Process Invalid Course IDs
-    vector<string> invalidIds = { "CS1", "TOOLONG123456", "123456", "ABCDEF" };
-    for (const auto& id : invalidIds) {
-        try {
-            auto course = new Course(id, "Test Course");
-            bst->Insert(course);
-            testResults.push_back({ id, "Invalid IDs", false, "Failed to reject invalid ID" });
-            delete course;
+    categories.push_back({ "Invalid IDs", [](BinarySearchTree* bst, vector<TestResult>& results) {
+        vector<string> invalidIds = { "CS1", "TOOLONG123456", "123456", "ABCDEF" };
+        for (const auto& id : invalidIds) {
+            runTimedTest(results, id, "Invalid IDs", [&]() -> pair<bool, string> {
+                auto course = new Course(id, "Test Course");
+                try {
+                    bst->Insert(course);
+                }
+                catch (const invalid_argument&) {
+                    delete course;
+                    return { true, "Successfully rejected invalid ID" };
+                }
+                // The tree owns the course once it has been inserted
+                return { false, "Failed to reject invalid ID" };
+            });
         }
-        catch (const invalid_argument&) {
-            testResults.push_back({ id, "Invalid IDs", true, "Successfully rejected invalid ID" });
+    } });
+
+    // Validate Multiple Prerequisites
+    categories.push_back({ "Multiple Prerequisites", [](BinarySearchTree* bst, vector<TestResult>& results) {
+        vector<string> multPrereqs = { "MULT101", "MULT102", "MULT103" };
+        for (const auto& id : multPrereqs) {
+            runTimedTest(results, id, "Multiple Prerequisites", [&]() -> pair<bool, string> {
+                Course* course = bst->FindCourse(id);
+                bool passed = (course && course->prereqs.size() > 1);  // Check for at least 2 prerequisites
+                return { passed, passed ? "Successfully verified multiple prerequisites" : "Failed to verify prerequisites" };
+            });
+        }
+    } });
+
+    categories.push_back({ "Special Characters", [](BinarySearchTree* bst, vector<TestResult>& results) {
+        addPresenceTests(bst, results, { "SPEC101", "SPEC102", "SPEC103", "SPEC104" }, "Special Characters",
+            "Successfully handled special characters", "Failed to handle special characters");
+    } });
+
+    categories.push_back({ "Case Sensitivity", [](BinarySearchTree* bst, vector<TestResult>& results) {
+        addPresenceTests(bst, results, { "CASE101", "case102", "Case103" }, "Case Sensitivity",
+            "Successfully handled case variation", "Failed to handle case variation");
+    } });
+
+    categories.push_back({ "Whitespace", [](BinarySearchTree* bst, vector<TestResult>& results) {
+        addPresenceTests(bst, results, { "SPACE101", "SPACE102", "SPACE103" }, "Whitespace",
+            "Successfully handled whitespace", "Failed to handle whitespace");
+    } });
+
+    categories.push_back({ "Empty Fields", [](BinarySearchTree* bst, vector<TestResult>& results) {
+        addPresenceTests(bst, results, { "EMPTY101", "EMPTY102" }, "Empty Fields",
+            "Successfully handled empty fields", "Failed to handle empty fields");
+    } });
+
+    categories.push_back({ "Maximum Chain", [](BinarySearchTree* bst, vector<TestResult>& results) {
+        runTimedTest(results, "MAX110", "Maximum Chain", [&]() -> pair<bool, string> {
+            try {
+                vector<Course*> chain = bst->GetPrerequisiteOrder("MAX110");
+                bool passed = (chain.size() >= 9);  // Expecting at least 9 prerequisites
+                return { passed, passed ? "Successfully handled long prerequisite chain" : "Failed to handle long chain" };
+            }
+            catch (...) {
+                return { false, "Failed to process maximum chain" };
+            }
+        });
+    } });
+
+    categories.push_back({ "Duplicate Prerequisites", [](BinarySearchTree* bst, vector<TestResult>& results) {
+        addPresenceTests(bst, results, { "DUP101" }, "Duplicate Prerequisites",
+            "Successfully handled duplicate prerequisites", "Failed to handle duplicates");
+    } });
+
+    categories.push_back({ "Self Reference", [](BinarySearchTree* bst, vector<TestResult>& results) {
+        runTimedTest(results, "SELF101", "Self Reference", [&]() -> pair<bool, string> {
+            bool hasCycle = bst->HasPrerequisiteCycle("SELF101");
+            return { hasCycle, hasCycle ? "Successfully detected self-reference" : "Failed to detect self-reference" };
+        });
+    } });
+
+    categories.push_back({ "Complex Paths", [](BinarySearchTree* bst, vector<TestResult>& results) {
+        runTimedTest(results, "CPX106", "Complex Paths", [&]() -> pair<bool, string> {
+            try {
+                vector<Course*> paths = bst->GetPrerequisiteOrder("CPX106");
+                bool passed = !paths.empty();
+                return { passed, passed ? "Successfully processed complex paths" : "Failed to process complex paths" };
+            }
+            catch (...) {
+                return { false, "Failed to process complex paths" };
+            }
+        });
+    } });
+
+    return categories;
+}
+
+// Fails any test whose duration exceeded its performance budget
+void applyPerformanceBudgets(vector<TestResult>& testResults) {
+    for (auto& result : testResults) {
+        for (const auto& budget : performanceBudgets) {
+            if (result.id == budget.testId && result.passed && result.durationMicros > budget.maxMicros) {
+                ostringstream message;
+                message << fixed << setprecision(1) << "Exceeded performance budget: "
+                    << result.durationMicros << "us > " << budget.maxMicros << "us";
+                result.passed = false;
+                result.message = message.str();
+            }
         }
     }
+}
 
-    // Validate Multiple Prerequisites
-    vector<string> multPrereqs = { "MULT101", "MULT102", "MULT103" };
-    for (const auto& id : multPrereqs) {
-        Course* course = bst->FindCourse(id);
-        bool passed = (course && course->prereqs.size() > 1);  // Check for at least 2 prerequisites
-        testResults.push_back({ id, "Multiple Prerequisites", passed,
-            passed ? "Successfully verified multiple prerequisites" : "Failed to verify prerequisites" });
+//============================================================================
+// Test Reporting
+// Timing table and JUnit-style XML output for automated builds
+//============================================================================
+
+// Escapes text for use inside XML attribute values
+string xmlEscape(const string& text) {
+    string escaped;
+    escaped.reserve(text.size());
+    for (char c : text) {
+        switch (c) {
+        case '&':  escaped += "&amp;";  break;
+        case '<':  escaped += "&lt;";   break;
+        case '>':  escaped += "&gt;";   break;
+        case '"':  escaped += "&quot;"; break;
+        case '\'': escaped += "&apos;"; break;
+        default:   escaped += c;        break;
+        }
     }
+    return escaped;
+}
 
-    vector<string> specCases = { "SPEC101", "SPEC102", "SPEC103", "SPEC104" };
-    for (const auto& id : specCases) {
-        Course* course = bst->FindCourse(id);
-        bool passed = (course != nullptr);
-        testResults.push_back({ id, "Special Characters", passed,
-            passed ? "Successfully handled special characters" : "Failed to handle special characters" });
+// Returns the budget for a test in microseconds, or a negative value if none
+double findPerformanceBudget(const string& testId) {
+    for (const auto& budget : performanceBudgets) {
+        if (budget.testId == testId) return budget.maxMicros;
     }
+    return -1.0;
+}
 
-    vector<string> caseCases = { "CASE101", "case102", "Case103" };
-    for (const auto& id : caseCases) {
-        Course* course = bst->FindCourse(id);
-        bool passed = (course != nullptr);
-        testResults.push_back({ id, "Case Sensitivity", passed,
-            passed ? "Successfully handled case variation" : "Failed to handle case variation" });
+// Prints every test's duration, slowest first, alongside its budget
+void printTimingTable(vector<TestResult> testResults, double suiteMicros) {
+    printSubHeader("Test Timing (slowest first)");
+    sort(testResults.begin(), testResults.end(), [](const TestResult& a, const TestResult& b) {
+        return a.durationMicros > b.durationMicros;
+    });
+
+    cout << "    " << setw(15) << left << "TEST ID"
+        << " | " << setw(24) << left << "CATEGORY"
+        << " | " << setw(12) << right << "TIME (us)"
+        << " | " << setw(12) << right << "BUDGET (us)" << endl;
+    cout << "  " << string(73, '-') << endl;
+
+    for (const auto& test : testResults) {
+        double budget = findPerformanceBudget(test.id);
+        cout << "    " << setw(15) << left << test.id
+            << " | " << setw(24) << left << test.category
+            << " | " << setw(12) << right << fixed << setprecision(1) << test.durationMicros
+            << " | " << setw(12) << right;
+        if (budget >= 0.0) {
+            cout << budget;
+        }
+        else {
+            cout << "-";
+        }
+        cout << endl;
     }
 
-    vector<string> spaceCases = { "SPACE101", "SPACE102", "SPACE103" };
-    for (const auto& id : spaceCases) {
-        Course* course = bst->FindCourse(id);
-        bool passed = (course != nullptr);
-        testResults.push_back({ id, "Whitespace", passed,
-            passed ? "Successfully handled whitespace" : "Failed to handle whitespace" });
+    cout << "\n    Suite wall-clock time: " << fixed << setprecision(1)
+        << suiteMicros << "us" << endl;
+}
+
+// Writes results as JUnit-style XML so CI systems can track them
+bool writeJUnitReport(const string& path, const map<string, vector<TestResult>>& categorizedResults,
+    double suiteMicros) {
+    ofstream report(path);
+    if (!report.is_open()) {
+        return false;
     }
 
-    vector<string> emptyCases = { "EMPTY101", "EMPTY102" };
-    for (const auto& id : emptyCases) {
-        Course* course = bst->FindCourse(id);
-        bool passed = (course != nullptr);
-        testResults.push_back({ id, "Empty Fields", passed,
-            passed ? "Successfully handled empty fields" : "Failed to handle empty fields" });
+    int totalTests = 0;
+    int totalFailures = 0;
+    for (const auto& category : categorizedResults) {
+        for (const auto& test : category.second) {
+            totalTests++;
+            if (!test.passed) totalFailures++;
+        }
     }
 
-    vector<string> maxChain = { "MAX110" };
-    for (const auto& id : maxChain) {
-        try {
-            vector<Course*> chain = bst->GetPrerequisiteOrder(id);
-            bool passed = (chain.size() >= 9);  // Expecting at least 9 prerequisites
-            testResults.push_back({ id, "Maximum Chain", passed,
-                passed ? "Successfully handled long prerequisite chain" : "Failed to handle long chain" });
+    report << fixed << setprecision(6);
+    report << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    report << "<testsuites name=\"EnhancementTwoTest\" tests=\"" << totalTests
+        << "\" failures=\"" << totalFailures
+        << "\" time=\"" << suiteMicros / 1e6 << "\">\n";
+
+    for (const auto& category : categorizedResults) {
+        int failures = 0;
+        double categoryMicros = 0.0;
+        for (const auto& test : category.second) {
+            if (!test.passed) failures++;
+            categoryMicros += test.durationMicros;
         }
-        catch (...) {
-            testResults.push_back({ id, "Maximum Chain", false, "Failed to process maximum chain" });
+
+        report << "  <testsuite name=\"" << xmlEscape(category.first)
+            << "\" tests=\"" << category.second.size()
+            << "\" failures=\"" << failures
+            << "\" time=\"" << categoryMicros / 1e6 << "\">\n";
+
+        for (const auto& test : category.second) {
+            report << "    <testcase classname=\"" << xmlEscape(category.first)
+                << "\" name=\"" << xmlEscape(test.id)
+                << "\" time=\"" << test.durationMicros / 1e6 << "\"";
+            if (test.passed) {
+                report << "/>\n";
+            }
+            else {
+                report << ">\n      <failure message=\"" << xmlEscape(test.message) << "\"/>\n"
+                    << "    </testcase>\n";
+            }
         }
+        report << "  </testsuite>\n";
     }
+    report << "</testsuites>\n";
+    return report.good();
+}
 
-    vector<string> dupCases = { "DUP101" };
-    for (const auto& id : dupCases) {
-        Course* course = bst->FindCourse(id);
-        bool passed = (course != nullptr);
-        testResults.push_back({ id, "Duplicate Prerequisites", passed,
-            passed ? "Successfully handled duplicate prerequisites" : "Failed to handle duplicates" });
+//============================================================================
+// Test Suite Implementation
+// Main test execution and results reporting functionality
+//============================================================================
+
+/**
+ * Executes a test suite to validate the course management system.
+ * Tests include input validation, prerequisite handling, and various edge cases.
+ *
+ * Each category is run on its own thread against an isolated catalog loaded
+ * from the test file, and every test is timed against its performance budget.
+ *
+ * Results provide:
+ * - Individual test outcomes with detailed messages
+ * - Per-category success rates
+ * - Per-test timing, slowest first
+ * - Overall test suite summary
+ * - A JUnit-style XML report written to junitPath
+ *
+ * @param filepath Path of the test case catalog to load for every category
+ * @param junitPath Path of the JUnit-style XML report to write
+ * @return true if every test passed within its budget
+ */
+
+bool runAllTests(const string& filepath, const string& junitPath = "test_results.xml") {
+    printSubHeader("Running Complete Test Suite");
+    vector<TestCategory> categories = buildTestCategories();
+
+    // Load one catalog per category up front so that the flags set by cycle
+    // detection in one category can never be observed by another
+    vector<unique_ptr<BinarySearchTree>> catalogs;
+    for (size_t i = 0; i < categories.size(); ++i) {
+        auto catalog = make_unique<BinarySearchTree>();
+        if (!loadDataStructure(filepath, catalog.get(), false)) {
+            printError("Failed to load test cases file");
+            return false;
+        }
+        catalogs.push_back(move(catalog));
     }
 
-    vector<string> selfRef = { "SELF101" };
-    for (const auto& id : selfRef) {
-        bool hasCycle = bst->HasPrerequisiteCycle(id);
-        testResults.push_back({ id, "Self Reference", hasCycle,
-            hasCycle ? "Successfully detected self-reference" : "Failed to detect self-reference" });
+    // Execute categories concurrently, each writing only to its own results
+    vector<vector<TestResult>> categoryResults(categories.size());
+    vector<thread> workers;
+    auto suiteStart = steady_clock::now();
+    for (size_t i = 0; i < categories.size(); ++i) {
+        workers.emplace_back([&categories, &catalogs, &categoryResults, i]() {
+            categories[i].run(catalogs[i].get(), categoryResults[i]);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
     }
+    double suiteMicros = duration<double, micro>(steady_clock::now() - suiteStart).count();
 
-    vector<string> complexPaths = { "CPX106" };
-    for (const auto& id : complexPaths) {
-        try {
-            vector<Course*> paths = bst->GetPrerequisiteOrder(id);
-            bool passed = !paths.empty();
-            testResults.push_back({ id, "Complex Paths", passed,
-                passed ? "Successfully processed complex paths" : "Failed to process complex paths" });
-        }
-        catch (...) {
-            testResults.push_back({ id, "Complex Paths", false, "Failed to process complex paths" });
-        }
+    vector<TestResult> testResults;
+    for (const auto& results : categoryResults) {
+        testResults.insert(testResults.end(), results.begin(), results.end());
     }
+    applyPerformanceBudgets(testResults);
 
     // Results Processing and Display
     printSubHeader("Test Results By Category");
@@ -960,6 +1190,8 @@ void runAllTests(BinarySearchTree* bst) {
             << categorySuccessRate << "%" << endl;
     }
 
+    printTimingTable(testResults, suiteMicros);
+
     // Summary Generation
     printSubHeader("Test Suite Summary");
     double overallSuccessRate = (totalTests > 0) ?
@@ -992,11 +1224,20 @@ void runAllTests(BinarySearchTree* bst) {
             << "%)" << endl;
     }
 
+    if (writeJUnitReport(junitPath, categorizedResults, suiteMicros)) {
+        cout << "\nJUnit report written to: " << junitPath << endl;
+    }
+    else {
+        printTestWarning("JUnit Report", "Unable to write " + junitPath);
+    }
+
     // Display final test suite status
+    bool suitePassed = (totalTests > 0 && totalPassed == totalTests);
     cout << "\nTest Suite Status: "
-        << (overallSuccessRate == 100.0 ? "PASSED" : "FAILED") << endl;
+        << (suitePassed ? "PASSED" : "FAILED") << endl;
 
     printLine();
+    return suitePassed;
 }
 
 //============================================================================
@@ -1011,6 +1252,11 @@ int main(int argc, char* argv[]) {
     string userCourse;
     int choice = 0;
 
+    // Non-interactive mode for automated builds: --run-tests [file]
+    if (argc >= 2 && string(argv[1]) == "--run-tests") {
+        return runAllTests(argc >= 3 ? argv[2] : "test_cases.txt") ? 0 : 1;
+    }
+
     // Display initial program header
     printLine();
 
@@ -1145,12 +1391,7 @@ int main(int argc, char* argv[]) {
             }
 
             case 6: {  // Run all tests
-                if (loadDataStructure("test_cases.txt", bst.get())) {
-                    runAllTests(bst.get());
-                }
-                else {
-                    printError("Failed to load test cases file");
-                }
+                runAllTests("test_cases.txt");
                 break;
             }
 
@@ -1171,4 +1412,4 @@ int main(int argc, char* argv[]) {
     }
 
     return 0;
-}
\ No newline at end of file
+}
\ No newline at end of file
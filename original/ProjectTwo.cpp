@@ -11,6 +11,7 @@
 #include <vector>
 #include <algorithm>
 #include <string>
+#include <utility>
 
 using namespace std;
 
@@ -56,10 +57,12 @@ struct Node {
 		right = nullptr;
 	}
 
-	// Initializing the node with a course
-	Node(Course aCourse) : Node() {
+	// Initializing the node with a course, taking
+	// ownership of its strings instead of copying them
+	Node(Course aCourse) : course(move(aCourse)) {
 
-		this->course = aCourse;
+		left = nullptr;
+		right = nullptr;
 	}
 
 };
@@ -80,9 +83,9 @@ class BinarySearchTree {
 private:
 		
 	Node* root;
-	void addNode(Node* node, Course course);
+	void addNode(Node* node, Course&& course);
 	void printSampleSchedule(Node* node); 
-	void printCourseInformation(Node* node, string courseId);
+	void printCourseInformation(Node* node, const string& courseId);
 
 // Defining the public class attributes and methods
 public:
@@ -91,8 +94,8 @@ public:
 	virtual ~BinarySearchTree();
 	void Insert(Course course); 
 	void PrintSampleSchedule();
-	int NumPrerequisiteCourses(Course course);
-	void PrintCourseInformation(string courseId); 
+	int NumPrerequisiteCourses(const Course& course);
+	void PrintCourseInformation(const string& courseId); 
 };
 
 /*
@@ -121,7 +124,9 @@ BinarySearchTree::~BinarySearchTree() {
 /*
  * Now we define the Insert function,
  * which is how we will insert a
- * course node in the tree.
+ * course node in the tree. The course
+ * is taken by value so callers can move
+ * it in, and it is moved from here on.
  */
 
 void BinarySearchTree::Insert(Course course) {
@@ -130,14 +135,14 @@ void BinarySearchTree::Insert(Course course) {
 	if (root == nullptr) {
 
 		// Set root equal to new node course
-		root = new Node(course);
+		root = new Node(move(course));
 	}
 
 	// Else, we call addNode method
 	else {
 
 		// Calling addNode method to insert the course
-		addNode(root, course);
+		addNode(root, move(course));
 	}
 }
 
@@ -148,7 +153,7 @@ void BinarySearchTree::Insert(Course course) {
  * add a course node into the tree.
  */
 
-void BinarySearchTree::addNode(Node* node, Course course) {
+void BinarySearchTree::addNode(Node* node, Course&& course) {
 
 	// If the course Id is less than the node's course Id, 
 	// we will add to the left
@@ -159,14 +164,14 @@ void BinarySearchTree::addNode(Node* node, Course course) {
 		if (node->left == nullptr) {
 
 			// This node becomes the left
-			node->left = new Node { course };
+			node->left = new Node(move(course));
 		}
 
 		// Else, we will recurse down the left node
 		else {
 
 			// Recursive call in order to traverse left
-			addNode(node->left, course);
+			addNode(node->left, move(course));
 		}
 	}
 
@@ -178,14 +183,14 @@ void BinarySearchTree::addNode(Node* node, Course course) {
 		if (node->right == nullptr) {
 
 			// This node becomes the right
-			node->right = new Node { course };
+			node->right = new Node(move(course));
 		}
 
 		// Else, we will recurse down the left node
 		else {
 
 			// Recursive call in order to traverse right
-			addNode(node->right, course);
+			addNode(node->right, move(course));
 		}
 	}
 }
@@ -229,7 +234,7 @@ void BinarySearchTree::printSampleSchedule(Node* node) {
  * return the number as an integer value.
  */
 
-int BinarySearchTree::NumPrerequisiteCourses(Course course) {
+int BinarySearchTree::NumPrerequisiteCourses(const Course& course) {
 
 	// We will initialize a counter variable for the loop
 	// which will be returned for the number of prerequisites
@@ -257,7 +262,7 @@ int BinarySearchTree::NumPrerequisiteCourses(Course course) {
  * the required prerequisites.
  */
 
-void BinarySearchTree::PrintCourseInformation(string courseId) {
+void BinarySearchTree::PrintCourseInformation(const string& courseId) {
 
 	// Calling helper function printSampleSchedule and pass the root and courseId 
 	printCourseInformation(root, courseId);
@@ -269,7 +274,7 @@ void BinarySearchTree::PrintCourseInformation(string courseId) {
  * including the required prerequisites.
  */
 
-void BinarySearchTree::printCourseInformation(Node* current, string courseId) {
+void BinarySearchTree::printCourseInformation(Node* current, const string& courseId) {
 
 	// We need to create a loop to traverse down the tree
 	// until we reach the bottom or a match is found
@@ -355,7 +360,7 @@ void BinarySearchTree::printCourseInformation(Node* current, string courseId) {
  * return a boolean value.
  */
 
-bool loadDataStructure(string filepath, BinarySearchTree * bst) {
+bool loadDataStructure(const string& filepath, BinarySearchTree * bst) {
 
 	// Creating ifstream object to open and
 	// read from the given filepath
@@ -364,47 +369,55 @@ bool loadDataStructure(string filepath, BinarySearchTree * bst) {
 	// If the input file is open a while loop
 	// executes to read the file
 	if (inputFile.is_open()) {
+
+		// Creating a vector to store the courses, declared
+		// outside the loop so its storage is reused per line
+		vector<string> courseList;
+
+		// Initializing a string variable to store the
+		// words from each line of the input file
+		string word;
 		
 		// Loop to read data from each line
 		// until the end of the file
 		while (!inputFile.eof()) {
 			
-			// Creating a vector to store the courses
-			vector<string> courseList;
-			
-			// Initializing a string variable to store the
-			// words from each line of the input file
-			string word;
+			// Emptying the fields left over from the previous line
+			courseList.clear();
 			
 			// Using getline to process each word
 			// from the line in the input file
 			getline(inputFile, word);
+
+			// Here we track where the current field starts
+			// instead of erasing the front of the string
+			size_t start = 0;
 			
-			// While the number of words per line is greater than zero
-			while (word.length() > 0) {
+			// While there are characters left on the line
+			while (start < word.length()) {
 				
 				// Here we create an int variable to store
 				// the number between each comma
-				unsigned int delim = word.find(',');
+				size_t delim = word.find(',', start);
 				
 				// If the field has less than 100 characters
-				if (delim < 100) {
+				if (delim != string::npos && delim - start < 100) {
 
 					// Add the word substring to the vector
-					courseList.push_back(word.substr(0, delim));
+					courseList.emplace_back(word, start, delim - start);
 					
-					// Deleting the word from the string
-					word.erase(0, delim + 1);
+					// Moving past the field and its comma
+					start = delim + 1;
 				}
 
 				// Else, we will add the word after the last comma
 				else {
 					
 					// Add the word substring to the vector
-					courseList.push_back(word.substr(0, word.length()));
+					courseList.emplace_back(word, start, string::npos);
 					
-					// Setting word as an empty string
-					word = "";
+					// Moving to the end of the line
+					start = word.length();
 				}
 			}
 			
@@ -412,25 +425,30 @@ bool loadDataStructure(string filepath, BinarySearchTree * bst) {
 			// to insert the courses into the BST
 			Course course;
 
-			// Setting the course ID as the 
+			// Moving the course ID out of the
 			// first parameter in courseList
-			course.courseId = courseList[0];
+			course.courseId = move(courseList[0]);
 
-			// Setting the course title as the
+			// Moving the course title out of the
 			// second parameter in courseList
-			course.courseTitle = courseList[1];
+			course.courseTitle = move(courseList[1]);
+
+			// Reserving room for every prerequisite at once
+			if (courseList.size() > 2) {
+				course.prereqs.reserve(courseList.size() - 2);
+			}
 			
 			// Loop for the the third parameter which
 			// is the prerequisite, then add to the courseList
 			for (unsigned int i = 2; i < courseList.size(); i++) {
 				
-				// Add the prerequisite to the vector
-				course.prereqs.push_back(courseList[i]);
+				// Move the prerequisite into the vector
+				course.prereqs.push_back(move(courseList[i]));
 			}
 			
-			// Call the insert function to insert the
+			// Call the insert function to move the
 			// course into the tree
-			bst->Insert(course);
+			bst->Insert(move(course));
 		}
 
 		// Closing the input file
@@ -449,6 +467,9 @@ bool loadDataStructure(string filepath, BinarySearchTree * bst) {
 // Main method 
 //==============================================================================//
 
+// Harnesses that compile this file as a library define PROJECT_TWO_NO_MAIN
+#ifndef PROJECT_TWO_NO_MAIN
+
 int main(int argc, char* argv[]) {
 	
 	// Initializing the variables for the main method
@@ -591,4 +612,6 @@ int main(int argc, char* argv[]) {
 
 	// Exit the program
 	return 0;
-}
\ No newline at end of file
+}
+
+#endif // PROJECT_TWO_NO_MAIN
\ No newline at end of file